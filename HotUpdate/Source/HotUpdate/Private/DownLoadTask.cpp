@@ -5,25 +5,19 @@
 #include "FileDownLog.h"
 #include "HttpModule.h"
 #include "Interfaces/IHttpResponse.h"
+#include "HotUpdateTrace.h"
+#include "HotUpdateSettings.h"
+#include "HotUpdateFrameBudget.h"
+#include "HotUpdateStats.h"
+#include "HotUpdateMemory.h"
+#include "PakVerifier.h"
+#include "Async/Async.h"
 
 FString FDownloadTask::TempFileExtension = TEXT(".tmp");
 
 FDownloadTask::FDownloadTask(const FString& URL, const FString& SaveRoot, const FString& FileName,
-                             const int32 FileSize) : State(EDownloadTaskState::Pending), TempFileHandle(nullptr),
-                                                     Request(nullptr)
+                             const int32 FileSize) : State(EDownloadTaskState::Pending), Request(nullptr)
 {
-#if PLATFORM_ANDROID
-	if (!FPlatformFileManager::Get().GetPlatformFile().GetLowerLevel()->DirectoryExists(*SaveRoot))
-#elif PLATFORM_WINDOWS
-    if (!FPlatformFileManager::Get().GetPlatformFile().DirectoryExists(*SaveRoot))
-#endif
-    {
-        if (!FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*SaveRoot))
-        {
-            UE_LOG(LogHotUpdate, Warning, TEXT("Cannot create directory : %s"), *SaveRoot);
-        }
-    }
-
     Root = SaveRoot;
 
     TaskInfo.URL = URL;
@@ -59,20 +53,94 @@ void FDownloadTask::Start()
 
     State = EDownloadTaskState::DownLoading;
 
+    // The manifest already gives the size, the first range goes out without a HEAD round trip
+    if (TaskInfo.FileSize > 0)
+    {
+        HOTUPDATE_TRACE_BOOKMARK(TEXT("HotUpdate Begin %s"), *TaskInfo.FileName);
+
+        TaskInfo.CurrentSize = 0;
+
+        TaskInfo.TotalSize = TaskInfo.FileSize;
+
+        OnSizeKnown();
+
+        return;
+    }
+
     ReqGetHead();
 }
 
+void FDownloadTask::SetRepair(const FString& SourceFile, const FPakFileProperty& PakInfo, const TArray<int32>& Blocks)
+{
+    RepairSource = SourceFile;
+
+    RepairBlockSize = PakInfo.BlockSize;
+
+    RepairBlocks = Blocks;
+
+    RepairBlocks.Sort();
+
+    RepairHashes.Reset();
+
+    RepairRanges.Reset();
+
+    for (const auto Block : RepairBlocks)
+    {
+        RepairHashes.Add(PakInfo.BlockHashes[Block]);
+
+        const auto Offset = static_cast<int64>(Block) * RepairBlockSize;
+
+        const auto Size = FMath::Min<int64>(RepairBlockSize, PakInfo.PakSize - Offset);
+
+        if (RepairRanges.Num() > 0 && RepairRanges.Last().Offset + RepairRanges.Last().Size == Offset)
+        {
+            RepairRanges.Last().Size += Size;
+        }
+        else
+        {
+            RepairRanges.Add({Offset, Size});
+        }
+    }
+}
+
+int64 FDownloadTask::GetRepairSize() const
+{
+    int64 RepairSize = 0;
+
+    for (const auto& Range : RepairRanges)
+    {
+        RepairSize += Range.Size;
+    }
+
+    return RepairSize;
+}
+
 void FDownloadTask::Stop()
 {
-    if (TempFileHandle != nullptr)
+    FHotUpdateFrameBudget::Get().Cancel(this);
+
+    if (bIsWriteQueued)
     {
-        delete TempFileHandle;
+        DEC_DWORD_STAT(STAT_HotUpdate_WriteQueueDepth);
 
-        TempFileHandle = nullptr;
+        bIsWriteQueued = false;
     }
 
+    ReleaseRangeMemory();
+
+    bIsWaitingChunk = false;
+
+    WriteSerial++;
+
+    TempFileWriter.Reset();
+
     if (Request.IsValid())
     {
+        if (Request->GetStatus() == EHttpRequestStatus::Processing)
+        {
+            HOTUPDATE_TRACE_COUNTER_SUBTRACT(HotUpdate_InFlightRequests, 1);
+        }
+
         Request->OnProcessRequestComplete().Unbind();
 
         Request->OnRequestProgress().Unbind();
@@ -80,9 +148,20 @@ void FDownloadTask::Stop()
         Request = nullptr;
     }
 
+    if (HedgeRequest.IsValid())
+    {
+        CancelRangeRequest(HedgeRequest);
+
+        HedgeRequest = nullptr;
+    }
+
+    ReleaseHedge();
+
     State = EDownloadTaskState::Finished;
 
     OnTaskEvent.Unbind();
+
+    OnCanRequestChunk.Unbind();
 }
 
 FTaskInfo FDownloadTask::GetTaskInfo() const
@@ -101,6 +180,14 @@ void FDownloadTask::ReqGetHead()
         return;
     }
 
+    HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.ReqHead %s"), *TaskInfo.FileName);
+
+    HOTUPDATE_TRACE_BOOKMARK(TEXT("HotUpdate Begin %s"), *TaskInfo.FileName);
+
+    HOTUPDATE_TRACE_COUNTER_ADD(HotUpdate_InFlightRequests, 1);
+
+    RequestStartTime = FPlatformTime::Seconds();
+
     Request = FHttpModule::Get().CreateRequest();
 
     Request->SetVerb("HEAD");
@@ -116,6 +203,13 @@ void FDownloadTask::ReqGetHead()
 
 void FDownloadTask::RetGetHead(FHttpRequestPtr, const FHttpResponsePtr Response, const bool bConnectedSuccessfully)
 {
+    HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.RetHead %s"), *TaskInfo.FileName);
+
+    HOTUPDATE_TRACE_COUNTER_SUBTRACT(HotUpdate_InFlightRequests, 1);
+
+    UE_LOG(LogHotUpdate, Verbose, TEXT("%s head took %.2f ms"), *TaskInfo.FileName,
+           (FPlatformTime::Seconds() - RequestStartTime) * 1000.0);
+
     if (!Response.IsValid() || !bConnectedSuccessfully)
     {
         UE_LOG(LogHotUpdate, Warning, TEXT("RetGetHead Response error"));
@@ -131,12 +225,7 @@ void FDownloadTask::RetGetHead(FHttpRequestPtr, const FHttpResponsePtr Response,
     {
         UE_LOG(LogHotUpdate, Warning, TEXT("Http Response code error : %d"), ResponseCode);
 
-        if (TempFileHandle != nullptr)
-        {
-            delete TempFileHandle;
-
-            TempFileHandle = nullptr;
-        }
+        TempFileWriter.Reset();
 
         OnTaskEvent.Execute(EDownloadTaskEvent::ERROR, TaskInfo);
 
@@ -149,6 +238,11 @@ void FDownloadTask::RetGetHead(FHttpRequestPtr, const FHttpResponsePtr Response,
 
     TaskInfo.TotalSize = Response->GetContentLength();
 
+    OnSizeKnown();
+}
+
+void FDownloadTask::OnSizeKnown()
+{
     TempFileName = GetFilePath() + TempFileExtension;
 
     const auto& SavePath = FPaths::GetPath(TempFileName);
@@ -164,11 +258,28 @@ void FDownloadTask::RetGetHead(FHttpRequestPtr, const FHttpResponsePtr Response,
         return;
     }
 
-    auto& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    if (IsRepair())
+    {
+        if (TaskInfo.TotalSize == static_cast<int32>(TaskInfo.FileSize))
+        {
+            PrepareRepair();
+
+            return;
+        }
+
+        UE_LOG(LogHotUpdate, Warning, TEXT("%s, size on server differs, download the whole file"), *TaskInfo.FileName);
 
-    TempFileHandle = PlatformFile.OpenWrite(*TempFileName, true);
+        ClearRepair();
+    }
+
+    BeginWrite();
+}
+
+void FDownloadTask::BeginWrite()
+{
+    TempFileWriter = FHotUpdateFileIO::OpenWrite(TempFileName, TaskInfo.FileSize);
 
-    if (TempFileHandle == nullptr)
+    if (!TempFileWriter.IsValid())
     {
         UE_LOG(LogHotUpdate, Warning, TEXT("%s, create temp file error"), *TempFileName);
 
@@ -179,9 +290,276 @@ void FDownloadTask::RetGetHead(FHttpRequestPtr, const FHttpResponsePtr Response,
 
     UE_LOG(LogHotUpdate, Log, TEXT("Create temp file success! Start downloading: %s"), *TempFileName);
 
+    RequestNextChunk();
+}
+
+void FDownloadTask::PrepareRepair()
+{
+    const TWeakPtr<int32, ESPMode::ThreadSafe> WeakToken = AliveToken;
+
+    const auto Source = RepairSource;
+
+    const auto Target = TempFileName;
+
+    Async(EAsyncExecution::ThreadPool, [this, WeakToken, Source, Target]()
+    {
+        HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.CopyForRepair %s"), *Source);
+
+        const auto bIsCopied = IFileManager::Get().Copy(*Target, *Source) == COPY_OK;
+
+        AsyncTask(ENamedThreads::GameThread, [this, WeakToken, bIsCopied]()
+        {
+            if (WeakToken.IsValid())
+            {
+                OnRepairPrepared(bIsCopied);
+            }
+        });
+    });
+}
+
+void FDownloadTask::OnRepairPrepared(const bool bIsCopied)
+{
+    if (IsFinished())
+    {
+        return;
+    }
+
+    if (bIsCopied)
+    {
+        TaskInfo.TotalSize = GetRepairSize();
+
+        UE_LOG(LogHotUpdate, Log, TEXT("Repair %s: %d blocks, %d bytes"), *TaskInfo.FileName, RepairBlocks.Num(),
+               TaskInfo.TotalSize);
+    }
+    else
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to copy %s for repair, download the whole file"), *RepairSource);
+
+        ClearRepair();
+    }
+
+    BeginWrite();
+}
+
+bool FDownloadTask::VerifyRepair() const
+{
+    const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*TempFileName));
+
+    if (!Reader.IsValid())
+    {
+        return false;
+    }
+
+    for (auto i = 0; i < RepairBlocks.Num(); ++i)
+    {
+        const auto Offset = static_cast<int64>(RepairBlocks[i]) * RepairBlockSize;
+
+        const auto& Hash = FPakVerifier::HashRange(*Reader, Offset,
+                                                   FMath::Min<int64>(RepairBlockSize, Reader->TotalSize() - Offset));
+
+        if (!Hash.Equals(RepairHashes[i], ESearchCase::IgnoreCase))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FDownloadTask::ClearRepair()
+{
+    RepairBlocks.Empty();
+
+    RepairHashes.Empty();
+
+    RepairRanges.Empty();
+
+    IFileManager::Get().Delete(*TempFileName, false, true, true);
+}
+
+int64 FDownloadTask::GetFileOffset(int64 FetchedSize, int64& RangeEnd) const
+{
+    if (!IsRepair())
+    {
+        RangeEnd = TaskInfo.TotalSize;
+
+        return FetchedSize;
+    }
+
+    for (const auto& Range : RepairRanges)
+    {
+        if (FetchedSize < Range.Size)
+        {
+            RangeEnd = Range.Offset + Range.Size;
+
+            return Range.Offset + FetchedSize;
+        }
+
+        FetchedSize -= Range.Size;
+    }
+
+    RangeEnd = 0;
+
+    return 0;
+}
+
+void FDownloadTask::RequestNextChunk()
+{
+    if (OnCanRequestChunk.IsBound() && !OnCanRequestChunk.Execute(TaskInfo))
+    {
+        bIsWaitingChunk = true;
+
+        return;
+    }
+
+    bIsWaitingChunk = false;
+
     ReqGetChunk();
 }
 
+void FDownloadTask::ResumeChunk()
+{
+    if (!bIsWaitingChunk || IsFinished())
+    {
+        return;
+    }
+
+    bIsWaitingChunk = false;
+
+    ReqGetChunk();
+}
+
+int32 FDownloadTask::GetBytesInFlight() const
+{
+    if (!Request.IsValid() || Request->GetStatus() != EHttpRequestStatus::Processing)
+    {
+        return 0;
+    }
+
+    return FMath::Max(RangeSize - RangeReceivedSize, 0);
+}
+
+double FDownloadTask::GetRangeElapsed() const
+{
+    if (!Request.IsValid() || Request->GetStatus() != EHttpRequestStatus::Processing)
+    {
+        return 0.0;
+    }
+
+    return FPlatformTime::Seconds() - RequestStartTime;
+}
+
+bool FDownloadTask::Hedge()
+{
+    if (IsHedged() || RangeSize <= 0 || GetRangeElapsed() <= 0.0)
+    {
+        return false;
+    }
+
+    UE_LOG(LogHotUpdate, Log, TEXT("%s, hedge range at %lld after %.2f s"), *TaskInfo.FileName, RangeOffset,
+           GetRangeElapsed());
+
+    HedgeReservedSize = RangeSize;
+
+    FHotUpdateMemory::Get().Alloc(EHotUpdateMemoryStage::Download, HedgeReservedSize);
+
+    HOTUPDATE_TRACE_COUNTER_ADD(HotUpdate_InFlightRequests, 1);
+
+    // The whole range again, http responses hand over their content only once complete
+    HedgeRequest = CreateRangeRequest(RangeOffset, RangeOffset + RangeSize - 1);
+
+    HedgeRequest->ProcessRequest();
+
+    return true;
+}
+
+bool FDownloadTask::ResolveHedge(const FHttpRequestPtr& InRequest, const bool bIsSucceeded)
+{
+    if (!HedgeRequest.IsValid())
+    {
+        return true;
+    }
+
+    const auto bIsHedge = InRequest.Get() == HedgeRequest.Get();
+
+    if (!bIsSucceeded)
+    {
+        // The other request may still deliver the range, a failure only counts once both have answered
+        if (!bIsHedge)
+        {
+            Request = HedgeRequest;
+        }
+
+        HedgeRequest = nullptr;
+
+        ReleaseHedge();
+
+        return false;
+    }
+
+    if (bIsHedge)
+    {
+        UE_LOG(LogHotUpdate, Log, TEXT("%s, hedged range at %lld answered first"), *TaskInfo.FileName, RangeOffset);
+
+        CancelRangeRequest(Request);
+
+        Request = HedgeRequest;
+
+        TaskInfo.HedgeWins++;
+    }
+    else
+    {
+        CancelRangeRequest(HedgeRequest);
+    }
+
+    HedgeRequest = nullptr;
+
+    ReleaseHedge();
+
+    return true;
+}
+
+void FDownloadTask::CancelRangeRequest(const TSharedPtr<IHttpRequest>& InRequest) const
+{
+    if (InRequest->GetStatus() == EHttpRequestStatus::Processing)
+    {
+        HOTUPDATE_TRACE_COUNTER_SUBTRACT(HotUpdate_InFlightRequests, 1);
+    }
+
+    InRequest->OnProcessRequestComplete().Unbind();
+
+    InRequest->OnRequestProgress().Unbind();
+
+    InRequest->CancelRequest();
+}
+
+void FDownloadTask::ReleaseHedge()
+{
+    if (HedgeReservedSize > 0)
+    {
+        FHotUpdateMemory::Get().Free(EHotUpdateMemoryStage::Download, HedgeReservedSize);
+
+        HedgeReservedSize = 0;
+    }
+}
+
+int32 FDownloadTask::GetNextChunkSize() const
+{
+    const auto Pressure = FHotUpdateMemory::Get().GetPressure();
+
+    if (Pressure >= FHotUpdateMemory::HighPressure)
+    {
+        return FMath::Max(ChunkSize / 2, MinChunkSize);
+    }
+
+    if (Pressure < FHotUpdateMemory::LowPressure)
+    {
+        return FMath::Min(ChunkSize * 2, PreferredChunkSize);
+    }
+
+    return ChunkSize;
+}
+
 void FDownloadTask::ReqGetChunk()
 {
     const auto& EncodedURL = GetEncodedURL();
@@ -193,46 +571,94 @@ void FDownloadTask::ReqGetChunk()
         return;
     }
 
-    const auto BeginPosition = TaskInfo.CurrentSize;
+    ChunkSize = GetNextChunkSize();
 
-    auto EndPosition = BeginPosition + ChunkSize - 1;
+    int64 RangeEnd;
 
-    if (EndPosition >= TaskInfo.TotalSize)
-    {
-        EndPosition = TaskInfo.TotalSize - 1;
-    }
+    const auto BeginPosition = GetFileOffset(TaskInfo.CurrentSize, RangeEnd);
 
-    const auto& RangeStr = FString("bytes=") + FString::FromInt(BeginPosition) +
-        FString(TEXT("-")) + FString::FromInt(EndPosition);
+    const auto EndPosition = FMath::Min<int64>(BeginPosition + ChunkSize, RangeEnd) - 1;
 
-    Request = FHttpModule::Get().CreateRequest();
+    RangeOffset = BeginPosition;
 
-    Request->SetVerb("GET");
+    RangeSize = EndPosition - BeginPosition + 1;
 
-    Request->SetURL(EncodedURL);
+    ReleaseRangeMemory();
+
+    ReservedRangeSize = RangeSize;
+
+    FHotUpdateMemory::Get().Alloc(EHotUpdateMemoryStage::Download, ReservedRangeSize);
+
+    HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.ReqRange %s"), *TaskInfo.FileName);
 
-    Request->AppendToHeader(FString("Range"), RangeStr);
+    HOTUPDATE_LLM_SCOPE();
 
-    Request->OnProcessRequestComplete().BindRaw(this, &FDownloadTask::RetGetChunk);
+    HOTUPDATE_TRACE_COUNTER_ADD(HotUpdate_InFlightRequests, 1);
 
-    Request->OnRequestProgress().BindRaw(this, &FDownloadTask::GetChunkProgress);
+    RequestStartTime = FPlatformTime::Seconds();
+
+    RangeReceivedSize = 0;
+
+    Request = CreateRangeRequest(BeginPosition, EndPosition);
 
     Request->ProcessRequest();
 
     OnTaskEvent.Execute(EDownloadTaskEvent::BEGIN_DOWNLOAD, TaskInfo);
 }
 
+TSharedRef<IHttpRequest> FDownloadTask::CreateRangeRequest(const int64 BeginPosition, const int64 EndPosition)
+{
+    auto RangeRequest = FHttpModule::Get().CreateRequest();
+
+    RangeRequest->SetVerb("GET");
+
+    RangeRequest->SetURL(GetEncodedURL());
+
+    RangeRequest->AppendToHeader(FString("Range"),
+                                 FString::Printf(TEXT("bytes=%lld-%lld"), BeginPosition, EndPosition));
+
+    RangeRequest->OnProcessRequestComplete().BindRaw(this, &FDownloadTask::RetGetChunk);
+
+    RangeRequest->OnRequestProgress().BindRaw(this, &FDownloadTask::GetChunkProgress);
+
+    return RangeRequest;
+}
+
 FString FDownloadTask::GetFilePath() const
 {
     return FPaths::Combine(Root, TaskInfo.FileName);
 }
 
-void FDownloadTask::RetGetChunk(FHttpRequestPtr, const FHttpResponsePtr Response, const bool bConnectedSuccessfully)
+void FDownloadTask::RetGetChunk(FHttpRequestPtr InRequest, const FHttpResponsePtr Response,
+                                const bool bConnectedSuccessfully)
 {
+    HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.RetRange %s"), *TaskInfo.FileName);
+
+    HOTUPDATE_TRACE_COUNTER_SUBTRACT(HotUpdate_InFlightRequests, 1);
+
+    const auto bIsSucceeded = bConnectedSuccessfully && Response.IsValid() && Response->GetResponseCode() >= 200 &&
+        Response->GetResponseCode() < 400;
+
+    if (!ResolveHedge(InRequest, bIsSucceeded))
+    {
+        return;
+    }
+
+    TaskInfo.RangeLatency = (FPlatformTime::Seconds() - RequestStartTime) * 1000.0;
+
+    HOTUPDATE_TRACE_COUNTER_SET(HotUpdate_RangeLatencyMs, TaskInfo.RangeLatency);
+
     if (!Response.IsValid() || !bConnectedSuccessfully)
     {
         UE_LOG(LogHotUpdate, Warning, TEXT("RetGetChunk Response error"));
 
+        ReleaseRangeMemory();
+
+        if (RetryChunk())
+        {
+            return;
+        }
+
         OnTaskEvent.Execute(EDownloadTaskEvent::ERROR, TaskInfo);
 
         return;
@@ -244,38 +670,116 @@ void FDownloadTask::RetGetChunk(FHttpRequestPtr, const FHttpResponsePtr Response
     {
         UE_LOG(LogHotUpdate, Warning, TEXT("%d, ResponseCode code error"), ResponseCode);
 
-        if (TempFileHandle != nullptr)
+        ReleaseRangeMemory();
+
+        if (ResponseCode >= 500 && RetryChunk())
         {
-            delete TempFileHandle;
-            TempFileHandle = nullptr;
+            return;
         }
 
+        TempFileWriter.Reset();
+
         OnTaskEvent.Execute(EDownloadTaskEvent::ERROR, TaskInfo);
 
         return;
     }
 
+    INC_DWORD_STAT(STAT_HotUpdate_WriteQueueDepth);
+
+    bIsWriteQueued = true;
+
+    FHotUpdateFrameBudget::Get().Enqueue(this, [this, Response]()
+    {
+        DEC_DWORD_STAT(STAT_HotUpdate_WriteQueueDepth);
+
+        bIsWriteQueued = false;
+
+        WriteChunk(Response);
+    });
+}
+
+void FDownloadTask::WriteChunk(const FHttpResponsePtr& Response)
+{
+    HOTUPDATE_LLM_SCOPE();
+
+    if (!TempFileWriter.IsValid())
+    {
+        return;
+    }
+
     const auto& Buffer = Response->GetContent();
 
-    if (TempFileHandle != nullptr)
+    const TWeakPtr<int32, ESPMode::ThreadSafe> WeakToken = AliveToken;
+
+    const auto BufferSize = Buffer.Num();
+
+    const auto Serial = WriteSerial;
+
+    HOTUPDATE_TRACE_SCOPE(HotUpdate_WriteChunk);
+
+    SCOPE_CYCLE_COUNTER(STAT_HotUpdate_WriteChunk);
+
+    // The response owns the buffer until the write is done
+    TempFileWriter->Write(RangeOffset, Buffer.GetData(), BufferSize,
+                          [this, WeakToken, Response, BufferSize, Serial](const bool bWritten)
+                          {
+                              if (IsInGameThread())
+                              {
+                                  if (WeakToken.IsValid())
+                                  {
+                                      OnChunkWritten(bWritten, BufferSize, Serial);
+                                  }
+
+                                  return;
+                              }
+
+                              // The task is only resolved on the game thread, where it is destroyed
+                              AsyncTask(ENamedThreads::GameThread, [this, WeakToken, bWritten, BufferSize, Serial]()
+                              {
+                                  if (WeakToken.IsValid())
+                                  {
+                                      OnChunkWritten(bWritten, BufferSize, Serial);
+                                  }
+                              });
+                          });
+}
+
+void FDownloadTask::OnChunkWritten(const bool bWritten, const int32 BufferSize, const uint32 Serial)
+{
+    // Written for a run that was stopped since
+    if (Serial != WriteSerial)
     {
-        TempFileHandle->Seek(TaskInfo.CurrentSize);
+        return;
+    }
 
-        if (TempFileHandle->Write(Buffer.GetData(), Buffer.Num()))
-        {
-            OnWriteChunkEnd(Buffer.Num());
-        }
-        else
-        {
-            UE_LOG(LogHotUpdate, Warning, TEXT("write file error"));
+    ReleaseRangeMemory();
 
-            OnTaskEvent.Execute(EDownloadTaskEvent::ERROR, TaskInfo);
-        }
+    if (bWritten)
+    {
+        HOTUPDATE_TRACE_COUNTER_ADD(HotUpdate_DownloadedBytes, BufferSize);
+
+        OnTaskEvent.Execute(EDownloadTaskEvent::END_RANGE, TaskInfo);
+
+        OnWriteChunkEnd(BufferSize);
+    }
+    else
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("write file error"));
+
+        OnTaskEvent.Execute(EDownloadTaskEvent::ERROR, TaskInfo);
     }
 }
 
-void FDownloadTask::GetChunkProgress(FHttpRequestPtr, int32, const int32 BytesReceived)
+void FDownloadTask::GetChunkProgress(FHttpRequestPtr InRequest, int32, const int32 BytesReceived)
 {
+    // A hedged request reports its own progress, only the primary one moves the task
+    if (InRequest.Get() != Request.Get())
+    {
+        return;
+    }
+
+    RangeReceivedSize = BytesReceived;
+
     const auto DownloadSize = TaskInfo.CurrentSize + BytesReceived;
 
     if (DownloadSize > TaskInfo.TotalSize)
@@ -291,18 +795,43 @@ void FDownloadTask::GetChunkProgress(FHttpRequestPtr, int32, const int32 BytesRe
 
 void FDownloadTask::OnTaskCompleted()
 {
-    if (TempFileHandle != nullptr)
+    TempFileWriter.Reset();
+
+    if (IsRepair() && !VerifyRepair())
     {
-        delete TempFileHandle;
+        UE_LOG(LogHotUpdate, Warning, TEXT("%s, repaired blocks don't match, download the whole file"),
+               *TaskInfo.FileName);
+
+        ClearRepair();
+
+        TaskInfo.DiscardedSize += TaskInfo.CurrentSize;
+
+        TaskInfo.CurrentSize = 0;
+
+        TaskInfo.DownloadSize = 0;
 
-        TempFileHandle = nullptr;
+        TaskInfo.TotalSize = TaskInfo.FileSize;
+
+        BeginWrite();
+
+        return;
     }
 
     State = EDownloadTaskState::Finished;
 
+    HOTUPDATE_TRACE_BOOKMARK(TEXT("HotUpdate End %s"), *TaskInfo.FileName);
+
     if (!IsFileExist())
     {
-        if (IFileManager::Get().Move(*GetFilePath(), *TempFileName))
+        bool bMoved;
+
+        {
+            HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.MoveTemp %s"), *TaskInfo.FileName);
+
+            bMoved = IFileManager::Get().Move(*GetFilePath(), *TempFileName);
+        }
+
+        if (bMoved)
         {
             OnTaskEvent.Execute(EDownloadTaskEvent::END_DOWNLOAD, TaskInfo);
         }
@@ -334,22 +863,63 @@ void FDownloadTask::OnWriteChunkEnd(const int32 BufferSize)
 
     if (TaskInfo.CurrentSize < TaskInfo.TotalSize)
     {
-        ReqGetChunk();
+        RequestNextChunk();
     }
     else
     {
-        OnTaskCompleted();
+        FHotUpdateFrameBudget::Get().Enqueue(this, [this]()
+        {
+            OnTaskCompleted();
+        });
+    }
+}
+
+void FDownloadTask::ReleaseRangeMemory()
+{
+    if (ReservedRangeSize > 0)
+    {
+        FHotUpdateMemory::Get().Free(EHotUpdateMemoryStage::Download, ReservedRangeSize);
+
+        ReservedRangeSize = 0;
     }
 }
 
+bool FDownloadTask::RetryChunk()
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    const auto MaxRetryTime = HotUpdateSettings != nullptr ? HotUpdateSettings->MaxRetryTime : 3;
+
+    TaskInfo.DiscardedSize += RangeReceivedSize;
+
+    if (TaskInfo.RetryCount >= MaxRetryTime)
+    {
+        return false;
+    }
+
+    TaskInfo.RetryCount++;
+
+    UE_LOG(LogHotUpdate, Log, TEXT("%s, retry range at %d (%u/%u)"), *TaskInfo.FileName, TaskInfo.CurrentSize,
+           TaskInfo.RetryCount, MaxRetryTime);
+
+    // A retry is a new range like any other, it waits for the pause, memory and rate gates
+    RequestNextChunk();
+
+    return true;
+}
+
 FString FDownloadTask::GetEncodedURL() const
 {
-    const auto URLSplit = TaskInfo.URL.Find(FString("/"),
-                                            ESearchCase::IgnoreCase, ESearchDir::FromStart, 14) + 1;
+    return EncodeURL(TaskInfo.URL);
+}
+
+FString FDownloadTask::EncodeURL(const FString& URL)
+{
+    const auto URLSplit = URL.Find(FString("/"), ESearchCase::IgnoreCase, ESearchDir::FromStart, 14) + 1;
 
     if (URLSplit > 0)
     {
-        auto SubURL = TaskInfo.URL.Mid(URLSplit);
+        auto SubURL = URL.Mid(URLSplit);
 
         TArray<FString> URLUnit;
 
@@ -367,7 +937,7 @@ FString FDownloadTask::GetEncodedURL() const
             }
         }
 
-        return TaskInfo.URL.Left(URLSplit) + SubURL;
+        return URL.Left(URLSplit) + SubURL;
     }
 
     return FString();
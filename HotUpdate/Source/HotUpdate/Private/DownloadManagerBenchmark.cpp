@@ -0,0 +1,162 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "FileDownloadManager.h"
+#include "FileDownLog.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace DownloadManagerBenchmark
+{
+    /**
+     * Replaces the http transport with an in-memory queue: started tasks are completed by feeding the manager the
+     * same events a real task would send, so only the bookkeeping of the manager is measured.
+     */
+    class FMemoryDownloadManager final : public FFileDownloadManager
+    {
+    public:
+        bool Step()
+        {
+            if (Head >= Started.Num())
+            {
+                return false;
+            }
+
+            auto Info = Started[Head++];
+
+            OnTaskEvent(EDownloadTaskEvent::BEGIN_DOWNLOAD, Info);
+
+            Info.TotalSize = Info.FileSize;
+
+            Info.DownloadSize = Info.FileSize / 2;
+
+            OnTaskEvent(EDownloadTaskEvent::UPDATE_DOWNLOAD, Info);
+
+            Info.CurrentSize = Info.FileSize;
+
+            Info.DownloadSize = Info.FileSize;
+
+            OnTaskEvent(EDownloadTaskEvent::UPDATE_DOWNLOAD, Info);
+
+            OnTaskEvent(EDownloadTaskEvent::END_RANGE, Info);
+
+            OnTaskEvent(EDownloadTaskEvent::END_DOWNLOAD, Info);
+
+            return true;
+        }
+
+    protected:
+        virtual void StartTask(FDownloadTask& Task) override
+        {
+            Started.Add(Task.GetTaskInfo());
+        }
+
+        virtual void PlaceFile(const FTaskInfo&, const TArray<FString>&) override
+        {
+        }
+
+        virtual void ClearTempPak() override
+        {
+        }
+
+        virtual bool AcquireLease(const FString&, TSharedPtr<FHotUpdateLease>&) override
+        {
+            return true;
+        }
+
+    private:
+        TArray<FTaskInfo> Started;
+
+        int32 Head = 0;
+    };
+
+    static void Run(const int32 TaskNum, FOutputDevice& Ar)
+    {
+        FMemoryDownloadManager DownloadManager;
+
+        auto FinishedNum = 0;
+
+        auto bIsAllFinished = false;
+
+        DownloadManager.OnDownloadEvent.BindLambda([&FinishedNum, &bIsAllFinished](const EDownloadState Event,
+                                                                                  const FTaskInfo&)
+        {
+            if (Event == EDownloadState::END_FILE_DOWNLOAD)
+            {
+                FinishedNum++;
+            }
+            else if (Event == EDownloadState::END_DOWNLOAD)
+            {
+                bIsAllFinished = true;
+            }
+        });
+
+        const auto AddStartTime = FPlatformTime::Seconds();
+
+        for (auto i = 0; i < TaskNum; ++i)
+        {
+            DownloadManager.AddTask(FString::Printf(TEXT("http://localhost/%d.pak"), i),
+                                    FString::Printf(TEXT("%d.pak"), i), 1024 * 1024,
+                                    FString::Printf(TEXT("%032x"), i));
+        }
+
+        DownloadManager.SealTasks();
+
+        const auto RunStartTime = FPlatformTime::Seconds();
+
+        DownloadManager.StartUp();
+
+        auto StepNum = 0;
+
+        while (DownloadManager.Step())
+        {
+            if (++StepNum % 64 == 0)
+            {
+                DownloadManager.GetDownloadProgress();
+            }
+        }
+
+        const auto EndTime = FPlatformTime::Seconds();
+
+        const auto bIsSuccessful = bIsAllFinished && DownloadManager.IsSuccessful() && FinishedNum == TaskNum;
+
+        DownloadManager.ShutDown();
+
+        Ar.Logf(TEXT("%7d tasks: add %8.2f ms, run %8.2f ms, %6.3f us/task, %s"), TaskNum,
+                (RunStartTime - AddStartTime) * 1000.0, (EndTime - RunStartTime) * 1000.0,
+                (EndTime - RunStartTime) * 1000000.0 / FMath::Max(TaskNum, 1),
+                bIsSuccessful ? TEXT("ok") : TEXT("incomplete"));
+    }
+
+    static FAutoConsoleCommandWithWorldArgsAndOutputDevice BenchmarkCommand(
+        TEXT("HotUpdate.Benchmark.Manager"),
+        TEXT("HotUpdate.Benchmark.Manager [TaskNum...], drive the download manager with synthetic manifests, ")
+        TEXT("1000 10000 100000 by default"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld*, FOutputDevice& Ar)
+            {
+                TArray<int32> TaskNums;
+
+                for (const auto& Arg : Args)
+                {
+                    TaskNums.Add(FMath::Max(FCString::Atoi(*Arg), 1));
+                }
+
+                if (TaskNums.Num() <= 0)
+                {
+                    TaskNums = {1000, 10000, 100000};
+                }
+
+                const auto Verbosity = LogHotUpdate.GetVerbosity();
+
+                LogHotUpdate.SetVerbosity(ELogVerbosity::Warning);
+
+                for (const auto TaskNum : TaskNums)
+                {
+                    Run(TaskNum, Ar);
+                }
+
+                LogHotUpdate.SetVerbosity(Verbosity);
+            }));
+}
+
+#endif
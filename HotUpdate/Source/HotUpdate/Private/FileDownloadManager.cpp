@@ -1,163 +1,901 @@
 #include "FileDownloadManager.h"
 #include "FileDownLog.h"
 #include "HotUpdateSettings.h"
-#include "Engine/World.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HotUpdateTrace.h"
+#include "HotUpdateFrameBudget.h"
+#include "HotUpdateStats.h"
+#include "HotUpdateMemory.h"
+#include "ManifestPlanner.h"
+#include "PakVerifier.h"
+#include "Async/Async.h"
+
+static const double LeasePollInterval = 0.5;
+
+/** Progress is reported on time, the commandlet never advances the frame counter */
+static const double ProgressUpdateInterval = 0.1;
+
+static const int32 MaxLatencySamples = 64;
+
+static const int32 MinHedgeSamples = 8;
+
+/** Below this a range is never hedged, however fast the others were */
+static const double MinHedgeDelay = 0.5;
+
+FFileDownloadManager::FFileDownloadManager()
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings != nullptr)
+    {
+        MaxConcurrency = HotUpdateSettings->MaxConcurrency;
+
+        BaseConcurrency = MaxConcurrency;
+
+        RateLimit = static_cast<int64>(HotUpdateSettings->RateLimit) * 1024;
+
+        HedgePercentile = FMath::Clamp(HotUpdateSettings->HedgePercentile, 0, 100);
+
+        HedgeBudgetPercent = FMath::Max(HotUpdateSettings->HedgeBudgetPercent, 0);
+    }
+}
 
 void FFileDownloadManager::StartUp()
 {
+    if (bIsStarted)
+    {
+        return;
+    }
+
+    bIsStarted = true;
+
     StartTime = FDateTime::Now();
 
+    bWasThrottled = false;
+
     ClearTempPak();
 
     UE_LOG(LogHotUpdate, Display, TEXT("Begin Download : %s"), *StartTime.ToString());
 
-    if (Tasks.Num() > 0)
+    HOTUPDATE_TRACE_COUNTER_SET(HotUpdate_FinishedTasks, 0);
+
+    HOTUPDATE_TRACE_COUNTER_SET(HotUpdate_DownloadedBytes, 0);
+
+    if (Report.IsValid())
+    {
+        const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+        Report->SetEnvironment(TEXT("Transport"), TEXT("Http"));
+
+        Report->SetEnvironment(TEXT("ChunkSize"), FString::FromInt(PreferredChunkSize));
+
+        Report->SetEnvironment(TEXT("MaxConcurrency"), FString::FromInt(MaxConcurrency));
+
+        Report->SetEnvironment(TEXT("RateLimit"), FString::Printf(TEXT("%lld"), RateLimit));
+
+        Report->SetEnvironment(TEXT("MaxRetryTime"),
+                               FString::FromInt(HotUpdateSettings != nullptr ? HotUpdateSettings->MaxRetryTime : 3));
+    }
+
+    OnDownloadEvent.ExecuteIfBound(EDownloadState::BEGIN_DOWNLOAD, FTaskInfo());
+
+    LastProgressTime = FPlatformTime::Seconds();
+
+    LastDownloadedSize = CurrentDownloadSize;
+
+    RateTokens = 0.0;
+
+    LastRefillTime = FPlatformTime::Seconds();
+
+    if (!TickHandle.IsValid())
+    {
+        TickHandle = FTicker::GetCoreTicker().AddTicker(
+            FTickerDelegate::CreateRaw(this, &FFileDownloadManager::Tick));
+    }
+
+    StartPendingTasks();
+
+    if (IsAllTaskFinished())
+    {
+        OnAllTaskFinish();
+    }
+}
+
+void FFileDownloadManager::SealTasks()
+{
+    if (bIsSealed)
+    {
+        return;
+    }
+
+    bIsSealed = true;
+
+    if (Report.IsValid())
+    {
+        Report->SetEnvironment(TEXT("Tasks"), FString::FromInt(Tasks.Num()));
+
+        Report->SetEnvironment(TEXT("TotalDownloadSize"), FString::Printf(TEXT("%llu"), TotalDownloadSize));
+
+        Report->SetCounter(TEXT("DuplicatedContents"), FoldedTaskNum);
+    }
+
+    if (bIsStarted && IsAllTaskFinished())
+    {
+        OnAllTaskFinish();
+    }
+}
+
+void FFileDownloadManager::ShutDown()
+{
+    FHotUpdateFrameBudget::Get().Cancel(this);
+
+    bIsProgressQueued = false;
+
+    if (TickHandle.IsValid())
+    {
+        FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+        TickHandle.Reset();
+    }
+
+    for (const auto& Entry : Tasks)
+    {
+        Entry.Task->Stop();
+    }
+
+    Tasks.Empty();
+
+    TaskIndices.Empty();
+
+    ContentIndices.Empty();
+
+    FoldedTaskNum = 0;
+
+    PendingTasks.Empty();
+
+    NextPendingIndex = 0;
+
+    ActiveTasks.Empty();
+
+    WaitingTasks.Empty();
+
+    FailedTasks.Empty();
+
+    LeaseWaitingTasks.Empty();
+
+    PeerCheckToken = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+    CopyToken = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+    CopyingNum = 0;
+
+    PeerTaskNum = 0;
+
+    SucceededTaskNum = 0;
+
+    CurrentDownloadSize = 0;
+
+    TotalDownloadSize = 0;
+
+    LastDownloadedSize = 0;
+
+    bIsStarted = false;
+
+    bIsSealed = false;
+
+    ClearTempPak();
+}
+
+FString FFileDownloadManager::GetTempPakSaveRoot()
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+#if PLATFORM_DESKTOP &&  WITH_EDITOR
+    return FPaths::Combine(FPaths::ProjectSavedDir(),
+                           HotUpdateSettings != nullptr ? HotUpdateSettings->TempPakSaveRoot : "");
+#else
+	return FPaths::Combine(FPaths::RootDir(), HotUpdateSettings != nullptr ? HotUpdateSettings->TempPakSaveRoot : "");
+#endif
+}
+
+FString FFileDownloadManager::GetPakSaveRoot()
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+#if PLATFORM_DESKTOP &&  WITH_EDITOR
+    return FPaths::Combine(FPaths::ProjectSavedDir(),
+                           HotUpdateSettings != nullptr ? HotUpdateSettings->PakSaveRoot : "");
+#else
+	return FPaths::Combine(FPaths::RootDir(), HotUpdateSettings != nullptr ? HotUpdateSettings->PakSaveRoot : "");
+#endif
+}
+
+bool FFileDownloadManager::IsSuccessful() const
+{
+    if (!bIsSealed)
+    {
+        return true;
+    }
+
+    return SucceededTaskNum == Tasks.Num() && FailedTasks.Num() <= 0;
+}
+
+bool FFileDownloadManager::IsAllTaskFinished() const
+{
+    return bIsSealed && CopyingNum <= 0 && SucceededTaskNum + FailedTasks.Num() >= Tasks.Num();
+}
+
+void FFileDownloadManager::SetReport(const TSharedPtr<FHotUpdateReport>& InReport)
+{
+    Report = InReport;
+}
+
+int32 FFileDownloadManager::FindTask(const FGuid& Guid) const
+{
+    const auto Index = TaskIndices.Find(Guid);
+
+    return Index != nullptr ? *Index : INDEX_NONE;
+}
+
+void FFileDownloadManager::OnTaskFinish(const FTaskInfo& Info, const bool bIsSuccess)
+{
+    HOTUPDATE_TRACE_SCOPE(HotUpdate_OnTaskFinish);
+
+    SCOPE_CYCLE_COUNTER(STAT_HotUpdate_TaskFinish);
+
+    const auto Index = FindTask(Info.GUID);
+
+    if (Index == INDEX_NONE)
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Value is not valid:%s"), *Info.FileName);
+        return;
+    }
+
+    auto& Entry = Tasks[Index];
+
+    if (Entry.ActiveSlot == INDEX_NONE)
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Task already finished:%s"), *Info.FileName);
+        return;
+    }
+
+    HedgeWinNum += Info.HedgeWins;
+
+    if (Report.IsValid())
+    {
+        Report->OnFileEnd(Info.FileName, Info.CurrentSize, Info.RetryCount,
+                          bIsSuccess ? Info.DiscardedSize : Info.DiscardedSize + Info.CurrentSize, bIsSuccess);
+
+        Report->SetCounter(TEXT("HedgeWins"), HedgeWinNum);
+    }
+
+    if (bIsSuccess)
+    {
+        CurrentDownloadSize += Info.CurrentSize - Entry.DownloadSize;
+
+        Entry.DownloadSize = Info.CurrentSize;
+
+        SucceededTaskNum++;
+
+        PlaceFile(Info, Entry.Aliases);
+    }
+    else
+    {
+        FailedTasks.Add(Index);
+    }
+
+    HOTUPDATE_TRACE_COUNTER_ADD(HotUpdate_FinishedTasks, 1);
+
+    DeactivateTask(Index);
+
+    // Released only now, waiting processes find the file in place or take over the download
+    Entry.Lease.Reset();
+
+    StartPendingTasks();
+}
+
+void FFileDownloadManager::StartTask(FDownloadTask& Task)
+{
+    Task.Start();
+}
+
+void FFileDownloadManager::PlaceFile(const FTaskInfo& Info, const TArray<FString>& Aliases)
+{
+    const auto& TempFile = FPaths::Combine(GetTempPakSaveRoot(), Info.FileName);
+
+    if (!IFileManager::Get().FileExists(*TempFile))
+    {
+        UE_LOG(LogHotUpdate, Error, TEXT("File doesn't exist after download success : %s"), *TempFile);
+    }
+    else
+    {
+        const auto& File = FPaths::Combine(GetPakSaveRoot(), Info.FileName);
+
+        HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.MovePak %s"), *Info.FileName);
+
+        if (!IFileManager::Get().Move(*File, *TempFile, true, false, false, true))
+        {
+            UE_LOG(LogHotUpdate, Error, TEXT("Failed to move file from %s to %s"), *TempFile, *File);
+
+            return;
+        }
+
+        CopyAliases(File, Aliases);
+    }
+}
+
+void FFileDownloadManager::CopyAliases(const FString& File, const TArray<FString>& Aliases)
+{
+    if (Aliases.Num() <= 0)
+    {
+        return;
+    }
+
+    TArray<FString> AliasFiles;
+
+    for (const auto& Alias : Aliases)
+    {
+        AliasFiles.Add(FPaths::Combine(GetPakSaveRoot(), Alias));
+    }
+
+    CopyFiles(File, AliasFiles, nullptr);
+}
+
+void FFileDownloadManager::CopyFiles(const FString& Source, const TArray<FString>& Targets,
+                                     TFunction<void(bool bIsCopied)>&& OnCopied)
+{
+    CopyingNum++;
+
+    const TWeakPtr<int32, ESPMode::ThreadSafe> WeakToken = CopyToken;
+
+    Async(EAsyncExecution::ThreadPool, [this, WeakToken, Source, Targets, OnCopied = MoveTemp(OnCopied)]()
+    {
+        HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.CopyPak %s"), *Source);
+
+        auto bIsCopied = true;
+
+        for (const auto& Target : Targets)
+        {
+            if (IFileManager::Get().Copy(*Target, *Source) != COPY_OK)
+            {
+                UE_LOG(LogHotUpdate, Error, TEXT("Failed to copy file from %s to %s"), *Source, *Target);
+
+                bIsCopied = false;
+            }
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [this, WeakToken, OnCopied, bIsCopied]()
+        {
+            if (!WeakToken.IsValid())
+            {
+                return;
+            }
+
+            CopyingNum--;
+
+            if (OnCopied)
+            {
+                OnCopied(bIsCopied);
+            }
+
+            if (bIsStarted && IsAllTaskFinished())
+            {
+                OnAllTaskFinish();
+            }
+        });
+    });
+}
+
+void FFileDownloadManager::ActivateTask(const int32 Index)
+{
+    auto& Entry = Tasks[Index];
+
+    Entry.ActiveSlot = ActiveTasks.Add(Index);
+}
+
+void FFileDownloadManager::DeactivateTask(const int32 Index)
+{
+    auto& Entry = Tasks[Index];
+
+    const auto Slot = Entry.ActiveSlot;
+
+    if (Slot == INDEX_NONE)
+    {
+        return;
+    }
+
+    ActiveTasks.RemoveAtSwap(Slot, 1, false);
+
+    if (Slot < ActiveTasks.Num())
+    {
+        Tasks[ActiveTasks[Slot]].ActiveSlot = Slot;
+    }
+
+    Entry.ActiveSlot = INDEX_NONE;
+
+    // Left in WaitingTasks, the next Tick drops it
+    Entry.bIsWaiting = false;
+}
+
+void FFileDownloadManager::StartPendingTasks()
+{
+    while (!IsHeld() && NextPendingIndex < PendingTasks.Num() &&
+        (MaxConcurrency <= 0 || ActiveTasks.Num() < MaxConcurrency) &&
+        (ActiveTasks.Num() <= 0 || FHotUpdateMemory::Get().GetPressure() < FHotUpdateMemory::HighPressure))
+    {
+        const auto Index = PendingTasks[NextPendingIndex++];
+
+        const auto Task = Tasks[Index].Task;
+
+        if (!Task->IsPending() || !TakeLease(Index))
+        {
+            continue;
+        }
+
+        ActivateTask(Index);
+
+        Task->SetChunkSize(PreferredChunkSize);
+
+        StartTask(*Task);
+    }
+
+    SET_DWORD_STAT(STAT_HotUpdate_QueuedTasks, PendingTasks.Num() - NextPendingIndex);
+}
+
+bool FFileDownloadManager::OnCanRequestChunk(const FTaskInfo& Info)
+{
+    const auto Index = FindTask(Info.GUID);
+
+    if (Index == INDEX_NONE)
+    {
+        return true;
+    }
+
+    auto& Entry = Tasks[Index];
+
+    if (CanRequestChunk(*Entry.Task))
+    {
+        return true;
+    }
+
+    if (!Entry.bIsWaiting)
+    {
+        Entry.bIsWaiting = true;
+
+        WaitingTasks.Add(Index);
+    }
+
+    return false;
+}
+
+bool FFileDownloadManager::CanRequestChunk(const FDownloadTask& Task)
+{
+    if (IsHeld())
+    {
+        return false;
+    }
+
+    const auto& Info = Task.GetTaskInfo();
+
+    // The task applies the adapted size itself once the range is issued
+    const auto RangeSize = FMath::Min<int64>(Task.GetNextChunkSize(), Info.TotalSize - Info.CurrentSize);
+
+    if (!FHotUpdateMemory::Get().CanAlloc(RangeSize))
+    {
+        return false;
+    }
+
+    if (RateLimit <= 0)
+    {
+        return true;
+    }
+
+    RefillRateTokens();
+
+    if (RateTokens <= 0.0)
+    {
+        return false;
+    }
+
+    RateTokens -= RangeSize;
+
+    return true;
+}
+
+void FFileDownloadManager::RefillRateTokens()
+{
+    const auto CurrentTime = FPlatformTime::Seconds();
+
+    RateTokens = FMath::Min<double>(RateTokens + (CurrentTime - LastRefillTime) * RateLimit, RateLimit);
+
+    LastRefillTime = CurrentTime;
+}
+
+bool FFileDownloadManager::Tick(float)
+{
+    // Only the tasks held back by the pause, memory or rate gates are visited, in the order they were held back
+    auto WaitingNum = 0;
+
+    auto bCanResume = true;
+
+    for (auto i = 0; i < WaitingTasks.Num(); ++i)
+    {
+        const auto Index = WaitingTasks[i];
+
+        auto& Entry = Tasks[Index];
+
+        if (!Entry.bIsWaiting || !Entry.Task->IsWaitingChunk())
+        {
+            Entry.bIsWaiting = false;
+
+            continue;
+        }
+
+        if (bCanResume && CanRequestChunk(*Entry.Task))
+        {
+            Entry.bIsWaiting = false;
+
+            Entry.Task->ResumeChunk();
+
+            continue;
+        }
+
+        bCanResume = false;
+
+        WaitingTasks[WaitingNum++] = Index;
+    }
+
+    WaitingTasks.SetNum(WaitingNum, false);
+
+    if (LeaseWaitingTasks.Num() > 0 && FPlatformTime::Seconds() - LastLeasePollTime >= LeasePollInterval)
+    {
+        PollLeases();
+    }
+
+    StartPendingTasks();
+
+    HedgeSlowRanges();
+
+#if STATS
+    auto BytesInFlight = 0;
+
+    for (const auto Index : ActiveTasks)
+    {
+        BytesInFlight += Tasks[Index].Task->GetBytesInFlight();
+    }
+
+    SET_DWORD_STAT(STAT_HotUpdate_ActiveRequests, ActiveTasks.Num() - WaitingTasks.Num());
+
+    SET_MEMORY_STAT(STAT_HotUpdate_BytesInFlight, BytesInFlight);
+#endif
+
+    return true;
+}
+
+void FFileDownloadManager::HedgeSlowRanges()
+{
+    // While files are queued a free connection is better spent on them
+    if (HedgePercentile <= 0 || IsHeld() || RateLimit > 0 || NextPendingIndex < PendingTasks.Num() ||
+        RangeLatencies.Num() < MinHedgeSamples)
+    {
+        return;
+    }
+
+    const auto HedgeBudget = static_cast<int64>(TotalDownloadSize) * HedgeBudgetPercent / 100;
+
+    if (HedgedSize >= HedgeBudget)
+    {
+        return;
+    }
+
+    const auto Threshold = FMath::Max<double>(
+        FHotUpdateReport::GetPercentile(RangeLatencies, HedgePercentile / 100.f) / 1000.0, MinHedgeDelay);
+
+    for (const auto Index : ActiveTasks)
+    {
+        const auto& Task = Tasks[Index].Task;
+
+        if (Task->IsHedged() || Task->GetRangeElapsed() < Threshold)
+        {
+            continue;
+        }
+
+        const auto RangeSize = Task->GetRangeSize();
+
+        if (HedgedSize + RangeSize > HedgeBudget || !FHotUpdateMemory::Get().CanAlloc(RangeSize))
+        {
+            continue;
+        }
+
+        if (!Task->Hedge())
+        {
+            continue;
+        }
+
+        HedgedSize += RangeSize;
+
+        ++HedgeNum;
+
+        if (Report.IsValid())
+        {
+            Report->SetCounter(TEXT("Hedges"), HedgeNum);
+
+            Report->SetCounter(TEXT("HedgedBytes"), HedgedSize);
+        }
+    }
+}
+
+void FFileDownloadManager::SetMaxConcurrency(const int32 InMaxConcurrency)
+{
+    MaxConcurrency = FMath::Max(InMaxConcurrency, 0);
+
+    bWasThrottled |= bIsStarted && MaxConcurrency != BaseConcurrency;
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Set max concurrency: %d"), MaxConcurrency);
+
+    StartPendingTasks();
+}
+
+void FFileDownloadManager::SetRateLimit(const int64 InRateLimit)
+{
+    RateLimit = FMath::Max<int64>(InRateLimit, 0);
+
+    bWasThrottled |= bIsStarted && RateLimit > 0;
+
+    RateTokens = 0.0;
+
+    LastRefillTime = FPlatformTime::Seconds();
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Set rate limit: %lld B/s"), RateLimit);
+}
+
+void FFileDownloadManager::SetPaused(const bool bInPaused)
+{
+    bIsPaused = bInPaused;
+
+    OnPauseChanged();
+}
+
+void FFileDownloadManager::SetOnDemandHeld(const bool bInHeld)
+{
+    bIsOnDemandHeld = bInHeld;
+
+    OnPauseChanged();
+}
+
+void FFileDownloadManager::OnPauseChanged()
+{
+    bWasThrottled |= bIsStarted && IsHeld();
+
+    UE_LOG(LogHotUpdate, Log, TEXT("%s download (manual %d, policy %d, on demand %d)"),
+           IsHeld() ? TEXT("Pause") : TEXT("Resume"), bIsPaused, bIsPolicyPaused, bIsOnDemandHeld);
+
+    StartPendingTasks();
+}
+
+void FFileDownloadManager::SetGameplayState(const EHotUpdateGameplayState InState)
+{
+    GameplayState = InState;
+
+    const auto& Policy = GetPolicy(InState);
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Gameplay state: %s"), *UEnum::GetValueAsString(InState));
+
+    SetRateLimit(static_cast<int64>(Policy.RateLimit) * 1024);
+
+    // Pause before the concurrency change so a paused state starts no new file either
+    bIsPolicyPaused = Policy.bPauseNewRanges;
+
+    OnPauseChanged();
+
+    SetMaxConcurrency(Policy.MaxConcurrency);
+}
+
+void FFileDownloadManager::ApplyTuning(const int32 InConcurrency, const int32 InChunkSize)
+{
+    if (InConcurrency > 0)
     {
-        TotalDownloadSize = 0;
+        BaseConcurrency = InConcurrency;
+    }
 
-        CurrentDownloadSize = 0;
+    if (InChunkSize > 0)
+    {
+        PreferredChunkSize = FMath::Clamp(InChunkSize, FDownloadTask::MinChunkSize, FDownloadTask::DefaultChunkSize);
+    }
 
-        for (const auto& Task : Tasks)
-        {
-            TotalDownloadSize += Task.Value->GetTaskInfo().FileSize;
-        }
+    SetGameplayState(GameplayState);
+}
 
-        OnDownloadEvent.ExecuteIfBound(EDownloadState::BEGIN_DOWNLOAD, FTaskInfo());
+FHotUpdateDownloadPolicy FFileDownloadManager::GetPolicy(const EHotUpdateGameplayState InState) const
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
 
-        for (const auto& Task : Tasks)
+    if (HotUpdateSettings != nullptr)
+    {
+        if (const auto Policy = HotUpdateSettings->GameplayPolicies.Find(InState))
         {
-            if(Task.Value->IsPending())
-            {
-                Task.Value->Start();
-            }
+            return *Policy;
         }
     }
-    else
+
+    FHotUpdateDownloadPolicy Policy;
+
+    switch (InState)
     {
-        OnDownloadEvent.ExecuteIfBound(EDownloadState::END_DOWNLOAD, FTaskInfo());
+    case EHotUpdateGameplayState::InMatch:
+        Policy.MaxConcurrency = 1;
+        Policy.RateLimit = 128;
+        break;
+    case EHotUpdateGameplayState::LatencySensitive:
+        Policy.MaxConcurrency = 1;
+        Policy.bPauseNewRanges = true;
+        break;
+    default:
+        Policy.MaxConcurrency = BaseConcurrency;
+        Policy.RateLimit = HotUpdateSettings != nullptr ? HotUpdateSettings->RateLimit : 0;
+        break;
     }
+
+    return Policy;
 }
 
-void FFileDownloadManager::ShutDown()
+FString FFileDownloadManager::GetStatus() const
 {
-    for (const auto& Task : Tasks)
+    auto BytesInFlight = 0;
+
+    for (const auto Index : ActiveTasks)
     {
-        Task.Value->Stop();
+        BytesInFlight += Tasks[Index].Task->GetBytesInFlight();
     }
 
-    Tasks.Empty();
-
-    FailedTasks.Empty();
-
-    ClearTempPak();
+    return FString::Printf(
+        TEXT("Tasks: %d, Pending: %d, Active: %d, Waiting: %d, Succeeded: %d, Failed: %d\n")
+        TEXT("Downloaded: %s / %s, InFlight: %s\n")
+        TEXT("GameplayState: %s, MaxConcurrency: %d, RateLimit: %lld B/s, ")
+        TEXT("Paused: %s (manual %d, policy %d, on demand %d)\n")
+        TEXT("FrameBudget queued: %d, longest: %.2f ms, over budget: %u"),
+        Tasks.Num(), PendingTasks.Num() - NextPendingIndex, ActiveTasks.Num(), WaitingTasks.Num(), SucceededTaskNum,
+        FailedTasks.Num(),
+        *FDownloadProgress::ConvertIntToSize(FMath::Max<int64>(CurrentDownloadSize, 0)),
+        *FDownloadProgress::ConvertIntToSize(TotalDownloadSize),
+        *FDownloadProgress::ConvertIntToSize(BytesInFlight),
+        *UEnum::GetValueAsString(GameplayState), MaxConcurrency, RateLimit, IsHeld() ? TEXT("true") : TEXT("false"),
+        bIsPaused, bIsPolicyPaused, bIsOnDemandHeld,
+        FHotUpdateFrameBudget::Get().GetQueuedNum(), FHotUpdateFrameBudget::Get().GetLongestFrameTime(),
+        FHotUpdateFrameBudget::Get().GetOverBudgetFrames());
 }
 
-FString FFileDownloadManager::GetTempPakSaveRoot()
+void FFileDownloadManager::OnAllTaskFinish() const
 {
-    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+    const auto& EndTime = FDateTime::Now();
 
-#if PLATFORM_DESKTOP &&  WITH_EDITOR
-    return FPaths::Combine(FPaths::ProjectSavedDir(),
-                           HotUpdateSettings != nullptr ? HotUpdateSettings->TempPakSaveRoot : "");
-#else
-	return FPaths::Combine(FPaths::RootDir(), HotUpdateSettings != nullptr ? HotUpdateSettings->TempPakSaveRoot : "");
-#endif
+    UE_LOG(LogHotUpdate, Display, TEXT("download finish use:%s, succeeded: %d, failed: %d"),
+           *(EndTime - StartTime).ToString(), SucceededTaskNum, FailedTasks.Num());
+
+    HOTUPDATE_TRACE_BOOKMARK(TEXT("HotUpdate All Downloads Finished"));
+
+    SET_DWORD_STAT(STAT_HotUpdate_ActiveRequests, 0);
+
+    SET_MEMORY_STAT(STAT_HotUpdate_BytesInFlight, 0);
+
+    OnDownloadEvent.ExecuteIfBound(EDownloadState::END_DOWNLOAD, FTaskInfo());
 }
 
-FString FFileDownloadManager::GetPakSaveRoot()
+void FFileDownloadManager::AddTask(const FString& URL, const FString& Name, const int32 Size, const FString& Hash)
 {
-    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
-
-#if PLATFORM_DESKTOP &&  WITH_EDITOR
-    return FPaths::Combine(FPaths::ProjectSavedDir(),
-                           HotUpdateSettings != nullptr ? HotUpdateSettings->PakSaveRoot : "");
-#else
-	return FPaths::Combine(FPaths::RootDir(), HotUpdateSettings != nullptr ? HotUpdateSettings->PakSaveRoot : "");
-#endif
+    AddTask(URL, FPakFileProperty(Name, Size, Hash));
 }
 
-bool FFileDownloadManager::IsSuccessful() const
+void FFileDownloadManager::AddTask(const FString& URL, const FPakFileProperty& PakInfo)
 {
-    auto bIsSuccessful = true;
+    HOTUPDATE_LLM_SCOPE();
+
+    const auto& Name = PakInfo.PakName;
+
+    const auto Size = PakInfo.PakSize;
+
+    const auto& Hash = PakInfo.MD5;
+
+    const auto& ContentKey = FManifestPlanner::GetContentKey(Hash, Size);
 
-    for (const auto& Task : Tasks)
+    if (!Hash.IsEmpty())
     {
-        if (!Task.Value->IsFinished())
+        if (const auto Index = ContentIndices.Find(ContentKey))
         {
-            bIsSuccessful = false;
+            auto& Entry = Tasks[*Index];
 
-            break;
+            UE_LOG(LogHotUpdate, Log, TEXT("%s has the same content as %s, fetch once"), *Name,
+                   *Entry.Task->GetTaskInfo().FileName);
+
+            Entry.Aliases.Add(Name);
+
+            FoldedTaskNum++;
+
+            return;
         }
     }
 
-    return bIsSuccessful && FailedTasks.Num() <= 0;
-}
-
-void FFileDownloadManager::OnTaskFinish(const FTaskInfo& Info, const bool bIsSuccess)
-{
-    CurrentDownloadSize += Info.DownloadSize;
-    
-    const auto& Value = Tasks.FindRef(Info.GUID);
+    const auto Index = AddTaskEntry(MakeShared<FDownloadTask>(URL, GetTempPakSaveRoot(), Name, Size), Size);
 
-    if(!Value.IsValid())
+    if (Index == INDEX_NONE)
     {
-        UE_LOG(LogHotUpdate, Warning, TEXT("Value is not valid:%s"), *Info.FileName);
         return;
     }
 
-    if (bIsSuccess)
+    Tasks[Index].PakInfo = PakInfo;
+
+    if (!Hash.IsEmpty())
     {
-        const auto& TempFile = FPaths::Combine(GetTempPakSaveRoot(), Info.FileName);
+        ContentIndices.Add(ContentKey, Index);
+    }
+}
 
-        if (!IFileManager::Get().FileExists(*TempFile))
-        {
-            UE_LOG(LogHotUpdate, Error, TEXT("File doesn't exist after download success : %s"), *TempFile);
-        }
-        else
-        {
-            const auto& File = FPaths::Combine(GetPakSaveRoot(), Info.FileName);
+void FFileDownloadManager::AddRepairTask(const FString& URL, const FPakFileProperty& PakInfo,
+                                         const TArray<int32>& Blocks)
+{
+    HOTUPDATE_LLM_SCOPE();
 
-            if (!IFileManager::Get().Move(*File, *TempFile, true, false, false, true))
-            {
-                UE_LOG(LogHotUpdate, Error, TEXT("Failed to move file from %s to %s"), *TempFile, *File);
-            }
-        }
-    }
-    else
+    const auto Task = MakeShared<FDownloadTask>(URL, GetTempPakSaveRoot(), PakInfo.PakName, PakInfo.PakSize);
+
+    Task->SetRepair(FPaths::Combine(GetPakSaveRoot(), PakInfo.PakName), PakInfo, Blocks);
+
+    const auto Index = AddTaskEntry(Task, Task->GetRepairSize());
+
+    if (Index != INDEX_NONE)
     {
-        FailedTasks.Add(Value);
+        Tasks[Index].PakInfo = PakInfo;
     }
+}
+
+void FFileDownloadManager::AddLocalCopy(const FString& URL, const FPakFileProperty& PakInfo, const FString& SourceFile)
+{
+    const auto& File = FPaths::Combine(GetPakSaveRoot(), PakInfo.PakName);
 
-    for (const auto& Task : Tasks)
+    CopyFiles(SourceFile, {File}, [this, URL, PakInfo, SourceFile](const bool bIsCopied)
     {
-        if (Task.Value->IsPending())
+        if (bIsCopied)
         {
-            Task.Value->Start();
+            UE_LOG(LogHotUpdate, Log, TEXT("Copy %s from local %s"), *PakInfo.PakName, *SourceFile);
+
+            return;
         }
-    }
-}
 
-void FFileDownloadManager::OnAllTaskFinish() const
-{
-    const auto& EndTime = FDateTime::Now();
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to copy %s from %s, download it"), *PakInfo.PakName, *SourceFile);
 
-    UE_LOG(LogHotUpdate, Display, TEXT("download finish use:%s"), *(EndTime - StartTime).ToString());
+        AddTask(URL, PakInfo);
 
-    OnDownloadEvent.ExecuteIfBound(EDownloadState::END_DOWNLOAD, FTaskInfo());
+        if (bIsStarted)
+        {
+            StartPendingTasks();
+        }
+    });
 }
 
-void FFileDownloadManager::AddTask(const FString& URL, const FString& Name, const int32 Size)
+int32 FFileDownloadManager::AddTaskEntry(const TSharedRef<FDownloadTask>& Task, const int64 Size)
 {
-    auto Task = MakeShared<FDownloadTask>(URL, GetTempPakSaveRoot(), Name, Size);
-
-    if (Tasks.Contains(Task->GetGuid()))
+    if (TaskIndices.Contains(Task->GetGuid()))
     {
-        return;
+        return INDEX_NONE;
     }
 
     Task->OnTaskEvent.BindRaw(this, &FFileDownloadManager::OnTaskEvent);
 
-    Tasks.Add(Task->GetGuid(), Task);
+    Task->OnCanRequestChunk.BindRaw(this, &FFileDownloadManager::OnCanRequestChunk);
+
+    const auto Index = Tasks.Emplace(Task);
+
+    TaskIndices.Add(Task->GetGuid(), Index);
+
+    PendingTasks.Add(Index);
+
+    TotalDownloadSize += Size;
+
+    if (bIsStarted)
+    {
+        StartPendingTasks();
+    }
+
+    return Index;
 }
 
 
@@ -167,21 +905,68 @@ void FFileDownloadManager::OnTaskEvent(const EDownloadTaskEvent InEvent, const F
     {
     case EDownloadTaskEvent::BEGIN_DOWNLOAD:
         {
+            if (Report.IsValid())
+            {
+                Report->OnFileBegin(InInfo.FileName);
+            }
+
             OnDownloadEvent.Execute(EDownloadState::BEGIN_FILE_DOWNLOAD, InInfo);
         }
         break;
+    case EDownloadTaskEvent::END_RANGE:
+        {
+            if (RangeLatencies.Num() < MaxLatencySamples)
+            {
+                RangeLatencies.Add(InInfo.RangeLatency);
+            }
+            else
+            {
+                RangeLatencies[NextLatencyIndex] = InInfo.RangeLatency;
+
+                NextLatencyIndex = (NextLatencyIndex + 1) % MaxLatencySamples;
+            }
+
+            if (Report.IsValid())
+            {
+                Report->OnRangeEnd(InInfo.FileName, InInfo.RangeLatency);
+            }
+        }
+        break;
     case EDownloadTaskEvent::UPDATE_DOWNLOAD:
         {
-            const auto CurrentTime = GWorld->GetTimeSeconds();
+            const auto Index = FindTask(InInfo.GUID);
+
+            if (Index != INDEX_NONE)
+            {
+                auto& Entry = Tasks[Index];
+
+                CurrentDownloadSize += InInfo.DownloadSize - Entry.DownloadSize;
 
-            if (CurrentTime <= LastUpdateTime)
+                Entry.DownloadSize = InInfo.DownloadSize;
+            }
+
+            const auto CurrentTime = FPlatformTime::Seconds();
+
+            if (CurrentTime - LastUpdateTime < ProgressUpdateInterval)
             {
                 return;
             }
 
             LastUpdateTime = CurrentTime;
 
-            OnDownloadEvent.Execute(EDownloadState::UPDATE_DOWNLOAD, InInfo);
+            if (bIsProgressQueued)
+            {
+                return;
+            }
+
+            bIsProgressQueued = true;
+
+            FHotUpdateFrameBudget::Get().Enqueue(this, [this, InInfo]()
+            {
+                bIsProgressQueued = false;
+
+                OnDownloadEvent.Execute(EDownloadState::UPDATE_DOWNLOAD, InInfo);
+            });
         }
         break;
     case EDownloadTaskEvent::END_DOWNLOAD:
@@ -192,7 +977,7 @@ void FFileDownloadManager::OnTaskEvent(const EDownloadTaskEvent InEvent, const F
 
             OnTaskFinish(InInfo, true);
 
-            if (IsSuccessful())
+            if (IsAllTaskFinished())
             {
                 UE_LOG(LogHotUpdate, Log, TEXT("All tasks download finish"));
 
@@ -205,6 +990,11 @@ void FFileDownloadManager::OnTaskEvent(const EDownloadTaskEvent InEvent, const F
             UE_LOG(LogHotUpdate, Log, TEXT("%s download failed"), *InInfo.URL);
 
             OnTaskFinish(InInfo, false);
+
+            if (IsAllTaskFinished())
+            {
+                OnAllTaskFinish();
+            }
         }
         break;
     default:
@@ -220,12 +1010,40 @@ void FFileDownloadManager::ClearTempPak()
 
     auto& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 
+#if PLATFORM_ANDROID
+	if (!PlatformFile.GetLowerLevel()->DirectoryExists(*SearchPath))
+#else
+    if (!PlatformFile.DirectoryExists(*SearchPath))
+#endif
+    {
+        if (!PlatformFile.CreateDirectoryTree(*SearchPath))
+        {
+            UE_LOG(LogHotUpdate, Warning, TEXT("Cannot create directory : %s"), *SearchPath);
+        }
+
+        return;
+    }
+
     PlatformFile.FindFiles(Files, *SearchPath, TEXT(".pak"));
 
     PlatformFile.FindFiles(Files, *SearchPath, *FDownloadTask::TempFileExtension);
 
     for (const auto& File : Files)
     {
+        auto Name = FPaths::GetCleanFilename(File);
+
+        Name.RemoveFromEnd(FDownloadTask::TempFileExtension);
+
+        // Held by another process, the file is still being written
+        TSharedPtr<FHotUpdateLease> Lease;
+
+        if (!AcquireLease(Name, Lease))
+        {
+            UE_LOG(LogHotUpdate, Log, TEXT("Keep file fetched by another process: %s"), *File);
+
+            continue;
+        }
+
         if (PlatformFile.DeleteFile(*File))
         {
             UE_LOG(LogHotUpdate, Log, TEXT("Success to delete file: %s"), *File);
@@ -237,26 +1055,214 @@ void FFileDownloadManager::ClearTempPak()
     }
 }
 
-FDownloadProgress FFileDownloadManager::GetDownloadProgress()
+bool FFileDownloadManager::AcquireLease(const FString& Name, TSharedPtr<FHotUpdateLease>& OutLease)
+{
+    OutLease = FHotUpdateLease::TryAcquire(GetLockPath(Name));
+
+    return OutLease.IsValid();
+}
+
+FString FFileDownloadManager::GetLockPath(const FString& Name)
+{
+    return FPaths::Combine(GetTempPakSaveRoot(), Name + TEXT(".lock"));
+}
+
+bool FFileDownloadManager::TakeLease(const int32 Index)
+{
+    auto& Entry = Tasks[Index];
+
+    const auto& Name = Entry.Task->GetTaskInfo().FileName;
+
+    if (Entry.Lease.IsValid() || AcquireLease(Name, Entry.Lease))
+    {
+        return true;
+    }
+
+    UE_LOG(LogHotUpdate, Log, TEXT("%s is fetched by another process, wait for it"), *Name);
+
+    LeaseWaitingTasks.Add(Index);
+
+    return false;
+}
+
+void FFileDownloadManager::PollLeases()
+{
+    LastLeasePollTime = FPlatformTime::Seconds();
+
+    auto WaitingNum = 0;
+
+    auto bIsRequeued = false;
+
+    for (auto i = 0; i < LeaseWaitingTasks.Num(); ++i)
+    {
+        const auto Index = LeaseWaitingTasks[i];
+
+        auto& Entry = Tasks[Index];
+
+        if (!AcquireLease(Entry.Task->GetTaskInfo().FileName, Entry.Lease))
+        {
+            LeaseWaitingTasks[WaitingNum++] = Index;
+
+            continue;
+        }
+
+        if (Entry.PakInfo.IsSet())
+        {
+            CheckPeer(Index);
+
+            continue;
+        }
+
+        UE_LOG(LogHotUpdate, Log, TEXT("Another process released %s without installing it, download it"),
+               *Entry.Task->GetTaskInfo().FileName);
+
+        PendingTasks.Add(Index);
+
+        bIsRequeued = true;
+    }
+
+    LeaseWaitingTasks.SetNum(WaitingNum, false);
+
+    if (bIsRequeued)
+    {
+        StartPendingTasks();
+    }
+}
+
+void FFileDownloadManager::CheckPeer(const int32 Index)
 {
-    const auto CurrentTime = GWorld->GetTimeSeconds();
+    auto& Entry = Tasks[Index];
 
-    auto CurrentDownSize = 0;
+    Entry.bIsPeerChecking = true;
 
-    for (const auto& Task : Tasks)
+    const TWeakPtr<int32, ESPMode::ThreadSafe> WeakToken = PeerCheckToken;
+
+    const auto Guid = Entry.Task->GetGuid();
+
+    const auto PakInfo = Entry.PakInfo.GetValue();
+
+    const auto bIsRepair = Entry.Task->IsRepair();
+
+    Async(EAsyncExecution::ThreadPool, [this, WeakToken, Guid, PakInfo, bIsRepair]()
+    {
+        const auto bIsPlaced = IsPlacedByPeer(PakInfo, bIsRepair);
+
+        AsyncTask(ENamedThreads::GameThread, [this, WeakToken, Guid, bIsPlaced]()
+        {
+            if (WeakToken.IsValid())
+            {
+                OnPeerChecked(Guid, bIsPlaced);
+            }
+        });
+    });
+}
+
+void FFileDownloadManager::OnPeerChecked(const FGuid& Guid, const bool bIsPlaced)
+{
+    const auto Index = FindTask(Guid);
+
+    if (Index == INDEX_NONE || !Tasks[Index].bIsPeerChecking)
+    {
+        return;
+    }
+
+    auto& Entry = Tasks[Index];
+
+    Entry.bIsPeerChecking = false;
+
+    if (bIsPlaced)
+    {
+        FinishFromPeer(Index);
+    }
+    else
+    {
+        UE_LOG(LogHotUpdate, Log, TEXT("Another process released %s without installing it, download it"),
+               *Entry.Task->GetTaskInfo().FileName);
+
+        PendingTasks.Add(Index);
+
+        StartPendingTasks();
+    }
+
+    if (IsAllTaskFinished())
+    {
+        OnAllTaskFinish();
+    }
+}
+
+bool FFileDownloadManager::IsPlacedByPeer(const FPakFileProperty& PakInfo, const bool bIsRepair)
+{
+    const auto& File = FPaths::Combine(GetPakSaveRoot(), PakInfo.PakName);
+
+    if (IFileManager::Get().FileSize(*File) != PakInfo.PakSize)
+    {
+        return false;
+    }
+
+    // A damaged copy has the right size too, a repair only counts once no block is bad any more
+    if (bIsRepair)
+    {
+        TArray<int32> BadBlocks;
+
+        return FPakVerifier::FindBadBlocks(PakInfo, BadBlocks) && BadBlocks.Num() <= 0;
+    }
+
+    // The index hash is enough here, the configured verify tier still runs before mount
+    if (!PakInfo.IndexHash.IsEmpty())
+    {
+        return FPakVerifier::VerifyIndex(File, PakInfo);
+    }
+
+    return FPakVerifier::Get().Verify(PakInfo);
+}
+
+void FFileDownloadManager::FinishFromPeer(const int32 Index)
+{
+    auto& Entry = Tasks[Index];
+
+    const auto& Info = Entry.Task->GetTaskInfo();
+
+    UE_LOG(LogHotUpdate, Log, TEXT("%s was installed by another process"), *Info.FileName);
+
+    CopyAliases(FPaths::Combine(GetPakSaveRoot(), Info.FileName), Entry.Aliases);
+
+    Entry.Lease.Reset();
+
+    const auto Size = static_cast<int32>(Entry.Task->IsRepair() ? Entry.Task->GetRepairSize() : Info.FileSize);
+
+    CurrentDownloadSize += Size - Entry.DownloadSize;
+
+    Entry.DownloadSize = Size;
+
+    SucceededTaskNum++;
+
+    PeerTaskNum++;
+
+    if (Report.IsValid())
     {
-        CurrentDownSize += Task.Value->GetTaskInfo().DownloadSize;
+        Report->SetCounter(TEXT("PeerDownloads"), PeerTaskNum);
     }
 
-    FDownloadProgress DownloadProgress(CurrentDownSize, TotalDownloadSize,
-                                       FDownloadProgress::ConvertIntToSize(
-                                           (CurrentDownSize - LastDownloadedSize) /
-                                           (CurrentTime - LastUpdateTime)).
+    HOTUPDATE_TRACE_COUNTER_ADD(HotUpdate_FinishedTasks, 1);
+
+    OnDownloadEvent.ExecuteIfBound(EDownloadState::END_FILE_DOWNLOAD, Info);
+}
+
+FDownloadProgress FFileDownloadManager::GetDownloadProgress()
+{
+    const auto CurrentTime = FPlatformTime::Seconds();
+
+    const auto DeltaTime = CurrentTime - LastProgressTime;
+
+    const auto Speed = DeltaTime > 0.0 ? (CurrentDownloadSize - LastDownloadedSize) / DeltaTime : 0.0;
+
+    FDownloadProgress DownloadProgress(CurrentDownloadSize, TotalDownloadSize,
+                                       FDownloadProgress::ConvertIntToSize(FMath::Max(Speed, 0.0)).
                                        Append(TEXT("/s")));
 
-    LastDownloadedSize = CurrentDownSize;
+    LastDownloadedSize = CurrentDownloadSize;
 
-    LastUpdateTime = CurrentTime;
+    LastProgressTime = CurrentTime;
 
     return DownloadProgress;
 }
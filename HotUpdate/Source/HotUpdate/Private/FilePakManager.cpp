@@ -4,6 +4,13 @@
 #include "FileDownLog.h"
 #include "Launch/Resources/Version.h"
 #include "ShaderCodeLibrary.h"
+#include "HotUpdateTrace.h"
+#include "HotUpdateFrameBudget.h"
+#include "HotUpdateStats.h"
+#include "HotUpdateMemory.h"
+#include "Async/Async.h"
+#include "PakVerifier.h"
+#include "HAL/IConsoleManager.h"
 
 DEFINE_LOG_CATEGORY(LogHotUpdate);
 
@@ -13,78 +20,232 @@ FFilePakManager::FFilePakManager() : PakPlatformFile(nullptr)
 
 void FFilePakManager::StartUp()
 {
-    if (PakPlatformFile == nullptr)
+    HOTUPDATE_TRACE_COUNTER_SET(HotUpdate_MountedPaks, 0);
+
+    if (bIsMountEnabled)
     {
-        PakPlatformFile = new FPakPlatformFile();
+        if (PakPlatformFile == nullptr)
+        {
+            PakPlatformFile = new FPakPlatformFile();
+        }
+
+        PakPlatformFile->SetLowerLevel(&(FPlatformFileManager::Get().GetPlatformFile()));
+
+        if (RemotePakPlatformFile.IsValid() && RemotePakNames.Num() > 0)
+        {
+            RemotePakPlatformFile->Initialize(PakPlatformFile->GetLowerLevel(), TEXT(""));
+
+            RemotePakPlatformFile->SetPrefetchPaused(bIsPrefetchPaused);
+
+            PakPlatformFile->SetLowerLevel(RemotePakPlatformFile.Get());
+
+            bIsRemotePakChained = true;
+
+            // The pak precacher reads from the physical file it was created with, async reads have to go through
+            // OpenRead to reach the remote paks
+            if (const auto PakCacheVar = IConsoleManager::Get().FindConsoleVariable(TEXT("pakcache.Enable")))
+            {
+                PakCacheEnable = PakCacheVar->GetInt();
+
+                PakCacheVar->Set(0, ECVF_SetByCode);
+            }
+        }
+
+        PakPlatformFile->InitializeNewAsyncIO();
+
+        FPlatformFileManager::Get().SetPlatformFile(*PakPlatformFile);
     }
 
-    PakPlatformFile->SetLowerLevel(&(FPlatformFileManager::Get().GetPlatformFile()));
+    MountIndex = 0;
 
-    PakPlatformFile->InitializeNewAsyncIO();
+    bIsMounting = true;
 
-    FPlatformFileManager::Get().SetPlatformFile(*PakPlatformFile);
+    VerifyNextPak();
+}
 
-    for (auto i = 0; i < PakFiles.Num(); ++i)
+void FFilePakManager::VerifyNextPak()
+{
+    while (PakFiles.IsValidIndex(MountIndex) && FPaths::GetExtension(PakFiles[MountIndex].PakName) != TEXT("pak"))
     {
-        const auto& PakName = PakFiles[i].PakName;
+        MountIndex++;
+    }
 
-        if (FPaths::GetExtension(PakName) != TEXT("pak"))
+    if (!PakFiles.IsValidIndex(MountIndex))
+    {
+        FHotUpdateFrameBudget::Get().Enqueue(this, [this]()
         {
-            continue;
-        }
+            OnMountFinish();
+        });
+
+        return;
+    }
 
-        auto bRet = IsPakValid(PakFiles[i]);
+    const auto PakFileProperty = PakFiles[MountIndex];
 
-        if (!bRet)
+    // Remote paks are checked block by block as they arrive
+    if (bIsMountEnabled && RemotePakNames.Contains(PakFileProperty.PakName))
+    {
+        FHotUpdateFrameBudget::Get().Enqueue(this, [this]()
         {
-            UE_LOG(LogHotUpdate, Warning, TEXT("Failed to verify pak before mount: %s"), *PakName);
+            MountPak();
+        });
 
-            FailedPakList.Add(PakFiles[i]);
+        return;
+    }
 
-            PakFiles.RemoveAt(i--);
+    const TWeakPtr<int32, ESPMode::ThreadSafe> WeakToken = VerifyToken;
 
-            continue;
-        }
+    Async(EAsyncExecution::ThreadPool, [this, WeakToken, PakFileProperty]()
+    {
+        const auto StartTime = FPlatformTime::Seconds();
 
-        const auto& PakPath = FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), PakName);
+        const auto bIsValid = IsPakValid(PakFileProperty);
 
-        FPakFile PakFile(PakPlatformFile, *PakPath, false);
+        const auto VerifyTime = FPlatformTime::Seconds() - StartTime;
 
-        const auto& MountPoint = PakFile.GetMountPoint();
+        AsyncTask(ENamedThreads::GameThread, [this, WeakToken, bIsValid, VerifyTime]()
+        {
+            if (WeakToken.IsValid())
+            {
+                OnPakVerified(bIsValid, VerifyTime);
+            }
+        });
+    });
+}
 
-        UE_LOG(LogHotUpdate, Display, TEXT("pak {%s} MountPoint at {%s}"), *PakPath, *MountPoint);
+void FFilePakManager::OnPakVerified(const bool bIsValid, const double VerifyTime)
+{
+    if (!bIsMounting || !PakFiles.IsValidIndex(MountIndex))
+    {
+        return;
+    }
 
-        bRet = PakPlatformFile->Mount(*PakPath, 0);
+    const auto& PakName = PakFiles[MountIndex].PakName;
 
-        if (!bRet)
-        {
-            FailedPakList.Add(PakFiles[i]);
+    if (Report.IsValid())
+    {
+        Report->AddVerifyTime(PakName, VerifyTime);
+    }
 
-            UE_LOG(LogHotUpdate, Error, TEXT("Failed to mount pak: %s"), *PakPath);
-        }
-        else
-        {
-            UE_LOG(LogHotUpdate, Display, TEXT("Success to mount pak: %s"), *PakPath);
+    if (!bIsValid)
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to verify pak before mount: %s"), *PakName);
 
-            UpdateMountProgress(i);
-        }
+        FailedPakList.Add(PakFiles[MountIndex]);
+
+        PakFiles.RemoveAt(MountIndex);
+
+        VerifyNextPak();
+
+        return;
+    }
+
+    if (!bIsMountEnabled)
+    {
+        UpdateMountProgress(MountIndex);
+
+        MountIndex++;
+
+        VerifyNextPak();
+
+        return;
+    }
+
+    FHotUpdateFrameBudget::Get().Enqueue(this, [this]()
+    {
+        MountPak();
+    });
+}
+
+void FFilePakManager::MountPak()
+{
+    const auto& PakName = PakFiles[MountIndex].PakName;
+
+    const auto& PakPath = FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), PakName);
+
+    HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.Mount %s"), *PakName);
+
+    SCOPE_CYCLE_COUNTER(STAT_HotUpdate_MountPak);
+
+    HOTUPDATE_LLM_SCOPE();
+
+    FPakFile PakFile(PakPlatformFile, *PakPath, false);
+
+    const auto& MountPoint = PakFile.GetMountPoint();
+
+    UE_LOG(LogHotUpdate, Display, TEXT("pak {%s} MountPoint at {%s}"), *PakPath, *MountPoint);
+
+    const auto StartTime = FPlatformTime::Seconds();
+
+    const auto bRet = PakPlatformFile->Mount(*PakPath, 0);
+
+    SET_FLOAT_STAT(STAT_HotUpdate_MountTime, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+    if (Report.IsValid())
+    {
+        Report->AddMountTime(PakName, FPlatformTime::Seconds() - StartTime);
     }
 
+    if (!bRet)
+    {
+        FailedPakList.Add(PakFiles[MountIndex]);
+
+        UE_LOG(LogHotUpdate, Error, TEXT("Failed to mount pak: %s"), *PakPath);
+    }
+    else
+    {
+        UE_LOG(LogHotUpdate, Display, TEXT("Success to mount pak: %s"), *PakPath);
+
+        HOTUPDATE_TRACE_COUNTER_ADD(HotUpdate_MountedPaks, 1);
+
+        MountedIndexSize += PakFile.GetInfo().IndexSize;
+
+        FHotUpdateMemory::Get().Alloc(EHotUpdateMemoryStage::Mount, PakFile.GetInfo().IndexSize);
+
+        UpdateMountProgress(MountIndex);
+    }
+
+    MountIndex++;
+
+    VerifyNextPak();
+}
+
+void FFilePakManager::OnMountFinish()
+{
 #if ENGINE_MAJOR_VERSION >= 4 && ENGINE_MINOR_VERSION >= 25
+    if (bIsMountEnabled)
+    {
+        HOTUPDATE_TRACE_SCOPE(HotUpdate_OpenShaderLibrary);
+
 #if PLATFORM_IOS || PLATFORM_MAC
-    FShaderCodeLibrary::OpenLibrary("Global", FPaths::Combine(FPaths::ProjectContentDir(), "Metal"));
+        FShaderCodeLibrary::OpenLibrary("Global", FPaths::Combine(FPaths::ProjectContentDir(), "Metal"));
 
-    FShaderCodeLibrary::OpenLibrary(FApp::GetProjectName(), FPaths::Combine(FPaths::ProjectContentDir(), "Metal"));
+        FShaderCodeLibrary::OpenLibrary(FApp::GetProjectName(), FPaths::Combine(FPaths::ProjectContentDir(), "Metal"));
 #else
-    FShaderCodeLibrary::OpenLibrary("Global", FPaths::ProjectContentDir());
+        FShaderCodeLibrary::OpenLibrary("Global", FPaths::ProjectContentDir());
 
-    FShaderCodeLibrary::OpenLibrary(FApp::GetProjectName(), FPaths::ProjectContentDir());
+        FShaderCodeLibrary::OpenLibrary(FApp::GetProjectName(), FPaths::ProjectContentDir());
 #endif
+    }
 #endif
+
+    bIsMounting = false;
+
+    OnMountFinished.ExecuteIfBound(IsSuccessful());
 }
 
 void FFilePakManager::ShutDown()
 {
+    FHotUpdateFrameBudget::Get().Cancel(this);
+
+    bIsMounting = false;
+
+    VerifyToken = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+    FHotUpdateMemory::Get().Free(EHotUpdateMemoryStage::Mount, MountedIndexSize);
+
+    MountedIndexSize = 0;
+
     PakFiles.Empty();
 
     FailedPakList.Empty();
@@ -102,6 +263,31 @@ void FFilePakManager::ShutDown()
 
         PakPlatformFile = nullptr;
     }
+
+    if (RemotePakPlatformFile.IsValid())
+    {
+        // Its lower level stays set, the layer keeps installing through it once out of the chain
+        if (bIsRemotePakChained)
+        {
+            FPlatformFileManager::Get().RemovePlatformFile(RemotePakPlatformFile.Get());
+        }
+
+        RemotePakPlatformFile = nullptr;
+    }
+
+    bIsRemotePakChained = false;
+
+    RemotePakNames.Empty();
+
+    if (PakCacheEnable != INDEX_NONE)
+    {
+        if (const auto PakCacheVar = IConsoleManager::Get().FindConsoleVariable(TEXT("pakcache.Enable")))
+        {
+            PakCacheVar->Set(PakCacheEnable, ECVF_SetByCode);
+        }
+
+        PakCacheEnable = INDEX_NONE;
+    }
 }
 
 bool FFilePakManager::IsSuccessful() const
@@ -125,29 +311,37 @@ void FFilePakManager::UpdateMountProgress(const int CurrentIndex)
 
 bool FFilePakManager::IsPakValid(const FPakFileProperty& PakInfo)
 {
-    const auto PakPath = FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), PakInfo.PakName);
+    return FPakVerifier::Get().Verify(PakInfo);
+}
 
-    if (!IFileManager::Get().FileExists(*PakPath))
-    {
-        return false;
-    }
+void FFilePakManager::AddPakFile(FPakFileProperty&& PakFileProperty)
+{
+    PakFiles.Add(MoveTemp(PakFileProperty));
+}
 
-    if (IFileManager::Get().FileSize(*PakPath) != PakInfo.PakSize)
+void FFilePakManager::AddRemotePak(const FString& URL, const FPakFileProperty& PakFileProperty)
+{
+    if (!RemotePakPlatformFile.IsValid())
     {
-        return false;
+        RemotePakPlatformFile = MakeShared<FRemotePakPlatformFile>();
     }
 
-    const auto& Hash = FMD5Hash::HashFile(*PakPath);
+    RemotePakPlatformFile->AddRemotePak(URL, PakFileProperty);
 
-    if (!Hash.IsValid())
+    RemotePakNames.Add(PakFileProperty.PakName);
+}
+
+void FFilePakManager::SetPrefetchPaused(const bool bInPaused)
+{
+    bIsPrefetchPaused = bInPaused;
+
+    if (RemotePakPlatformFile.IsValid())
     {
-        return false;
+        RemotePakPlatformFile->SetPrefetchPaused(bInPaused);
     }
-
-    return (BytesToHex(Hash.GetBytes(), Hash.GetSize()) == PakInfo.MD5);
 }
 
-void FFilePakManager::AddPakFile(FPakFileProperty&& PakFileProperty)
+void FFilePakManager::SetReport(const TSharedPtr<FHotUpdateReport>& InReport)
 {
-    PakFiles.Add(MoveTemp(PakFileProperty));
+    Report = InReport;
 }
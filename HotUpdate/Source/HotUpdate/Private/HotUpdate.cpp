@@ -3,13 +3,57 @@
 #include "HotUpdate.h"
 #include "Settings/Public/ISettingsModule.h"
 #include "HotUpdateSettings.h"
+#include "HotUpdateTrace.h"
+#include "HotUpdateStats.h"
+#include "HotUpdateMemory.h"
+#include "HotUpdateFileIO.h"
 
 #define LOCTEXT_NAMESPACE "FHotUpdateModule"
 
+DEFINE_STAT(STAT_HotUpdate_WriteChunk);
+
+DEFINE_STAT(STAT_HotUpdate_TaskFinish);
+
+DEFINE_STAT(STAT_HotUpdate_MountPak);
+
+DEFINE_STAT(STAT_HotUpdate_FrameBudget);
+
+DEFINE_STAT(STAT_HotUpdate_ActiveRequests);
+
+DEFINE_STAT(STAT_HotUpdate_QueuedTasks);
+
+DEFINE_STAT(STAT_HotUpdate_WriteQueueDepth);
+
+DEFINE_STAT(STAT_HotUpdate_BytesInFlight);
+
+DEFINE_STAT(STAT_HotUpdate_HashThroughput);
+
+DEFINE_STAT(STAT_HotUpdate_MountTime);
+
+#if HOTUPDATE_TRACE_ENABLED
+UE_TRACE_CHANNEL_DEFINE(HotUpdateChannel);
+
+TRACE_DECLARE_INT_COUNTER(HotUpdate_InFlightRequests, TEXT("HotUpdate/InFlightRequests"));
+
+TRACE_DECLARE_INT_COUNTER(HotUpdate_DownloadedBytes, TEXT("HotUpdate/DownloadedBytes"));
+
+TRACE_DECLARE_INT_COUNTER(HotUpdate_FinishedTasks, TEXT("HotUpdate/FinishedTasks"));
+
+TRACE_DECLARE_INT_COUNTER(HotUpdate_MountedPaks, TEXT("HotUpdate/MountedPaks"));
+
+TRACE_DECLARE_FLOAT_COUNTER(HotUpdate_RangeLatencyMs, TEXT("HotUpdate/RangeLatencyMs"));
+
+TRACE_DECLARE_FLOAT_COUNTER(HotUpdate_FrameWorkMs, TEXT("HotUpdate/FrameWorkMs"));
+
+TRACE_DECLARE_MEMORY_COUNTER(HotUpdate_TrackedMemory, TEXT("HotUpdate/TrackedMemory"));
+#endif
+
 void FHotUpdateModule::StartupModule()
 {
     // This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
     RegisterSettings();
+
+    FHotUpdateMemory::RegisterTag();
 }
 
 void FHotUpdateModule::ShutdownModule()
@@ -17,6 +61,8 @@ void FHotUpdateModule::ShutdownModule()
     // This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
     // we call this function before unloading the module.
     UnregisterSettings();
+
+    FHotUpdateFileIO::ShutDown();
 }
 
 void FHotUpdateModule::RegisterSettings() const
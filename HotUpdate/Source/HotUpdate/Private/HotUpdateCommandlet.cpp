@@ -0,0 +1,127 @@
+#include "HotUpdateCommandlet.h"
+#include "HotUpdateSubsystem.h"
+#include "HotUpdateSettings.h"
+#include "FileDownLog.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "UObject/Package.h"
+
+namespace HotUpdateCommandlet
+{
+    static const int32 DefaultConcurrency = 16;
+
+    static const double StatusInterval = 5.0;
+}
+
+UHotUpdateCommandlet::UHotUpdateCommandlet()
+{
+    IsClient = false;
+
+    IsServer = false;
+
+    IsEditor = false;
+
+    LogToConsole = true;
+}
+
+int32 UHotUpdateCommandlet::Main(const FString& Params)
+{
+    FString Version;
+
+    FString Platform;
+
+    FString ServerUrl;
+
+    auto Concurrency = HotUpdateCommandlet::DefaultConcurrency;
+
+    auto Rate = 0;
+
+    FParse::Value(*Params, TEXT("Version="), Version);
+
+    FParse::Value(*Params, TEXT("Platform="), Platform);
+
+    FParse::Value(*Params, TEXT("Server="), ServerUrl);
+
+    const auto bHasConcurrency = FParse::Value(*Params, TEXT("Concurrency="), Concurrency);
+
+    FParse::Value(*Params, TEXT("Rate="), Rate);
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings != nullptr)
+    {
+        if (!ServerUrl.IsEmpty())
+        {
+            HotUpdateSettings->HotUpdateServerUrl = ServerUrl;
+        }
+
+        HotUpdateSettings->MaxConcurrency = FMath::Max(Concurrency, 1);
+
+        HotUpdateSettings->RateLimit = FMath::Max(Rate, 0);
+
+        // An explicit concurrency is what the caller wants measured, not a probe around the learned one
+        if (bHasConcurrency)
+        {
+            HotUpdateSettings->bUseTuningProfile = false;
+        }
+
+        // Nothing renders here, spreading work over frames would only slow the update down
+        HotUpdateSettings->GameThreadBudgetMs = 0.f;
+    }
+
+    const auto Subsystem = NewObject<UHotUpdateSubsystem>(GetTransientPackage());
+
+    Subsystem->AddToRoot();
+
+    const auto StartTime = FPlatformTime::Seconds();
+
+    Subsystem->StartUpHeadless(Version, Platform);
+
+    auto LastTime = StartTime;
+
+    auto LastStatusTime = StartTime;
+
+    FString Status;
+
+    while (!Subsystem->IsFinished() && !Subsystem->HasFailed() && !IsEngineExitRequested())
+    {
+        const auto CurrentTime = FPlatformTime::Seconds();
+
+        // Verify results and http completions come back as game thread tasks and core ticker work
+        FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+
+        FTicker::GetCoreTicker().Tick(CurrentTime - LastTime);
+
+        LastTime = CurrentTime;
+
+        if (Subsystem->DownloadManager.IsValid())
+        {
+            Status = Subsystem->DownloadManager->GetStatus();
+
+            if (CurrentTime - LastStatusTime >= HotUpdateCommandlet::StatusInterval)
+            {
+                LastStatusTime = CurrentTime;
+
+                UE_LOG(LogHotUpdate, Display, TEXT("%s"), *Status);
+            }
+        }
+
+        FPlatformProcess::Sleep(0.001f);
+    }
+
+    const auto bIsSuccessful = Subsystem->IsFinished() && !Subsystem->HasFailed();
+
+    Subsystem->ShutDown();
+
+    Subsystem->RemoveFromRoot();
+
+    if (!Status.IsEmpty())
+    {
+        UE_LOG(LogHotUpdate, Display, TEXT("%s"), *Status);
+    }
+
+    UE_LOG(LogHotUpdate, Display, TEXT("HotUpdate %s in %.2f s"), bIsSuccessful ? TEXT("succeeded") : TEXT("failed"),
+           FPlatformTime::Seconds() - StartTime);
+
+    return bIsSuccessful ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "Engine/GameInstance.h"
+#include "HotUpdateSubsystem.h"
+#include "FileDownloadManager.h"
+
+namespace HotUpdateCommands
+{
+    static TSharedPtr<FFileDownloadManager> GetDownloadManager(UWorld* World, FOutputDevice& Ar)
+    {
+        const auto GameInstance = World != nullptr ? World->GetGameInstance() : nullptr;
+
+        const auto HotUpdateSubsystem = GameInstance != nullptr
+                                            ? GameInstance->GetSubsystem<UHotUpdateSubsystem>()
+                                            : nullptr;
+
+        if (HotUpdateSubsystem == nullptr || !HotUpdateSubsystem->DownloadManager.IsValid())
+        {
+            Ar.Log(TEXT("HotUpdate is not running"));
+
+            return nullptr;
+        }
+
+        return HotUpdateSubsystem->DownloadManager;
+    }
+
+    static FAutoConsoleCommandWithWorldArgsAndOutputDevice StatusCommand(
+        TEXT("HotUpdate.Status"),
+        TEXT("Print the state of the HotUpdate download manager"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>&, UWorld* World, FOutputDevice& Ar)
+            {
+                if (const auto DownloadManager = GetDownloadManager(World, Ar))
+                {
+                    Ar.Log(DownloadManager->GetStatus());
+                }
+            }));
+
+    static FAutoConsoleCommandWithWorldArgsAndOutputDevice SetMaxConcurrencyCommand(
+        TEXT("HotUpdate.SetMaxConcurrency"),
+        TEXT("HotUpdate.SetMaxConcurrency <Count>, files downloaded at the same time, 0 is unlimited"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+            {
+                if (Args.Num() < 1)
+                {
+                    Ar.Log(TEXT("Usage: HotUpdate.SetMaxConcurrency <Count>"));
+
+                    return;
+                }
+
+                if (const auto DownloadManager = GetDownloadManager(World, Ar))
+                {
+                    DownloadManager->SetMaxConcurrency(FCString::Atoi(*Args[0]));
+                }
+            }));
+
+    static FAutoConsoleCommandWithWorldArgsAndOutputDevice SetRateLimitCommand(
+        TEXT("HotUpdate.SetRateLimit"),
+        TEXT("HotUpdate.SetRateLimit <KB/s>, 0 is unlimited"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+            {
+                if (Args.Num() < 1)
+                {
+                    Ar.Log(TEXT("Usage: HotUpdate.SetRateLimit <KB/s>"));
+
+                    return;
+                }
+
+                if (const auto DownloadManager = GetDownloadManager(World, Ar))
+                {
+                    DownloadManager->SetRateLimit(FCString::Atoi64(*Args[0]) * 1024);
+                }
+            }));
+
+    static FAutoConsoleCommandWithWorldArgsAndOutputDevice PauseCommand(
+        TEXT("HotUpdate.Pause"),
+        TEXT("HotUpdate.Pause [0|1], stop issuing new ranges, in flight ranges still finish. Toggles without argument"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+            {
+                if (const auto DownloadManager = GetDownloadManager(World, Ar))
+                {
+                    DownloadManager->SetPaused(Args.Num() > 0 ? FCString::ToBool(*Args[0]) : !DownloadManager->IsPaused());
+                }
+            }));
+
+    static FAutoConsoleCommandWithWorldArgsAndOutputDevice SetGameplayStateCommand(
+        TEXT("HotUpdate.SetGameplayState"),
+        TEXT("HotUpdate.SetGameplayState <Idle|Menu|InMatch|LatencySensitive>, apply the download policy of the state"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+            {
+                const auto Enum = StaticEnum<EHotUpdateGameplayState>();
+
+                const auto Value = Args.Num() > 0 ? Enum->GetValueByNameString(Args[0]) : INDEX_NONE;
+
+                if (Value == INDEX_NONE)
+                {
+                    Ar.Log(TEXT("Usage: HotUpdate.SetGameplayState <Idle|Menu|InMatch|LatencySensitive>"));
+
+                    return;
+                }
+
+                const auto GameInstance = World != nullptr ? World->GetGameInstance() : nullptr;
+
+                const auto HotUpdateSubsystem = GameInstance != nullptr
+                                                    ? GameInstance->GetSubsystem<UHotUpdateSubsystem>()
+                                                    : nullptr;
+
+                if (HotUpdateSubsystem == nullptr)
+                {
+                    Ar.Log(TEXT("HotUpdate is not running"));
+
+                    return;
+                }
+
+                HotUpdateSubsystem->SetGameplayState(static_cast<EHotUpdateGameplayState>(Value));
+            }));
+}
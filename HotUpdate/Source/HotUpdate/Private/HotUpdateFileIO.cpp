@@ -0,0 +1,912 @@
+#include "HotUpdateFileIO.h"
+#include "FileDownLog.h"
+#include "HotUpdateSettings.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_LINUX
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Containers/Queue.h"
+#include "Misc/ScopeExit.h"
+#include "Misc/ScopeLock.h"
+
+THIRD_PARTY_INCLUDES_START
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+THIRD_PARTY_INCLUDES_END
+#endif
+
+// The READ and WRITE operations came with kernel 5.6, as did IORING_FEAT_RW_CUR_POS
+#if PLATFORM_LINUX && defined(IORING_FEAT_RW_CUR_POS) && defined(__NR_io_uring_setup)
+#define HOTUPDATE_WITH_IO_URING 1
+#else
+#define HOTUPDATE_WITH_IO_URING 0
+#endif
+
+namespace HotUpdateFileIO
+{
+    class FPortableWriter final : public FHotUpdateFileWriter
+    {
+    public:
+        explicit FPortableWriter(IFileHandle* InHandle) : Handle(InHandle)
+        {
+        }
+
+        virtual void Write(const int64 Offset, const uint8* Data, const int64 Size,
+                           TFunction<void(bool)>&& OnWritten) override
+        {
+            Handle->Seek(Offset);
+
+            OnWritten(Handle->Write(Data, Size));
+        }
+
+    private:
+        TUniquePtr<IFileHandle> Handle;
+    };
+
+#if HOTUPDATE_WITH_IO_URING
+    static const int64 ReadSize = 1024 * 1024;
+
+    /** O_DIRECT buffers, offsets and sizes are multiples of the logical block size, 4K covers common disks */
+    static const int64 DirectAlignment = 4096;
+
+    static uint32 GetQueueDepth()
+    {
+        const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+        return FMath::Clamp(HotUpdateSettings != nullptr ? HotUpdateSettings->IOQueueDepth : 32, 2, 256);
+    }
+
+    static bool IsDirectSize(const int64 FileSize)
+    {
+        const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+        return HotUpdateSettings != nullptr && HotUpdateSettings->DirectIOThreshold > 0 &&
+            FileSize >= static_cast<int64>(HotUpdateSettings->DirectIOThreshold) * 1024 * 1024;
+    }
+
+    /** Submission and completion rings of one io_uring instance, used by a single thread */
+    class FIOUring
+    {
+    public:
+        FIOUring() = default;
+
+        ~FIOUring()
+        {
+            if (Sqes != nullptr)
+            {
+                munmap(Sqes, SqesSize);
+            }
+
+            if (CqRing != nullptr && CqRing != SqRing)
+            {
+                munmap(CqRing, CqRingSize);
+            }
+
+            if (SqRing != nullptr)
+            {
+                munmap(SqRing, SqRingSize);
+            }
+
+            if (RingFd >= 0)
+            {
+                close(RingFd);
+            }
+        }
+
+        bool Init(const uint32 InEntries)
+        {
+            io_uring_params Params;
+
+            FMemory::Memzero(Params);
+
+            RingFd = static_cast<int32>(syscall(__NR_io_uring_setup, InEntries, &Params));
+
+            if (RingFd < 0 || (Params.features & IORING_FEAT_RW_CUR_POS) == 0)
+            {
+                return false;
+            }
+
+            SqRingSize = Params.sq_off.array + Params.sq_entries * sizeof(uint32);
+
+            CqRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+
+            const auto bIsSingleMap = (Params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+            if (bIsSingleMap)
+            {
+                SqRingSize = CqRingSize = FMath::Max(SqRingSize, CqRingSize);
+            }
+
+            SqRing = Map(SqRingSize, IORING_OFF_SQ_RING);
+
+            CqRing = bIsSingleMap ? SqRing : Map(CqRingSize, IORING_OFF_CQ_RING);
+
+            SqesSize = Params.sq_entries * sizeof(io_uring_sqe);
+
+            Sqes = static_cast<io_uring_sqe*>(Map(SqesSize, IORING_OFF_SQES));
+
+            if (SqRing == nullptr || CqRing == nullptr || Sqes == nullptr)
+            {
+                return false;
+            }
+
+            const auto Sq = static_cast<uint8*>(SqRing);
+
+            const auto Cq = static_cast<uint8*>(CqRing);
+
+            SqHead = reinterpret_cast<uint32*>(Sq + Params.sq_off.head);
+
+            SqTail = reinterpret_cast<uint32*>(Sq + Params.sq_off.tail);
+
+            SqMask = *reinterpret_cast<uint32*>(Sq + Params.sq_off.ring_mask);
+
+            SqArray = reinterpret_cast<uint32*>(Sq + Params.sq_off.array);
+
+            CqHead = reinterpret_cast<uint32*>(Cq + Params.cq_off.head);
+
+            CqTail = reinterpret_cast<uint32*>(Cq + Params.cq_off.tail);
+
+            CqMask = *reinterpret_cast<uint32*>(Cq + Params.cq_off.ring_mask);
+
+            Cqes = reinterpret_cast<io_uring_cqe*>(Cq + Params.cq_off.cqes);
+
+            Entries = Params.sq_entries;
+
+            LocalTail = *SqTail;
+
+            return true;
+        }
+
+        uint32 GetEntries() const
+        {
+            return Entries;
+        }
+
+        /** Cleared entry to fill, nullptr while the submission ring is full */
+        io_uring_sqe* GetSqe()
+        {
+            if (LocalTail - __atomic_load_n(SqHead, __ATOMIC_ACQUIRE) >= Entries)
+            {
+                return nullptr;
+            }
+
+            const auto Index = LocalTail & SqMask;
+
+            SqArray[Index] = Index;
+
+            LocalTail++;
+
+            ToSubmit++;
+
+            FMemory::Memzero(Sqes[Index]);
+
+            return &Sqes[Index];
+        }
+
+        /** Submits the filled entries and waits for WaitNum completions, negative errno on failure */
+        int32 Submit(const uint32 WaitNum)
+        {
+            __atomic_store_n(SqTail, LocalTail, __ATOMIC_RELEASE);
+
+            int32 Result;
+
+            do
+            {
+                Result = static_cast<int32>(syscall(__NR_io_uring_enter, RingFd, ToSubmit, WaitNum,
+                                                    WaitNum > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+            }
+            while (Result < 0 && errno == EINTR);
+
+            if (Result < 0)
+            {
+                return -errno;
+            }
+
+            ToSubmit -= FMath::Min(static_cast<uint32>(Result), ToSubmit);
+
+            return Result;
+        }
+
+        bool PopCqe(uint64& OutUserData, int32& OutResult)
+        {
+            const auto Head = *CqHead;
+
+            if (Head == __atomic_load_n(CqTail, __ATOMIC_ACQUIRE))
+            {
+                return false;
+            }
+
+            const auto& Cqe = Cqes[Head & CqMask];
+
+            OutUserData = Cqe.user_data;
+
+            OutResult = Cqe.res;
+
+            __atomic_store_n(CqHead, Head + 1, __ATOMIC_RELEASE);
+
+            return true;
+        }
+
+    private:
+        void* Map(const size_t Size, const int64 Offset) const
+        {
+            const auto Address = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, Offset);
+
+            return Address != MAP_FAILED ? Address : nullptr;
+        }
+
+        int32 RingFd = -1;
+
+        void* SqRing = nullptr;
+
+        void* CqRing = nullptr;
+
+        io_uring_sqe* Sqes = nullptr;
+
+        size_t SqRingSize = 0;
+
+        size_t CqRingSize = 0;
+
+        size_t SqesSize = 0;
+
+        uint32* SqHead = nullptr;
+
+        uint32* SqTail = nullptr;
+
+        uint32* SqArray = nullptr;
+
+        uint32 SqMask = 0;
+
+        uint32* CqHead = nullptr;
+
+        uint32* CqTail = nullptr;
+
+        io_uring_cqe* Cqes = nullptr;
+
+        uint32 CqMask = 0;
+
+        uint32 Entries = 0;
+
+        uint32 LocalTail = 0;
+
+        uint32 ToSubmit = 0;
+    };
+
+    /** Containers and seccomp profiles often refuse io_uring even on new kernels, so probe once */
+    static bool IsIOUringAvailable()
+    {
+        static const auto bIsAvailable = []()
+        {
+            FIOUring Ring;
+
+            const auto bIsInitialized = Ring.Init(2);
+
+            UE_LOG(LogHotUpdate, Log, TEXT("io_uring is %s"), bIsInitialized ? TEXT("available") : TEXT("unavailable"));
+
+            return bIsInitialized;
+        }();
+
+        return bIsAvailable;
+    }
+
+    class FIOUringWriter;
+
+    struct FWriteOp
+    {
+        FIOUringWriter* Writer = nullptr;
+
+        int64 Offset = 0;
+
+        const uint8* Data = nullptr;
+
+        int64 Size = 0;
+
+        int64 Written = 0;
+
+        TFunction<void(bool)> OnWritten;
+    };
+
+    /** Owns the ring all writers share, so ranges of every download task go out in one submission */
+    class FWriteWorker final : public FRunnable
+    {
+    public:
+        /** nullptr once shut down or when the ring can't be created */
+        static FWriteWorker* Get()
+        {
+            FScopeLock Lock(&GetLock());
+
+            if (Instance == nullptr && !bIsShutDown)
+            {
+                auto Worker = new FWriteWorker();
+
+                if (Worker->Ring.Init(GetQueueDepth()))
+                {
+                    Instance = Worker;
+
+                    Instance->Thread = FRunnableThread::Create(Instance, TEXT("HotUpdateIOUring"));
+                }
+                else
+                {
+                    delete Worker;
+
+                    bIsShutDown = true;
+                }
+            }
+
+            return Instance;
+        }
+
+        static void ShutDown()
+        {
+            FScopeLock Lock(&GetLock());
+
+            bIsShutDown = true;
+
+            if (Instance == nullptr)
+            {
+                return;
+            }
+
+            if (Instance->Thread != nullptr)
+            {
+                Instance->Thread->Kill(true);
+
+                delete Instance->Thread;
+            }
+
+            delete Instance;
+
+            Instance = nullptr;
+        }
+
+        void Enqueue(FWriteOp* Op)
+        {
+            Pending.Enqueue(Op);
+
+            WakeEvent->Trigger();
+        }
+
+        virtual uint32 Run() override;
+
+        virtual void Stop() override
+        {
+            bIsStopping = true;
+
+            WakeEvent->Trigger();
+        }
+
+    private:
+        FWriteWorker() : WakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
+        {
+        }
+
+        virtual ~FWriteWorker() override
+        {
+            FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+        }
+
+        static FCriticalSection& GetLock()
+        {
+            static FCriticalSection Lock;
+
+            return Lock;
+        }
+
+        static void Finish(FWriteOp* Op, bool bWritten);
+
+        static FWriteWorker* Instance;
+
+        static bool bIsShutDown;
+
+        FIOUring Ring;
+
+        TQueue<FWriteOp*, EQueueMode::Mpsc> Pending;
+
+        /** Short writes continue from where they stopped */
+        TArray<FWriteOp*> Retries;
+
+        FEvent* WakeEvent;
+
+        FRunnableThread* Thread = nullptr;
+
+        TAtomic<bool> bIsStopping{false};
+
+        uint32 InFlight = 0;
+    };
+
+    FWriteWorker* FWriteWorker::Instance = nullptr;
+
+    bool FWriteWorker::bIsShutDown = false;
+
+    class FIOUringWriter final : public FHotUpdateFileWriter
+    {
+    public:
+        FIOUringWriter(const int32 InFd, const bool bInDropCache)
+            : Fd(InFd), bDropCache(bInDropCache), IdleEvent(FPlatformProcess::GetSynchEventFromPool(false))
+        {
+        }
+
+        virtual ~FIOUringWriter() override
+        {
+            // A trigger left from an earlier idle moment only costs one more check
+            while (PendingNum.Load() > 0)
+            {
+                IdleEvent->Wait();
+            }
+
+            // The last write may still be triggering the event
+            {
+                FScopeLock Lock(&IdleLock);
+            }
+
+            FPlatformProcess::ReturnSynchEventToPool(IdleEvent);
+
+            close(Fd);
+        }
+
+        virtual void Write(const int64 Offset, const uint8* Data, const int64 Size,
+                           TFunction<void(bool)>&& OnWritten) override
+        {
+            const auto Op = new FWriteOp();
+
+            Op->Writer = this;
+
+            Op->Offset = Offset;
+
+            Op->Data = Data;
+
+            Op->Size = Size;
+
+            Op->OnWritten = MoveTemp(OnWritten);
+
+            ++PendingNum;
+
+            if (const auto Worker = FWriteWorker::Get())
+            {
+                Worker->Enqueue(Op);
+
+                return;
+            }
+
+            // The worker is gone with the module, finish in place
+            while (Op->Written < Op->Size)
+            {
+                const auto Written = pwrite(Fd, Op->Data + Op->Written, Op->Size - Op->Written,
+                                            Op->Offset + Op->Written);
+
+                if (Written < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+
+                if (Written <= 0)
+                {
+                    break;
+                }
+
+                Op->Written += Written;
+            }
+
+            OnFinished(*Op, Op->Written == Op->Size);
+
+            delete Op;
+        }
+
+        int32 GetFd() const
+        {
+            return Fd;
+        }
+
+        void OnFinished(const FWriteOp& Op, const bool bWritten)
+        {
+            // Pages of huge paks are written back and dropped instead of pushing the game out of the page cache
+            if (bWritten && bDropCache)
+            {
+                posix_fadvise(Fd, Op.Offset, Op.Size, POSIX_FADV_DONTNEED);
+            }
+
+            Op.OnWritten(bWritten);
+
+            FScopeLock Lock(&IdleLock);
+
+            if (--PendingNum == 0)
+            {
+                IdleEvent->Trigger();
+            }
+        }
+
+    private:
+        int32 Fd;
+
+        bool bDropCache;
+
+        TAtomic<int32> PendingNum{0};
+
+        /** Signaled when the last write in flight finishes, the destructor waits on it */
+        FEvent* IdleEvent;
+
+        FCriticalSection IdleLock;
+    };
+
+    uint32 FWriteWorker::Run()
+    {
+        while (true)
+        {
+            auto Prepared = 0u;
+
+            while (InFlight + Prepared < Ring.GetEntries())
+            {
+                FWriteOp* Op = nullptr;
+
+                if (Retries.Num() > 0)
+                {
+                    Op = Retries.Pop(false);
+                }
+                else if (!Pending.Dequeue(Op))
+                {
+                    break;
+                }
+
+                const auto Sqe = Ring.GetSqe();
+
+                Sqe->opcode = IORING_OP_WRITE;
+
+                Sqe->fd = Op->Writer->GetFd();
+
+                Sqe->off = Op->Offset + Op->Written;
+
+                Sqe->addr = reinterpret_cast<uint64>(Op->Data + Op->Written);
+
+                Sqe->len = static_cast<uint32>(FMath::Min<int64>(Op->Size - Op->Written, MAX_int32));
+
+                Sqe->user_data = reinterpret_cast<uint64>(Op);
+
+                Prepared++;
+            }
+
+            InFlight += Prepared;
+
+            if (InFlight == 0)
+            {
+                if (bIsStopping)
+                {
+                    break;
+                }
+
+                WakeEvent->Wait();
+
+                continue;
+            }
+
+            const auto Result = Ring.Submit(1);
+
+            if (Result < 0)
+            {
+                UE_LOG(LogHotUpdate, Warning, TEXT("io_uring submit failed: %s"), UTF8_TO_TCHAR(strerror(-Result)));
+
+                FPlatformProcess::Sleep(0.001f);
+            }
+
+            uint64 UserData;
+
+            int32 Written;
+
+            while (Ring.PopCqe(UserData, Written))
+            {
+                InFlight--;
+
+                const auto Op = reinterpret_cast<FWriteOp*>(UserData);
+
+                if (Written == -EAGAIN || Written == -EINTR)
+                {
+                    Retries.Add(Op);
+                }
+                else if (Written <= 0)
+                {
+                    UE_LOG(LogHotUpdate, Warning, TEXT("io_uring write failed: %s"),
+                           UTF8_TO_TCHAR(strerror(Written < 0 ? -Written : ENOSPC)));
+
+                    Finish(Op, false);
+                }
+                else if ((Op->Written += Written) < Op->Size)
+                {
+                    Retries.Add(Op);
+                }
+                else
+                {
+                    Finish(Op, true);
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    void FWriteWorker::Finish(FWriteOp* Op, const bool bWritten)
+    {
+        Op->Writer->OnFinished(*Op, bWritten);
+
+        delete Op;
+    }
+
+    /** Reads run QueueDepth blocks ahead of the hash, which takes them in file order */
+    static bool HashFileIOUring(const FString& Path, const bool bIsDirect, FMD5Hash& OutHash)
+    {
+        const auto Fd = open(TCHAR_TO_UTF8(*Path), O_RDONLY | O_CLOEXEC | (bIsDirect ? O_DIRECT : 0));
+
+        if (Fd < 0)
+        {
+            return false;
+        }
+
+        ON_SCOPE_EXIT
+        {
+            close(Fd);
+        };
+
+        struct stat Stat;
+
+        if (fstat(Fd, &Stat) != 0)
+        {
+            return false;
+        }
+
+        const int64 FileSize = Stat.st_size;
+
+        if (!bIsDirect)
+        {
+            posix_fadvise(Fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+
+        FIOUring Ring;
+
+        if (!Ring.Init(GetQueueDepth()))
+        {
+            return false;
+        }
+
+        struct FSlot
+        {
+            uint8* Buffer = nullptr;
+
+            int64 Offset = 0;
+
+            int32 Read = INDEX_NONE;
+        };
+
+        TArray<FSlot> Slots;
+
+        Slots.SetNum(static_cast<int32>(FMath::Clamp<int64>(FMath::DivideAndRoundUp(FileSize, ReadSize), 1,
+                                                            Ring.GetEntries())));
+
+        for (auto& Slot : Slots)
+        {
+            Slot.Buffer = static_cast<uint8*>(FMemory::Malloc(ReadSize, DirectAlignment));
+        }
+
+        ON_SCOPE_EXIT
+        {
+            for (const auto& Slot : Slots)
+            {
+                FMemory::Free(Slot.Buffer);
+            }
+        };
+
+        auto InFlight = 0u;
+
+        const auto QueueRead = [&Ring, &Slots, &InFlight, Fd](FSlot& Slot)
+        {
+            Slot.Read = INDEX_NONE;
+
+            const auto Sqe = Ring.GetSqe();
+
+            Sqe->opcode = IORING_OP_READ;
+
+            Sqe->fd = Fd;
+
+            Sqe->off = Slot.Offset;
+
+            Sqe->addr = reinterpret_cast<uint64>(Slot.Buffer);
+
+            Sqe->len = static_cast<uint32>(ReadSize);
+
+            Sqe->user_data = &Slot - Slots.GetData();
+
+            InFlight++;
+        };
+
+        int64 NextOffset = 0;
+
+        for (auto& Slot : Slots)
+        {
+            Slot.Offset = NextOffset;
+
+            NextOffset += ReadSize;
+
+            QueueRead(Slot);
+        }
+
+        FMD5 MD5;
+
+        int64 HashedSize = 0;
+
+        auto bIsFailed = false;
+
+        uint64 UserData;
+
+        int32 Read;
+
+        while (HashedSize < FileSize && !bIsFailed)
+        {
+            const auto Result = Ring.Submit(1);
+
+            if (Result < 0)
+            {
+                UE_LOG(LogHotUpdate, Warning, TEXT("io_uring submit failed: %s"), UTF8_TO_TCHAR(strerror(-Result)));
+
+                break;
+            }
+
+            while (Ring.PopCqe(UserData, Read))
+            {
+                InFlight--;
+
+                auto& Slot = Slots[static_cast<int32>(UserData)];
+
+                const auto Expected = FMath::Min(ReadSize, FileSize - Slot.Offset);
+
+                // A short read before the end is read again whole, a partial O_DIRECT read can't resume unaligned
+                if (Read == -EAGAIN || Read == -EINTR || (Read > 0 && Read < Expected))
+                {
+                    QueueRead(Slot);
+                }
+                else if (Read == Expected)
+                {
+                    Slot.Read = Read;
+                }
+                else
+                {
+                    UE_LOG(LogHotUpdate, Warning, TEXT("io_uring read of %s failed at %lld: %s"), *Path, Slot.Offset,
+                           UTF8_TO_TCHAR(strerror(Read < 0 ? -Read : EIO)));
+
+                    bIsFailed = true;
+                }
+            }
+
+            for (auto Slot = &Slots[(HashedSize / ReadSize) % Slots.Num()];
+                 !bIsFailed && HashedSize < FileSize && Slot->Read != INDEX_NONE;
+                 Slot = &Slots[(HashedSize / ReadSize) % Slots.Num()])
+            {
+                MD5.Update(Slot->Buffer, Slot->Read);
+
+                HashedSize += Slot->Read;
+
+                Slot->Read = INDEX_NONE;
+
+                if (NextOffset < FileSize)
+                {
+                    Slot->Offset = NextOffset;
+
+                    NextOffset += ReadSize;
+
+                    QueueRead(*Slot);
+                }
+            }
+        }
+
+        // The kernel may still fill the buffers, wait before they are freed
+        while (InFlight > 0 && Ring.Submit(1) >= 0)
+        {
+            while (Ring.PopCqe(UserData, Read))
+            {
+                InFlight--;
+            }
+        }
+
+        if (HashedSize < FileSize)
+        {
+            return false;
+        }
+
+        OutHash.Set(MD5);
+
+        return true;
+    }
+#endif
+}
+
+TUniquePtr<FHotUpdateFileWriter> FHotUpdateFileIO::OpenWrite(const FString& Path, const int64 FileSize,
+                                                             const EHotUpdateIOBackend Backend)
+{
+#if HOTUPDATE_WITH_IO_URING
+    const auto bUseIOUring = Backend == EHotUpdateIOBackend::Default
+                                 ? IsIOUringEnabled()
+                                 : Backend != EHotUpdateIOBackend::Portable && HotUpdateFileIO::IsIOUringAvailable();
+
+    if (bUseIOUring && HotUpdateFileIO::FWriteWorker::Get() != nullptr)
+    {
+        const auto Fd = open(TCHAR_TO_UTF8(*FPaths::ConvertRelativePathToFull(Path)), O_WRONLY | O_CREAT | O_CLOEXEC,
+                             0644);
+
+        if (Fd >= 0)
+        {
+            const auto bDropCache = Backend == EHotUpdateIOBackend::IOUringDirect ||
+                (Backend == EHotUpdateIOBackend::Default && HotUpdateFileIO::IsDirectSize(FileSize));
+
+            return MakeUnique<HotUpdateFileIO::FIOUringWriter>(Fd, bDropCache);
+        }
+
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to open %s for io_uring: %s"), *Path,
+               UTF8_TO_TCHAR(strerror(errno)));
+    }
+#endif
+
+    const auto Handle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Path, true);
+
+    if (Handle == nullptr)
+    {
+        return nullptr;
+    }
+
+    return MakeUnique<HotUpdateFileIO::FPortableWriter>(Handle);
+}
+
+FMD5Hash FHotUpdateFileIO::HashFile(const FString& Path, const EHotUpdateIOBackend Backend)
+{
+#if HOTUPDATE_WITH_IO_URING
+    const auto bUseIOUring = Backend == EHotUpdateIOBackend::Default
+                                 ? IsIOUringEnabled()
+                                 : Backend != EHotUpdateIOBackend::Portable && HotUpdateFileIO::IsIOUringAvailable();
+
+    if (bUseIOUring)
+    {
+        const auto& FullPath = FPaths::ConvertRelativePathToFull(Path);
+
+        const auto bIsDirect = Backend == EHotUpdateIOBackend::IOUringDirect ||
+            (Backend == EHotUpdateIOBackend::Default &&
+                HotUpdateFileIO::IsDirectSize(IFileManager::Get().FileSize(*Path)));
+
+        FMD5Hash Hash;
+
+        // Some file systems such as tmpfs refuse O_DIRECT
+        if (HotUpdateFileIO::HashFileIOUring(FullPath, bIsDirect, Hash) ||
+            (bIsDirect && HotUpdateFileIO::HashFileIOUring(FullPath, false, Hash)))
+        {
+            return Hash;
+        }
+
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to hash %s with io_uring, use the portable path"), *Path);
+    }
+#endif
+
+    return FMD5Hash::HashFile(*Path);
+}
+
+bool FHotUpdateFileIO::IsIOUringEnabled()
+{
+#if HOTUPDATE_WITH_IO_URING
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    return HotUpdateSettings != nullptr && HotUpdateSettings->bUseIOUring && HotUpdateFileIO::IsIOUringAvailable();
+#else
+    return false;
+#endif
+}
+
+void FHotUpdateFileIO::ShutDown()
+{
+#if HOTUPDATE_WITH_IO_URING
+    HotUpdateFileIO::FWriteWorker::ShutDown();
+#endif
+}
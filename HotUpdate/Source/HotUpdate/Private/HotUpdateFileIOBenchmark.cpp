@@ -0,0 +1,198 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "HotUpdateFileIO.h"
+#include "FileDownLog.h"
+
+#if PLATFORM_LINUX
+THIRD_PARTY_INCLUDES_START
+#include <fcntl.h>
+#include <unistd.h>
+THIRD_PARTY_INCLUDES_END
+#endif
+
+#if !UE_BUILD_SHIPPING
+
+namespace HotUpdateFileIOBenchmark
+{
+    static const int64 RangeSize = 1024 * 1024;
+
+    static const TCHAR* GetBackendName(const EHotUpdateIOBackend Backend)
+    {
+        switch (Backend)
+        {
+        case EHotUpdateIOBackend::Portable:
+            return TEXT("Portable");
+        case EHotUpdateIOBackend::IOUring:
+            return TEXT("IOUring");
+        case EHotUpdateIOBackend::IOUringDirect:
+            return TEXT("IOUringDirect");
+        default:
+            return TEXT("Default");
+        }
+    }
+
+    /** Hashing a file just written would only measure memory, where the platform allows it start from disk */
+    static void DropCache(const FString& Path)
+    {
+#if PLATFORM_LINUX
+        const auto Fd = open(TCHAR_TO_UTF8(*FPaths::ConvertRelativePathToFull(Path)), O_RDONLY | O_CLOEXEC);
+
+        if (Fd >= 0)
+        {
+            fdatasync(Fd);
+
+            posix_fadvise(Fd, 0, 0, POSIX_FADV_DONTNEED);
+
+            close(Fd);
+        }
+#endif
+    }
+
+    /** Ranges of all files interleave the way concurrent download tasks issue them */
+    static bool RunWrite(const TArray<FString>& Paths, const TArray<uint8>& Buffer, const int64 FileSize,
+                         const EHotUpdateIOBackend Backend)
+    {
+        TAtomic<int32> WrittenNum(0);
+
+        auto IssuedNum = 0;
+
+        {
+            TArray<TUniquePtr<FHotUpdateFileWriter>> Writers;
+
+            for (const auto& Path : Paths)
+            {
+                IFileManager::Get().Delete(*Path);
+
+                Writers.Add(FHotUpdateFileIO::OpenWrite(Path, FileSize, Backend));
+
+                if (!Writers.Last().IsValid())
+                {
+                    return false;
+                }
+            }
+
+            for (int64 Offset = 0; Offset < FileSize; Offset += RangeSize)
+            {
+                for (const auto& Writer : Writers)
+                {
+                    IssuedNum++;
+
+                    Writer->Write(Offset, Buffer.GetData(), FMath::Min(RangeSize, FileSize - Offset),
+                                  [&WrittenNum](const bool bWritten)
+                                  {
+                                      if (bWritten)
+                                      {
+                                          ++WrittenNum;
+                                      }
+                                  });
+                }
+            }
+
+            // Writers wait for their writes in flight when they are destroyed
+        }
+
+        return WrittenNum.Load() == IssuedNum;
+    }
+
+    static void Run(const int64 FileSize, const int32 FileNum, FOutputDevice& Ar)
+    {
+        const auto& Root = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HotUpdate"), TEXT("Benchmark"));
+
+        IFileManager::Get().MakeDirectory(*Root, true);
+
+        TArray<FString> Paths;
+
+        for (auto i = 0; i < FileNum; ++i)
+        {
+            Paths.Add(FPaths::Combine(Root, FString::Printf(TEXT("IO_%d.bin"), i)));
+        }
+
+        TArray<uint8> Buffer;
+
+        Buffer.SetNumUninitialized(RangeSize);
+
+        for (auto i = 0; i < Buffer.Num(); ++i)
+        {
+            Buffer[i] = static_cast<uint8>(i * 2654435761u >> 13);
+        }
+
+        const auto TotalSize = FileSize * FileNum / (1024.0 * 1024.0);
+
+        Ar.Logf(TEXT("io_uring is %s, %d files of %lld MB"),
+                FHotUpdateFileIO::IsIOUringEnabled() ? TEXT("enabled") : TEXT("disabled or unavailable"), FileNum,
+                FileSize / 1024 / 1024);
+
+        TArray<FString> PortableHashes;
+
+        for (const auto Backend : {EHotUpdateIOBackend::Portable, EHotUpdateIOBackend::IOUring,
+                                   EHotUpdateIOBackend::IOUringDirect})
+        {
+            const auto WriteStartTime = FPlatformTime::Seconds();
+
+            const auto bIsWritten = RunWrite(Paths, Buffer, FileSize, Backend);
+
+            const auto WriteTime = FPlatformTime::Seconds() - WriteStartTime;
+
+            Ar.Logf(TEXT("write %-14s %8.2f ms, %8.2f MB/s, %s"), GetBackendName(Backend), WriteTime * 1000.0,
+                    TotalSize / FMath::Max(WriteTime, 0.000001), bIsWritten ? TEXT("ok") : TEXT("failed"));
+
+            for (const auto& Path : Paths)
+            {
+                DropCache(Path);
+            }
+
+            auto bIsMatched = true;
+
+            const auto HashStartTime = FPlatformTime::Seconds();
+
+            for (auto i = 0; i < Paths.Num(); ++i)
+            {
+                const auto& Hash = FHotUpdateFileIO::HashFile(Paths[i], Backend);
+
+                const auto& HashStr = Hash.IsValid() ? BytesToHex(Hash.GetBytes(), Hash.GetSize()) : FString();
+
+                if (Backend == EHotUpdateIOBackend::Portable)
+                {
+                    PortableHashes.Add(HashStr);
+                }
+
+                bIsMatched &= !HashStr.IsEmpty() && PortableHashes.IsValidIndex(i) && HashStr == PortableHashes[i];
+            }
+
+            const auto HashTime = FPlatformTime::Seconds() - HashStartTime;
+
+            Ar.Logf(TEXT("hash  %-14s %8.2f ms, %8.2f MB/s, %s"), GetBackendName(Backend), HashTime * 1000.0,
+                    TotalSize / FMath::Max(HashTime, 0.000001), bIsMatched ? TEXT("ok") : TEXT("mismatch"));
+        }
+
+        for (const auto& Path : Paths)
+        {
+            IFileManager::Get().Delete(*Path);
+        }
+    }
+
+    static FAutoConsoleCommandWithWorldArgsAndOutputDevice BenchmarkCommand(
+        TEXT("HotUpdate.Benchmark.IO"),
+        TEXT("HotUpdate.Benchmark.IO [SizeMB] [FileNum], write files range by range and hash them with the portable ")
+        TEXT("and io_uring backends, 256 MB and 4 files by default"),
+        FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld*, FOutputDevice& Ar)
+            {
+                const auto SizeMB = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 256;
+
+                const auto FileNum = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 4;
+
+                const auto Verbosity = LogHotUpdate.GetVerbosity();
+
+                LogHotUpdate.SetVerbosity(ELogVerbosity::Warning);
+
+                // Not a multiple of the block size, so the unaligned tail of O_DIRECT reads is covered
+                Run(static_cast<int64>(SizeMB) * 1024 * 1024 + 4097, FileNum, Ar);
+
+                LogHotUpdate.SetVerbosity(Verbosity);
+            }));
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "HotUpdateFrameBudget.h"
+#include "FileDownLog.h"
+#include "HotUpdateSettings.h"
+#include "HotUpdateTrace.h"
+#include "HotUpdateStats.h"
+
+FHotUpdateFrameBudget& FHotUpdateFrameBudget::Get()
+{
+    static FHotUpdateFrameBudget Instance;
+
+    return Instance;
+}
+
+float FHotUpdateFrameBudget::GetBudget()
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    return HotUpdateSettings != nullptr ? HotUpdateSettings->GameThreadBudgetMs : 2.f;
+}
+
+void FHotUpdateFrameBudget::Enqueue(const void* Owner, TFunction<void()>&& Work)
+{
+    check(IsInGameThread());
+
+    if (GetBudget() <= 0.f)
+    {
+        Work();
+
+        return;
+    }
+
+    Queue.Add({Owner, MoveTemp(Work)});
+
+    if (!TickHandle.IsValid())
+    {
+        TickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FHotUpdateFrameBudget::Tick));
+    }
+}
+
+void FHotUpdateFrameBudget::Cancel(const void* Owner)
+{
+    for (auto i = Head; i < Queue.Num(); ++i)
+    {
+        if (Queue[i].Owner == Owner)
+        {
+            Queue[i].Work = nullptr;
+        }
+    }
+}
+
+void FHotUpdateFrameBudget::ResetStats()
+{
+    LongestFrameTime = 0.f;
+
+    OverBudgetFrames = 0;
+}
+
+bool FHotUpdateFrameBudget::Tick(float)
+{
+    HOTUPDATE_TRACE_SCOPE(HotUpdate_FrameBudget);
+
+    SCOPE_CYCLE_COUNTER(STAT_HotUpdate_FrameBudget);
+
+    const auto Budget = GetBudget() / 1000.0;
+
+    const auto StartTime = FPlatformTime::Seconds();
+
+    auto ElapsedTime = 0.0;
+
+    while (Head < Queue.Num())
+    {
+        auto Work = MoveTemp(Queue[Head++].Work);
+
+        if (Work)
+        {
+            Work();
+        }
+
+        ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+        if (ElapsedTime >= Budget)
+        {
+            break;
+        }
+    }
+
+    Queue.RemoveAt(0, Head, false);
+
+    Head = 0;
+
+    const auto FrameTime = static_cast<float>(ElapsedTime * 1000.0);
+
+    HOTUPDATE_TRACE_COUNTER_SET(HotUpdate_FrameWorkMs, FrameTime);
+
+    LongestFrameTime = FMath::Max(LongestFrameTime, FrameTime);
+
+    if (ElapsedTime > Budget)
+    {
+        OverBudgetFrames++;
+
+        UE_LOG(LogHotUpdate, Verbose, TEXT("Frame budget exceeded: %.2f ms, %d items deferred"), FrameTime,
+               Queue.Num());
+    }
+
+    if (Queue.Num() <= 0)
+    {
+        TickHandle.Reset();
+
+        return false;
+    }
+
+    return true;
+}
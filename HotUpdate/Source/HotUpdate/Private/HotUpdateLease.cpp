@@ -0,0 +1,112 @@
+#include "HotUpdateLease.h"
+#include "FileDownLog.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/WindowsHWrapper.h"
+#elif PLATFORM_MAC || PLATFORM_LINUX
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HotUpdateLease
+{
+    static FCriticalSection CriticalSection;
+
+    /** File locks of one process don't always exclude each other, held paths are also tracked here */
+    static TSet<FString> HeldPaths;
+}
+
+FHotUpdateLease::FHotUpdateLease(const FString& InLockPath) : LockPath(InLockPath)
+{
+}
+
+TSharedPtr<FHotUpdateLease> FHotUpdateLease::TryAcquire(const FString& InLockPath)
+{
+    const auto& FullPath = FPaths::ConvertRelativePathToFull(InLockPath);
+
+    {
+        FScopeLock ScopeLock(&HotUpdateLease::CriticalSection);
+
+        if (HotUpdateLease::HeldPaths.Contains(FullPath))
+        {
+            return nullptr;
+        }
+
+        HotUpdateLease::HeldPaths.Add(FullPath);
+    }
+
+    TSharedPtr<FHotUpdateLease> Lease(new FHotUpdateLease(FullPath));
+
+#if PLATFORM_WINDOWS
+    // No share mode, a second open fails until the holder closes the handle, which also deletes the file
+    const auto Handle = CreateFileW(*FullPath, GENERIC_READ | GENERIC_WRITE | DELETE, 0, nullptr, OPEN_ALWAYS,
+                                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+
+    if (Handle == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+
+    Lease->Handle = Handle;
+#elif PLATFORM_MAC || PLATFORM_LINUX
+    const auto Descriptor = open(TCHAR_TO_UTF8(*FullPath), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+
+    if (Descriptor < 0)
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to open lock file: %s"), *FullPath);
+
+        return nullptr;
+    }
+
+    Lease->Descriptor = Descriptor;
+
+    if (flock(Descriptor, LOCK_EX | LOCK_NB) != 0)
+    {
+        return nullptr;
+    }
+
+    struct stat Locked;
+
+    struct stat Current;
+
+    // The last holder deleted the file between our open and flock, the lock is on a file nobody else will open
+    if (fstat(Descriptor, &Locked) != 0 || stat(TCHAR_TO_UTF8(*FullPath), &Current) != 0 ||
+        Locked.st_dev != Current.st_dev || Locked.st_ino != Current.st_ino)
+    {
+        return nullptr;
+    }
+
+    Lease->bIsLocked = true;
+#endif
+
+    return Lease;
+}
+
+FHotUpdateLease::~FHotUpdateLease()
+{
+#if PLATFORM_WINDOWS
+    if (Handle != nullptr)
+    {
+        CloseHandle(Handle);
+    }
+#elif PLATFORM_MAC || PLATFORM_LINUX
+    if (Descriptor >= 0)
+    {
+        // Deleted while still locked, whoever opened it meanwhile sees it is gone once it gets the lock
+        if (bIsLocked)
+        {
+            unlink(TCHAR_TO_UTF8(*LockPath));
+        }
+
+        close(Descriptor);
+    }
+#endif
+
+    FScopeLock ScopeLock(&HotUpdateLease::CriticalSection);
+
+    HotUpdateLease::HeldPaths.Remove(LockPath);
+}
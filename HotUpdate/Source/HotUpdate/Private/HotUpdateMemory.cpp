@@ -0,0 +1,127 @@
+#include "HotUpdateMemory.h"
+#include "HotUpdateSettings.h"
+#include "HotUpdateTrace.h"
+#include "Misc/ScopeLock.h"
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 27
+LLM_DEFINE_TAG(HotUpdate);
+#else
+DEFINE_STAT(STAT_HotUpdateLLM);
+#endif
+#endif
+
+FHotUpdateMemory& FHotUpdateMemory::Get()
+{
+    static FHotUpdateMemory Instance;
+
+    return Instance;
+}
+
+void FHotUpdateMemory::RegisterTag()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER && ENGINE_MAJOR_VERSION == 4 && ENGINE_MINOR_VERSION < 27
+    FLowLevelMemTracker::Get().RegisterProjectTag(static_cast<int32>(HOTUPDATE_LLM_TAG), TEXT("HotUpdate"),
+                                                  GET_STATFNAME(STAT_HotUpdateLLM),
+                                                  GET_STATFNAME(STAT_EngineSummaryLLM));
+#endif
+}
+
+void FHotUpdateMemory::Alloc(const EHotUpdateMemoryStage Stage, const int64 Size)
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    const auto Index = static_cast<int32>(Stage);
+
+    Used += Size;
+
+    StageUsed[Index] += Size;
+
+    Peak = FMath::Max(Peak, Used);
+
+    StagePeak[Index] = FMath::Max(StagePeak[Index], StageUsed[Index]);
+
+    HOTUPDATE_TRACE_COUNTER_SET(HotUpdate_TrackedMemory, Used);
+}
+
+void FHotUpdateMemory::Free(const EHotUpdateMemoryStage Stage, const int64 Size)
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    const auto Index = static_cast<int32>(Stage);
+
+    Used = FMath::Max<int64>(Used - Size, 0);
+
+    StageUsed[Index] = FMath::Max<int64>(StageUsed[Index] - Size, 0);
+
+    HOTUPDATE_TRACE_COUNTER_SET(HotUpdate_TrackedMemory, Used);
+}
+
+bool FHotUpdateMemory::CanAlloc(const int64 Size) const
+{
+    const auto Budget = GetBudget();
+
+    FScopeLock ScopeLock(&CriticalSection);
+
+    return Budget <= 0 || Used <= 0 || Used + Size <= Budget;
+}
+
+float FHotUpdateMemory::GetPressure() const
+{
+    const auto Budget = GetBudget();
+
+    FScopeLock ScopeLock(&CriticalSection);
+
+    return Budget > 0 ? static_cast<float>(static_cast<double>(Used) / Budget) : 0.f;
+}
+
+int64 FHotUpdateMemory::GetUsed() const
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    return Used;
+}
+
+int64 FHotUpdateMemory::GetPeak() const
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    return Peak;
+}
+
+int64 FHotUpdateMemory::GetStagePeak(const EHotUpdateMemoryStage Stage) const
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    return StagePeak[static_cast<int32>(Stage)];
+}
+
+int64 FHotUpdateMemory::GetBudget()
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    return HotUpdateSettings != nullptr ? static_cast<int64>(HotUpdateSettings->MemoryBudget) * 1024 * 1024 : 0;
+}
+
+const TCHAR* FHotUpdateMemory::GetStageName(const EHotUpdateMemoryStage Stage)
+{
+    switch (Stage)
+    {
+    case EHotUpdateMemoryStage::GetVersion: return TEXT("GetVersion");
+    case EHotUpdateMemoryStage::Download: return TEXT("Download");
+    case EHotUpdateMemoryStage::Mount: return TEXT("Mount");
+    default: return TEXT("Unknown");
+    }
+}
+
+void FHotUpdateMemory::ResetPeaks()
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    Peak = Used;
+
+    for (auto i = 0; i < static_cast<int32>(EHotUpdateMemoryStage::Num); ++i)
+    {
+        StagePeak[i] = StageUsed[i];
+    }
+}
@@ -0,0 +1,420 @@
+#include "HotUpdateOnDemand.h"
+#include "FileDownLog.h"
+#include "HotUpdateSettings.h"
+#include "HotUpdatePredictor.h"
+#include "RemotePakFile.h"
+
+void FHotUpdateOnDemand::Reset()
+{
+    CancelPrefetch();
+
+    // Prefetched paks are valid on disk by now, the new manifest mounts them with the update
+    Paks.RemoveAll([](const TSharedRef<FOnDemandPak>& Pak)
+    {
+        return Pak->State == EOnDemandState::Registered || Pak->State == EOnDemandState::Failed ||
+            Pak->State == EOnDemandState::Prefetched || Pak->State == EOnDemandState::Installed;
+    });
+}
+
+void FHotUpdateOnDemand::AddPak(const FString& URL, const FPakFileProperty& PakInfo, const FString& ContentPath,
+                                const bool bIsInstalled)
+{
+    // Installed or installing since an earlier manifest
+    if (Paks.ContainsByPredicate([&PakInfo](const TSharedRef<FOnDemandPak>& Pak)
+    {
+        return Pak->PakInfo == PakInfo;
+    }))
+    {
+        return;
+    }
+
+    const auto& Pak = Paks.Add_GetRef(MakeShareable(new FOnDemandPak(URL, PakInfo, ContentPath)));
+
+    if (bIsInstalled)
+    {
+        Pak->State = EOnDemandState::Installed;
+    }
+}
+
+bool FHotUpdateOnDemand::IsContentAvailable(const FString& PackageName) const
+{
+    const auto Pak = FindPak(PackageName);
+
+    return !Pak.IsValid() || Pak->State == EOnDemandState::Mounted || Pak->State == EOnDemandState::Installed;
+}
+
+void FHotUpdateOnDemand::Request(const FString& PackageName, const FOnOnDemandFinished& OnFinished)
+{
+    const auto Pak = FindPak(PackageName);
+
+    if (!Pak.IsValid())
+    {
+        OnFinished.ExecuteIfBound(true);
+
+        return;
+    }
+
+    FHotUpdatePredictor::Get().Record(Pak->PakInfo.PakName);
+
+    if (Pak->State == EOnDemandState::Mounted || Pak->State == EOnDemandState::Installed)
+    {
+        OnFinished.ExecuteIfBound(true);
+
+        return;
+    }
+
+    Pak->Callbacks.Add(OnFinished);
+
+    switch (Pak->State)
+    {
+    case EOnDemandState::Prefetching:
+        {
+            UE_LOG(LogHotUpdate, Log, TEXT("Take over the prefetch of %s for %s"), *Pak->PakInfo.PakName,
+                   *PackageName);
+
+            Pak->State = EOnDemandState::Downloading;
+
+            // Lifts the prefetch rate limit
+            Pak->DownloadManager->SetGameplayState(EHotUpdateGameplayState::Idle);
+
+            UpdateBusy();
+        }
+        break;
+    case EOnDemandState::Prefetched:
+        {
+            Mount(Pak.ToSharedRef(), false);
+        }
+        break;
+    case EOnDemandState::Registered:
+    case EOnDemandState::Failed:
+        {
+            UE_LOG(LogHotUpdate, Log, TEXT("Install on demand pak %s for %s"), *Pak->PakInfo.PakName, *PackageName);
+
+            CancelPrefetch();
+
+            Download(Pak.ToSharedRef());
+        }
+        break;
+    default: break;
+    }
+}
+
+void FHotUpdateOnDemand::SetPrefetchAllowed(const bool bInAllowed)
+{
+    bIsPrefetchAllowed = bInAllowed;
+
+    if (bIsPrefetchAllowed)
+    {
+        UpdatePrefetch();
+    }
+    else
+    {
+        CancelPrefetch();
+    }
+}
+
+void FHotUpdateOnDemand::ShutDown()
+{
+    for (const auto& Pak : Paks)
+    {
+        if (Pak->DownloadManager.IsValid())
+        {
+            Pak->DownloadManager->ShutDown();
+        }
+
+        if (Pak->PakManager.IsValid())
+        {
+            Pak->PakManager->ShutDown();
+        }
+    }
+
+    Paks.Empty();
+
+    bIsBusy = false;
+
+    bIsPrefetchAllowed = false;
+
+    OnBusyChanged.Unbind();
+}
+
+TSharedPtr<FHotUpdateOnDemand::FOnDemandPak> FHotUpdateOnDemand::FindPak(const FString& PackageName) const
+{
+    for (const auto& Pak : Paks)
+    {
+        if (PackageName.StartsWith(Pak->ContentPath))
+        {
+            return Pak;
+        }
+    }
+
+    return nullptr;
+}
+
+void FHotUpdateOnDemand::Download(const TSharedRef<FOnDemandPak>& Pak)
+{
+    const auto bIsPrefetch = Pak->State == EOnDemandState::Prefetching;
+
+    // Large paks are mounted from the server at once and read block by block
+    if (!bIsPrefetch && FRemotePakPlatformFile::CanStream(Pak->PakInfo))
+    {
+        Mount(Pak, true);
+
+        return;
+    }
+
+    if (!bIsPrefetch)
+    {
+        Pak->State = EOnDemandState::Downloading;
+    }
+
+    Pak->DownloadManager = MakeShareable(new FFileDownloadManager());
+
+    if (bIsPrefetch)
+    {
+        const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+        Pak->DownloadManager->SetRateLimit(
+            HotUpdateSettings != nullptr ? static_cast<int64>(HotUpdateSettings->OnDemandPrefetchRateLimit) * 1024 : 0);
+    }
+
+    const TWeakPtr<FHotUpdateOnDemand> WeakThis = AsShared();
+
+    const TWeakPtr<FOnDemandPak> WeakPak = Pak;
+
+    Pak->DownloadManager->OnDownloadEvent.BindLambda([WeakThis, WeakPak](const EDownloadState Event, const FTaskInfo&)
+    {
+        const auto OnDemand = WeakThis.Pin();
+
+        const auto OnDemandPak = WeakPak.Pin();
+
+        if (Event == EDownloadState::END_DOWNLOAD && OnDemand.IsValid() && OnDemandPak.IsValid())
+        {
+            OnDemand->OnDownloaded(OnDemandPak.ToSharedRef());
+        }
+    });
+
+    Pak->DownloadManager->AddTask(Pak->URL, Pak->PakInfo);
+
+    UpdateBusy();
+
+    Pak->DownloadManager->StartUp();
+
+    Pak->DownloadManager->SealTasks();
+}
+
+void FHotUpdateOnDemand::OnDownloaded(const TSharedRef<FOnDemandPak>& Pak)
+{
+    if (Pak->State != EOnDemandState::Prefetching)
+    {
+        if (Pak->DownloadManager->IsSuccessful())
+        {
+            Mount(Pak, false);
+        }
+        else
+        {
+            Finish(Pak, false);
+        }
+
+        return;
+    }
+
+    // Released by the next download or ShutDown, this runs inside a callback of the manager
+    Pak->DownloadManager->ShutDown();
+
+    if (Pak->DownloadManager->IsSuccessful())
+    {
+        UE_LOG(LogHotUpdate, Log, TEXT("Prefetched on demand pak %s"), *Pak->PakInfo.PakName);
+
+        Pak->State = EOnDemandState::Prefetched;
+
+        FHotUpdatePredictor::Get().AddPrefetched(Pak->PakInfo.PakName, Pak->PakInfo.PakSize);
+    }
+    else
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to prefetch on demand pak %s"), *Pak->PakInfo.PakName);
+
+        Pak->State = EOnDemandState::Failed;
+    }
+
+    UpdatePrefetch();
+}
+
+void FHotUpdateOnDemand::UpdatePrefetch()
+{
+    if (!bIsPrefetchAllowed || bIsBusy)
+    {
+        return;
+    }
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    const auto Budget = HotUpdateSettings != nullptr
+                            ? static_cast<int64>(HotUpdateSettings->OnDemandPrefetchBudget) * 1024 * 1024
+                            : 0;
+
+    if (Budget <= 0 || !IsNetworkUnmetered() || Paks.ContainsByPredicate([](const TSharedRef<FOnDemandPak>& Pak)
+    {
+        return Pak->State == EOnDemandState::Prefetching || Pak->State == EOnDemandState::Mounting;
+    }))
+    {
+        return;
+    }
+
+    auto& Predictor = FHotUpdatePredictor::Get();
+
+    const auto PrefetchedSize = Predictor.GetPrefetchedSize();
+
+    TSharedPtr<FOnDemandPak> BestPak;
+
+    auto BestScore = 0.f;
+
+    for (const auto& Pak : Paks)
+    {
+        if (Pak->State != EOnDemandState::Registered || PrefetchedSize + Pak->PakInfo.PakSize > Budget)
+        {
+            continue;
+        }
+
+        const auto Score = Predictor.GetScore(Pak->PakInfo.PakName);
+
+        if (Score > BestScore)
+        {
+            BestPak = Pak;
+
+            BestScore = Score;
+        }
+    }
+
+    if (!BestPak.IsValid())
+    {
+        return;
+    }
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Prefetch on demand pak %s, score %.2f"), *BestPak->PakInfo.PakName, BestScore);
+
+    BestPak->State = EOnDemandState::Prefetching;
+
+    Download(BestPak.ToSharedRef());
+}
+
+void FHotUpdateOnDemand::CancelPrefetch()
+{
+    for (const auto& Pak : Paks)
+    {
+        if (Pak->State != EOnDemandState::Prefetching)
+        {
+            continue;
+        }
+
+        UE_LOG(LogHotUpdate, Log, TEXT("Cancel the prefetch of %s"), *Pak->PakInfo.PakName);
+
+        Pak->DownloadManager->ShutDown();
+
+        Pak->State = EOnDemandState::Registered;
+    }
+}
+
+bool FHotUpdateOnDemand::IsNetworkUnmetered()
+{
+    switch (FPlatformMisc::GetNetworkConnectionType())
+    {
+    case ENetworkConnectionType::WiFi:
+    case ENetworkConnectionType::Ethernet:
+    // Platforms that can't tell are mostly desktops
+    case ENetworkConnectionType::Unknown:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void FHotUpdateOnDemand::Mount(const TSharedRef<FOnDemandPak>& Pak, const bool bIsRemote)
+{
+    Pak->State = EOnDemandState::Mounting;
+
+    UpdateBusy();
+
+    Pak->PakManager = MakeShareable(new FFilePakManager());
+
+    if (bIsRemote)
+    {
+        Pak->PakManager->AddRemotePak(Pak->URL, Pak->PakInfo);
+    }
+
+    Pak->PakManager->AddPakFile(FPakFileProperty(Pak->PakInfo));
+
+    Pak->PakManager->OnMountUpdated.BindLambda([](const FString&, float)
+    {
+    });
+
+    const TWeakPtr<FHotUpdateOnDemand> WeakThis = AsShared();
+
+    const TWeakPtr<FOnDemandPak> WeakPak = Pak;
+
+    Pak->PakManager->OnMountFinished.BindLambda([WeakThis, WeakPak](const bool bIsSuccessful)
+    {
+        const auto OnDemand = WeakThis.Pin();
+
+        const auto OnDemandPak = WeakPak.Pin();
+
+        if (OnDemand.IsValid() && OnDemandPak.IsValid())
+        {
+            OnDemand->Finish(OnDemandPak.ToSharedRef(), bIsSuccessful);
+        }
+    });
+
+    Pak->PakManager->StartUp();
+}
+
+void FHotUpdateOnDemand::Finish(const TSharedRef<FOnDemandPak>& Pak, const bool bIsSucceeded)
+{
+    Pak->State = bIsSucceeded ? EOnDemandState::Mounted : EOnDemandState::Failed;
+
+    if (bIsSucceeded)
+    {
+        UE_LOG(LogHotUpdate, Display, TEXT("Success to install on demand pak: %s"), *Pak->PakInfo.PakName);
+    }
+    else
+    {
+        UE_LOG(LogHotUpdate, Error, TEXT("Failed to install on demand pak: %s"), *Pak->PakInfo.PakName);
+    }
+
+    // Released by the next try or ShutDown, this may run inside a callback of either manager
+    if (Pak->DownloadManager.IsValid())
+    {
+        Pak->DownloadManager->ShutDown();
+    }
+
+    if (!bIsSucceeded && Pak->PakManager.IsValid())
+    {
+        Pak->PakManager->ShutDown();
+    }
+
+    UpdateBusy();
+
+    const auto Callbacks = MoveTemp(Pak->Callbacks);
+
+    for (const auto& Callback : Callbacks)
+    {
+        Callback.ExecuteIfBound(bIsSucceeded);
+    }
+
+    UpdatePrefetch();
+}
+
+void FHotUpdateOnDemand::UpdateBusy()
+{
+    const auto bInBusy = Paks.ContainsByPredicate([](const TSharedRef<FOnDemandPak>& Pak)
+    {
+        return Pak->State == EOnDemandState::Downloading;
+    });
+
+    if (bInBusy == bIsBusy)
+    {
+        return;
+    }
+
+    bIsBusy = bInBusy;
+
+    OnBusyChanged.ExecuteIfBound(bIsBusy);
+}
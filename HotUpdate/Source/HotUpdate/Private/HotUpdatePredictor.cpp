@@ -0,0 +1,246 @@
+#include "HotUpdatePredictor.h"
+#include "FileDownLog.h"
+#include "FileDownloadManager.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonSerializer.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+
+namespace HotUpdatePredictor
+{
+    static float GetTotal(const TMap<FString, float>& Counts)
+    {
+        auto Total = 0.f;
+
+        for (const auto& Count : Counts)
+        {
+            Total += Count.Value;
+        }
+
+        return Total;
+    }
+
+    static void DecayCounts(TMap<FString, float>& Counts)
+    {
+        for (auto& Count : Counts)
+        {
+            Count.Value *= FHotUpdatePredictor::Decay;
+        }
+    }
+
+    static void ReadCounts(const TSharedPtr<FJsonObject>& JsonObject, TMap<FString, float>& OutCounts)
+    {
+        if (!JsonObject.IsValid())
+        {
+            return;
+        }
+
+        for (const auto& Value : JsonObject->Values)
+        {
+            OutCounts.Add(Value.Key, static_cast<float>(Value.Value->AsNumber()));
+        }
+    }
+
+    template <class WriterType>
+    static void WriteCounts(WriterType& JsonWriter, const FString& Identifier, const TMap<FString, float>& Counts)
+    {
+        JsonWriter->WriteObjectStart(Identifier);
+
+        for (const auto& Count : Counts)
+        {
+            JsonWriter->WriteValue(Count.Key, Count.Value);
+        }
+
+        JsonWriter->WriteObjectEnd();
+    }
+}
+
+FHotUpdatePredictor& FHotUpdatePredictor::Get()
+{
+    static FHotUpdatePredictor Instance;
+
+    return Instance;
+}
+
+void FHotUpdatePredictor::Record(const FString& PakName)
+{
+    Load();
+
+    const auto bWasPrefetched = Prefetched.Remove(PakName) > 0;
+
+    // Loading the content of a pak again and again is a single use
+    if (PakName == LastPak)
+    {
+        if (bWasPrefetched)
+        {
+            Save();
+        }
+
+        return;
+    }
+
+    HotUpdatePredictor::DecayCounts(Uses);
+
+    Uses.FindOrAdd(PakName) += 1.f;
+
+    if (!LastPak.IsEmpty())
+    {
+        auto& Next = Transitions.FindOrAdd(LastPak);
+
+        HotUpdatePredictor::DecayCounts(Next);
+
+        Next.FindOrAdd(PakName) += 1.f;
+    }
+
+    UE_LOG(LogHotUpdate, Log, TEXT("On demand pak %s used after %s%s"), *PakName, *LastPak,
+           bWasPrefetched ? TEXT(", prefetched") : TEXT(""));
+
+    LastPak = PakName;
+
+    Save();
+}
+
+float FHotUpdatePredictor::GetScore(const FString& PakName)
+{
+    Load();
+
+    const auto Next = Transitions.Find(LastPak);
+
+    const auto NextTotal = Next != nullptr ? HotUpdatePredictor::GetTotal(*Next) : 0.f;
+
+    const auto UseTotal = HotUpdatePredictor::GetTotal(Uses);
+
+    const auto Transition = NextTotal > 0.f ? Next->FindRef(PakName) / NextTotal : 0.f;
+
+    const auto Frequency = UseTotal > 0.f ? Uses.FindRef(PakName) / UseTotal : 0.f;
+
+    return TransitionWeight * Transition + (1.f - TransitionWeight) * Frequency;
+}
+
+void FHotUpdatePredictor::AddPrefetched(const FString& PakName, const int64 Size)
+{
+    Load();
+
+    Prefetched.Add(PakName, Size);
+
+    Save();
+}
+
+int64 FHotUpdatePredictor::GetPrefetchedSize()
+{
+    Load();
+
+    int64 Size = 0;
+
+    for (auto It = Prefetched.CreateIterator(); It; ++It)
+    {
+        // Replaced by an update or removed by the player
+        if (IFileManager::Get().FileSize(*FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), It.Key())) < 0)
+        {
+            It.RemoveCurrent();
+
+            continue;
+        }
+
+        Size += It.Value();
+    }
+
+    return Size;
+}
+
+void FHotUpdatePredictor::Load()
+{
+    if (bIsLoaded)
+    {
+        return;
+    }
+
+    bIsLoaded = true;
+
+    FString JsonStr;
+
+    if (!FFileHelper::LoadFileToString(JsonStr, *GetPath()))
+    {
+        return;
+    }
+
+    TSharedPtr<FJsonObject> JsonObject;
+
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonStr), JsonObject) || !JsonObject.IsValid())
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to read predictor history: %s"), *GetPath());
+
+        return;
+    }
+
+    JsonObject->TryGetStringField(TEXT("LastPak"), LastPak);
+
+    const TSharedPtr<FJsonObject>* ObjectField = nullptr;
+
+    if (JsonObject->TryGetObjectField(TEXT("Uses"), ObjectField))
+    {
+        HotUpdatePredictor::ReadCounts(*ObjectField, Uses);
+    }
+
+    if (JsonObject->TryGetObjectField(TEXT("Transitions"), ObjectField))
+    {
+        for (const auto& Value : (*ObjectField)->Values)
+        {
+            HotUpdatePredictor::ReadCounts(Value.Value->AsObject(), Transitions.FindOrAdd(Value.Key));
+        }
+    }
+
+    if (JsonObject->TryGetObjectField(TEXT("Prefetched"), ObjectField))
+    {
+        for (const auto& Value : (*ObjectField)->Values)
+        {
+            Prefetched.Add(Value.Key, static_cast<int64>(Value.Value->AsNumber()));
+        }
+    }
+}
+
+void FHotUpdatePredictor::Save() const
+{
+    FString JsonStr;
+
+    auto JsonWriter = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&JsonStr);
+
+    JsonWriter->WriteObjectStart();
+
+    JsonWriter->WriteValue(TEXT("LastPak"), LastPak);
+
+    HotUpdatePredictor::WriteCounts(JsonWriter, TEXT("Uses"), Uses);
+
+    JsonWriter->WriteObjectStart(TEXT("Transitions"));
+
+    for (const auto& Transition : Transitions)
+    {
+        HotUpdatePredictor::WriteCounts(JsonWriter, Transition.Key, Transition.Value);
+    }
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->WriteObjectStart(TEXT("Prefetched"));
+
+    for (const auto& Pak : Prefetched)
+    {
+        JsonWriter->WriteValue(Pak.Key, Pak.Value);
+    }
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->Close();
+
+    if (!FFileHelper::SaveStringToFile(JsonStr, *GetPath(), FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to write predictor history: %s"), *GetPath());
+    }
+}
+
+FString FHotUpdatePredictor::GetPath()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HotUpdate"), TEXT("Predictor.json"));
+}
@@ -0,0 +1,292 @@
+#include "HotUpdateReport.h"
+#include "FileDownLog.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+
+void FHotUpdateReport::Reset()
+{
+    Files.Empty();
+
+    FileIndices.Empty();
+
+    PhaseTimes.Empty();
+
+    Counters.Empty();
+}
+
+void FHotUpdateReport::SetEnvironment(const FString& Key, const FString& Value)
+{
+    Environment.Add(Key, Value);
+}
+
+void FHotUpdateReport::SetPhaseTime(const FString& Phase, const double Seconds)
+{
+    PhaseTimes.Add(Phase, Seconds);
+}
+
+void FHotUpdateReport::SetCounter(const FString& Counter, const double Value)
+{
+    Counters.Add(Counter, Value);
+}
+
+void FHotUpdateReport::OnFileBegin(const FString& FileName)
+{
+    auto& File = FindOrAddFile(FileName);
+
+    if (File.BeginTime <= 0.0)
+    {
+        File.BeginTime = FPlatformTime::Seconds();
+    }
+}
+
+void FHotUpdateReport::OnRangeEnd(const FString& FileName, const float Latency)
+{
+    auto& File = FindOrAddFile(FileName);
+
+    File.Ranges++;
+
+    File.RangeLatencies.Add(Latency);
+}
+
+void FHotUpdateReport::OnFileEnd(const FString& FileName, const int64 Bytes, const uint32 Retries,
+                                 const int64 DiscardedBytes, const bool bSuccess)
+{
+    auto& File = FindOrAddFile(FileName);
+
+    File.Bytes = Bytes;
+
+    if (File.BeginTime > 0.0)
+    {
+        File.DownloadTime = FPlatformTime::Seconds() - File.BeginTime;
+    }
+
+    File.Retries = Retries;
+
+    File.DiscardedBytes = DiscardedBytes;
+
+    File.bSuccess = bSuccess;
+}
+
+void FHotUpdateReport::AddVerifyTime(const FString& FileName, const double Seconds)
+{
+    FindOrAddFile(FileName).VerifyTime += Seconds;
+}
+
+void FHotUpdateReport::AddMountTime(const FString& FileName, const double Seconds)
+{
+    FindOrAddFile(FileName).MountTime += Seconds;
+}
+
+FHotUpdateFileReport& FHotUpdateReport::FindOrAddFile(const FString& FileName)
+{
+    if (const auto Index = FileIndices.Find(FileName))
+    {
+        return Files[*Index];
+    }
+
+    const auto Index = Files.AddDefaulted();
+
+    Files[Index].FileName = FileName;
+
+    FileIndices.Add(FileName, Index);
+
+    return Files[Index];
+}
+
+float FHotUpdateReport::GetPercentile(TArray<float> Values, const float Percentile)
+{
+    if (Values.Num() <= 0)
+    {
+        return 0.f;
+    }
+
+    Values.Sort();
+
+    const auto Index = FMath::Clamp(FMath::CeilToInt(Percentile * Values.Num()) - 1, 0, Values.Num() - 1);
+
+    return Values[Index];
+}
+
+FString FHotUpdateReport::GetReportSaveRoot()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HotUpdate"), TEXT("Reports"));
+}
+
+bool FHotUpdateReport::Write(const FString& Result, const FString& Message) const
+{
+    FString JsonStr;
+
+    auto JsonWriter = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&JsonStr);
+
+    JsonWriter->WriteObjectStart();
+
+    JsonWriter->WriteValue(TEXT("Result"), Result);
+
+    JsonWriter->WriteValue(TEXT("Message"), Message);
+
+    JsonWriter->WriteValue(TEXT("Time"), FDateTime::UtcNow().ToIso8601());
+
+    JsonWriter->WriteObjectStart(TEXT("Environment"));
+
+    for (const auto& Pair : Environment)
+    {
+        JsonWriter->WriteValue(Pair.Key, Pair.Value);
+    }
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->WriteObjectStart(TEXT("Phases"));
+
+    for (const auto& Pair : PhaseTimes)
+    {
+        JsonWriter->WriteValue(Pair.Key, Pair.Value);
+    }
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->WriteObjectStart(TEXT("Counters"));
+
+    for (const auto& Pair : Counters)
+    {
+        JsonWriter->WriteValue(Pair.Key, Pair.Value);
+    }
+
+    JsonWriter->WriteObjectEnd();
+
+    int64 TotalBytes = 0;
+
+    int64 TotalDiscardedBytes = 0;
+
+    uint32 TotalRetries = 0;
+
+    int32 TotalRanges = 0;
+
+    int32 FailedFiles = 0;
+
+    double TotalDownloadTime = 0.0;
+
+    double TotalVerifyTime = 0.0;
+
+    double TotalMountTime = 0.0;
+
+    TArray<float> AllLatencies;
+
+    JsonWriter->WriteArrayStart(TEXT("Files"));
+
+    for (const auto& File : Files)
+    {
+        float AverageLatency = 0.f;
+
+        for (const auto Latency : File.RangeLatencies)
+        {
+            AverageLatency += Latency;
+        }
+
+        AverageLatency = File.RangeLatencies.Num() > 0 ? AverageLatency / File.RangeLatencies.Num() : 0.f;
+
+        JsonWriter->WriteObjectStart();
+
+        JsonWriter->WriteValue(TEXT("File"), File.FileName);
+
+        JsonWriter->WriteValue(TEXT("Success"), File.bSuccess);
+
+        JsonWriter->WriteValue(TEXT("Bytes"), File.Bytes);
+
+        JsonWriter->WriteValue(TEXT("DownloadTime"), File.DownloadTime);
+
+        JsonWriter->WriteValue(TEXT("Retries"), static_cast<int64>(File.Retries));
+
+        JsonWriter->WriteValue(TEXT("Ranges"), File.Ranges);
+
+        JsonWriter->WriteValue(TEXT("AverageRangeLatencyMs"), AverageLatency);
+
+        JsonWriter->WriteValue(TEXT("P95RangeLatencyMs"), GetPercentile(File.RangeLatencies, 0.95f));
+
+        JsonWriter->WriteValue(TEXT("DiscardedBytes"), File.DiscardedBytes);
+
+        JsonWriter->WriteValue(TEXT("VerifyTime"), File.VerifyTime);
+
+        JsonWriter->WriteValue(TEXT("MountTime"), File.MountTime);
+
+        JsonWriter->WriteObjectEnd();
+
+        TotalBytes += File.Bytes;
+
+        TotalDiscardedBytes += File.DiscardedBytes;
+
+        TotalRetries += File.Retries;
+
+        TotalRanges += File.Ranges;
+
+        FailedFiles += File.bSuccess ? 0 : 1;
+
+        TotalDownloadTime += File.DownloadTime;
+
+        TotalVerifyTime += File.VerifyTime;
+
+        TotalMountTime += File.MountTime;
+
+        AllLatencies.Append(File.RangeLatencies);
+    }
+
+    JsonWriter->WriteArrayEnd();
+
+    float AverageLatency = 0.f;
+
+    for (const auto Latency : AllLatencies)
+    {
+        AverageLatency += Latency;
+    }
+
+    AverageLatency = AllLatencies.Num() > 0 ? AverageLatency / AllLatencies.Num() : 0.f;
+
+    const auto DownloadPhaseTime = PhaseTimes.FindRef(TEXT("Download"));
+
+    JsonWriter->WriteObjectStart(TEXT("Totals"));
+
+    JsonWriter->WriteValue(TEXT("Files"), Files.Num());
+
+    JsonWriter->WriteValue(TEXT("FailedFiles"), FailedFiles);
+
+    JsonWriter->WriteValue(TEXT("Bytes"), TotalBytes);
+
+    JsonWriter->WriteValue(TEXT("DownloadTime"), TotalDownloadTime);
+
+    JsonWriter->WriteValue(TEXT("Retries"), static_cast<int64>(TotalRetries));
+
+    JsonWriter->WriteValue(TEXT("Ranges"), TotalRanges);
+
+    JsonWriter->WriteValue(TEXT("AverageRangeLatencyMs"), AverageLatency);
+
+    JsonWriter->WriteValue(TEXT("P95RangeLatencyMs"), GetPercentile(AllLatencies, 0.95f));
+
+    JsonWriter->WriteValue(TEXT("DiscardedBytes"), TotalDiscardedBytes);
+
+    JsonWriter->WriteValue(TEXT("VerifyTime"), TotalVerifyTime);
+
+    JsonWriter->WriteValue(TEXT("MountTime"), TotalMountTime);
+
+    JsonWriter->WriteValue(TEXT("Throughput"), DownloadPhaseTime > 0.0 ? TotalBytes / DownloadPhaseTime : 0.0);
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->Close();
+
+    const auto& FileName = FPaths::Combine(GetReportSaveRoot(), FString::Printf(
+                                               TEXT("HotUpdateReport_%s.json"), *FDateTime::Now().ToString()));
+
+    if (!FFileHelper::SaveStringToFile(JsonStr, *FileName, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to write report: %s"), *FileName);
+
+        return false;
+    }
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Write report: %s"), *FileName);
+
+    return true;
+}
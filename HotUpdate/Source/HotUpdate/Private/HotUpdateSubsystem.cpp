@@ -7,12 +7,21 @@
 #include "FileDownLog.h"
 #include "IPlatformFilePak.h"
 #include "HttpModule.h"
-#include "TimerManager.h"
 #include "Kismet/GameplayStatics.h"
 #include "Misc/NetworkVersion.h"
 #include "Interfaces/IHttpResponse.h"
 #include "HotUpdateSettings.h"
 #include "Policies/CondensedJsonPrintPolicy.h"
+#include "HotUpdateTrace.h"
+#include "HotUpdateFrameBudget.h"
+#include "HotUpdateMemory.h"
+#include "ManifestParser.h"
+#include "PakVerifier.h"
+#include "HotUpdateTuning.h"
+#include "RemotePakFile.h"
+#include "HotUpdateWarmUp.h"
+#include "Internationalization/Internationalization.h"
+#include "Internationalization/Culture.h"
 
 void UHotUpdateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
@@ -23,6 +32,53 @@ void UHotUpdateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
     bIsUpdating = true;
 
+    CreateManagers();
+}
+
+void UHotUpdateSubsystem::StartUpHeadless(const FString& InVersion, const FString& InPlatform)
+{
+    bIsHeadless = true;
+
+    HeadlessVersion = InVersion;
+
+    HeadlessPlatform = InPlatform;
+
+    bIsUpdating = true;
+
+    if (!DownloadManager.IsValid())
+    {
+        CreateManagers();
+    }
+
+    StartUp();
+}
+
+void UHotUpdateSubsystem::CreateManagers()
+{
+    if (!OnDemand.IsValid())
+    {
+        OnDemand = MakeShareable(new FHotUpdateOnDemand());
+
+        OnDemand->OnBusyChanged.BindUObject(this, &UHotUpdateSubsystem::OnOnDemandBusy);
+    }
+
+    if (!WarmUp.IsValid())
+    {
+        WarmUp = MakeShareable(new FHotUpdateWarmUp());
+
+        WarmUp->OnFinished.BindUObject(this, &UHotUpdateSubsystem::OnWarmUpFinished);
+
+        WarmUp->SetGameplayState(GameplayState);
+    }
+
+    Report = MakeShareable(new FHotUpdateReport());
+
+    Report->SetEnvironment(TEXT("Version"), GetRequestVersion());
+
+    Report->SetEnvironment(TEXT("Platform"), GetRequestPlatform());
+
+    Report->SetEnvironment(TEXT("ConnectionType"), LexToString(FPlatformMisc::GetNetworkConnectionType()));
+
     DownloadManager = MakeShareable(new FFileDownloadManager());
 
     if (!DownloadManager.IsValid())
@@ -32,11 +88,45 @@ void UHotUpdateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
     DownloadManager->OnDownloadEvent.BindUObject(this, &UHotUpdateSubsystem::OnDownloadEvent);
 
+    DownloadManager->SetReport(Report);
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings != nullptr && HotUpdateSettings->bUseTuningProfile)
+    {
+        auto Concurrency = 0;
+
+        auto ChunkSize = 0;
+
+        FHotUpdateTuning::Get().Begin(FHotUpdateTuning::GetKey(GetHotUpdateServerUrl()),
+                                      DownloadManager->GetMaxConcurrency(), Concurrency, ChunkSize);
+
+        DownloadManager->ApplyTuning(Concurrency, ChunkSize);
+    }
+
+    if (GameplayState != EHotUpdateGameplayState::Idle)
+    {
+        DownloadManager->SetGameplayState(GameplayState);
+    }
+
+    if (OnDemand->IsBusy())
+    {
+        DownloadManager->SetOnDemandHeld(true);
+    }
+
     PakManager = MakeShareable(new FFilePakManager());
 
     if (PakManager.IsValid())
     {
         PakManager->OnMountUpdated.BindUObject(this, &UHotUpdateSubsystem::OnMountProcess);
+
+        PakManager->OnMountFinished.BindUObject(this, &UHotUpdateSubsystem::OnMountFinished);
+
+        PakManager->SetReport(Report);
+
+        PakManager->SetMountEnabled(!bIsHeadless);
+
+        PakManager->SetPrefetchPaused(IsNetworkBusy(GameplayState));
     }
 
     OnHotUpdateStateEvent.BindUObject(this, &UHotUpdateSubsystem::OnHotUpdateState);
@@ -44,8 +134,25 @@ void UHotUpdateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
 void UHotUpdateSubsystem::Deinitialize()
 {
+    // Before ShutDown, which would allow prefetch again
+    if (OnDemand.IsValid())
+    {
+        OnDemand->ShutDown();
+
+        OnDemand = nullptr;
+    }
+
     ShutDown();
-    
+
+    if (WarmUp.IsValid())
+    {
+        WarmUp->ShutDown();
+
+        WarmUp = nullptr;
+    }
+
+    RemotePakFile = nullptr;
+
     Super::Deinitialize();
 }
 
@@ -58,6 +165,34 @@ void UHotUpdateSubsystem::StartUp()
         return;
     }
 
+    // A finished update shut its managers down, starting again fetches what a new tag selection adds
+    bIsUpdating = true;
+
+    UpdatePrefetchAllowed();
+
+    if (!DownloadManager.IsValid())
+    {
+        CreateManagers();
+    }
+
+    if (Report.IsValid())
+    {
+        Report->Reset();
+    }
+
+    bHasFailed = false;
+
+    FHotUpdateFrameBudget::Get().ResetStats();
+
+    FHotUpdateMemory::Get().ResetPeaks();
+
+    FPakVerifier::Get().BeginUpdate();
+
+    if (Report.IsValid())
+    {
+        Report->SetEnvironment(TEXT("VerifyTier"), FPakVerifier::GetTierName(FPakVerifier::Get().GetTier()));
+    }
+
     ReqGetVersion();
 }
 
@@ -68,6 +203,21 @@ void UHotUpdateSubsystem::ShutDown()
         Request->OnProcessRequestComplete().Unbind();
     }
 
+    ClearTimeOut();
+
+    FHotUpdateFrameBudget::Get().Cancel(this);
+
+    FPakVerifier::Get().EndUpdate(false);
+
+    ReleaseManifest();
+
+    ManifestPlanner.Reset();
+
+    if (WarmUp.IsValid())
+    {
+        WarmUp->Cancel();
+    }
+
     if (DownloadManager.IsValid())
     {
         DownloadManager->ShutDown();
@@ -83,6 +233,8 @@ void UHotUpdateSubsystem::ShutDown()
     }
 
     bIsUpdating = false;
+
+    UpdatePrefetchAllowed();
 }
 
 bool UHotUpdateSubsystem::CanSkipUpdate()
@@ -109,6 +261,149 @@ void UHotUpdateSubsystem::ForceSkipUpdate() const
     OnSkipUpdate();
 }
 
+void UHotUpdateSubsystem::SetGameplayState(const EHotUpdateGameplayState InState)
+{
+    GameplayState = InState;
+
+    if (DownloadManager.IsValid())
+    {
+        DownloadManager->SetGameplayState(InState);
+    }
+
+    if (PakManager.IsValid())
+    {
+        PakManager->SetPrefetchPaused(IsNetworkBusy(InState));
+    }
+
+    if (RemotePakFile.IsValid())
+    {
+        RemotePakFile->SetPrefetchPaused(IsNetworkBusy(InState));
+    }
+
+    if (WarmUp.IsValid())
+    {
+        WarmUp->SetGameplayState(InState);
+    }
+
+    UpdatePrefetchAllowed();
+}
+
+void UHotUpdateSubsystem::OnRemotePaksInstalled()
+{
+    // A running update still reads through the layer, its pak manager lets go of it on ShutDown
+    RemotePakFile = nullptr;
+}
+
+void UHotUpdateSubsystem::UpdatePrefetchAllowed() const
+{
+    if (OnDemand.IsValid())
+    {
+        OnDemand->SetPrefetchAllowed(!bIsUpdating && (GameplayState == EHotUpdateGameplayState::Idle ||
+            GameplayState == EHotUpdateGameplayState::Menu));
+    }
+}
+
+bool UHotUpdateSubsystem::IsContentAvailable(const FString& PackageName) const
+{
+    return !OnDemand.IsValid() || OnDemand->IsContentAvailable(PackageName);
+}
+
+void UHotUpdateSubsystem::RequestContent(const FString& PackageName, const FOnContentReady& OnReady)
+{
+    if (!OnDemand.IsValid())
+    {
+        OnReady.ExecuteIfBound(true);
+
+        return;
+    }
+
+    OnDemand->Request(PackageName, FOnOnDemandFinished::CreateLambda([OnReady](const bool bIsSucceeded)
+    {
+        OnReady.ExecuteIfBound(bIsSucceeded);
+    }));
+}
+
+void UHotUpdateSubsystem::LoadPackageOnDemand(const FString& PackageName, const FLoadPackageAsyncDelegate& OnLoaded)
+{
+    const auto OnInstalled = FOnOnDemandFinished::CreateLambda([PackageName, OnLoaded](const bool bIsSucceeded)
+    {
+        if (bIsSucceeded)
+        {
+            LoadPackageAsync(PackageName, OnLoaded);
+        }
+        else
+        {
+            OnLoaded.ExecuteIfBound(FName(*PackageName), nullptr, EAsyncLoadingResult::Failed);
+        }
+    });
+
+    if (!OnDemand.IsValid())
+    {
+        OnInstalled.Execute(true);
+
+        return;
+    }
+
+    OnDemand->Request(PackageName, OnInstalled);
+}
+
+void UHotUpdateSubsystem::OnOnDemandBusy(const bool bIsBusy) const
+{
+    if (!DownloadManager.IsValid())
+    {
+        return;
+    }
+
+    DownloadManager->SetOnDemandHeld(bIsBusy);
+}
+
+void UHotUpdateSubsystem::SetSelectedTags(const TArray<FString>& InTags)
+{
+    SelectedTags = InTags;
+
+    SaveConfig();
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Selected tags: %s"), *FString::Join(GetSelectedTags(), TEXT(", ")));
+}
+
+TArray<FString> UHotUpdateSubsystem::GetSelectedTags() const
+{
+    auto Tags = SelectedTags;
+
+    TSet<FString> Dimensions;
+
+    for (const auto& Tag : SelectedTags)
+    {
+        Dimensions.Add(FManifestEntry::GetTagDimension(Tag));
+    }
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    TSet<FString> DefaultDimensions;
+
+    if (HotUpdateSettings != nullptr)
+    {
+        for (const auto& Tag : HotUpdateSettings->DefaultTags)
+        {
+            const auto& Dimension = FManifestEntry::GetTagDimension(Tag);
+
+            if (!Dimensions.Contains(Dimension))
+            {
+                DefaultDimensions.Add(Dimension);
+
+                Tags.AddUnique(Tag);
+            }
+        }
+    }
+
+    if (!Dimensions.Contains(TEXT("lang")) && !DefaultDimensions.Contains(TEXT("lang")))
+    {
+        Tags.Add(TEXT("lang:") + FInternationalization::Get().GetCurrentLanguage()->GetTwoLetterISOLanguageName());
+    }
+
+    return Tags;
+}
+
 void UHotUpdateSubsystem::OnSkipUpdate() const
 {
     OnHotUpdateStateEvent.Execute(EHotUpdateState::END_HOTUPDATE, TEXT("OnSkipUpdate"));
@@ -136,8 +431,27 @@ void UHotUpdateSubsystem::OnMountProcess(const FString& PakName, const float Pro
     OnMountUpdate.Broadcast(PakName, Progress);
 }
 
+void UHotUpdateSubsystem::OnMountFinished(const bool bIsSuccessful)
+{
+    if (bIsSuccessful)
+    {
+        OnHotUpdateStateEvent.Execute(EHotUpdateState::END_MOUNT, TEXT("EndMount"));
+    }
+    else
+    {
+        OnHotUpdateStateEvent.Execute(EHotUpdateState::ERROR, TEXT("Mount failed"));
+    }
+}
+
+void UHotUpdateSubsystem::OnWarmUpFinished()
+{
+    OnHotUpdateStateEvent.Execute(EHotUpdateState::END_WARMUP, TEXT("EndWarmUp"));
+}
+
 void UHotUpdateSubsystem::OnHotUpdateState(const EHotUpdateState State, const FString& Message)
 {
+    TracePhase(State);
+
     if (State != EHotUpdateState::ERROR)
     {
         UE_LOG(LogHotUpdate, Log, TEXT("OnHotUpdateState %s"), *Message);
@@ -149,6 +463,15 @@ void UHotUpdateSubsystem::OnHotUpdateState(const EHotUpdateState State, const FS
 
     switch (State)
     {
+    case EHotUpdateState::ERROR:
+        {
+            bHasFailed = true;
+
+            FPakVerifier::Get().EndUpdate(false);
+
+            WriteReport(TEXT("Error"), Message);
+        }
+        break;
     case EHotUpdateState::END_GETVERSION:
         {
             if (DownloadManager.IsValid())
@@ -169,19 +492,27 @@ void UHotUpdateSubsystem::OnHotUpdateState(const EHotUpdateState State, const FS
             if (PakManager.IsValid())
             {
                 PakManager->StartUp();
-
-                if (PakManager->IsSuccessful())
-                {
-                    OnHotUpdateStateEvent.Execute(EHotUpdateState::END_MOUNT, TEXT("EndMount"));
-                }
-                else
-                {
-                    OnHotUpdateStateEvent.Execute(EHotUpdateState::ERROR, TEXT("Mount failed"));
-                }
             }
         }
         break;
     case EHotUpdateState::END_MOUNT:
+        {
+            OnHotUpdateStateEvent.Execute(EHotUpdateState::BEGIN_WARMUP, TEXT("BeginWarmUp"));
+        }
+        break;
+    case EHotUpdateState::BEGIN_WARMUP:
+        {
+            if (WarmUp.IsValid() && !bIsHeadless)
+            {
+                WarmUp->StartUp();
+            }
+            else
+            {
+                OnWarmUpFinished();
+            }
+        }
+        break;
+    case EHotUpdateState::END_WARMUP:
         {
             OnHotUpdateStateEvent.Execute(EHotUpdateState::END_HOTUPDATE, TEXT("FinishUpdate"));
         }
@@ -190,8 +521,18 @@ void UHotUpdateSubsystem::OnHotUpdateState(const EHotUpdateState State, const FS
         {
             if (IsSuccessful())
             {
+                FPakVerifier::Get().EndUpdate(true);
+
+                WriteReport(TEXT("Success"), Message);
+
                 ShutDown();
 
+                // The first match after the update records what the warm-up of the next update loads
+                if (WarmUp.IsValid() && !bIsHeadless)
+                {
+                    WarmUp->StartRecording();
+                }
+
                 OnHotUpdateFinished.Broadcast();
             }
             else
@@ -204,52 +545,219 @@ void UHotUpdateSubsystem::OnHotUpdateState(const EHotUpdateState State, const FS
     }
 }
 
-void UHotUpdateSubsystem::ReqGetVersion()
+void UHotUpdateSubsystem::TracePhase(const EHotUpdateState State)
 {
-    OnHotUpdateStateEvent.Execute(EHotUpdateState::BEGIN_GETVERSION, TEXT("Begin to get version"));
+    const auto CurrentTime = FPlatformTime::Seconds();
 
-    FString JsonStr;
+    HOTUPDATE_TRACE_BOOKMARK(TEXT("HotUpdate %s"), *UEnum::GetValueAsString(State));
 
-    auto JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonStr);
+    const auto LogPhase = [this, CurrentTime](const TCHAR* Phase)
+    {
+        UE_LOG(LogHotUpdate, Display, TEXT("%s phase took %.2f ms"), Phase, (CurrentTime - PhaseStartTime) * 1000.0);
 
-    JsonWriter->WriteObjectStart();
+        if (Report.IsValid())
+        {
+            Report->SetPhaseTime(Phase, CurrentTime - PhaseStartTime);
+        }
+    };
 
-    JsonWriter->WriteValue(TEXT("version"), FNetworkVersion::GetProjectVersion());
+    switch (State)
+    {
+    case EHotUpdateState::BEGIN_GETVERSION:
+        {
+            if (UpdateStartTime <= 0.0)
+            {
+                UpdateStartTime = CurrentTime;
+            }
+        }
+        break;
+    case EHotUpdateState::END_GETVERSION:
+        {
+            LogPhase(TEXT("GetVersion"));
+        }
+        break;
+    case EHotUpdateState::END_DOWNLOAD:
+        {
+            LogPhase(TEXT("Download"));
+        }
+        break;
+    case EHotUpdateState::END_MOUNT:
+        {
+            LogPhase(TEXT("Mount"));
+        }
+        break;
+    case EHotUpdateState::END_WARMUP:
+        {
+            LogPhase(TEXT("WarmUp"));
+        }
+        break;
+    case EHotUpdateState::END_HOTUPDATE:
+    case EHotUpdateState::ERROR:
+        {
+            if (UpdateStartTime > 0.0)
+            {
+                UE_LOG(LogHotUpdate, Display, TEXT("HotUpdate took %.2f ms"), (CurrentTime - UpdateStartTime) * 1000.0);
 
-    JsonWriter->WriteValue(TEXT("platform"), GetPlatform());
+                if (Report.IsValid())
+                {
+                    Report->SetPhaseTime(TEXT("Total"), CurrentTime - UpdateStartTime);
+                }
+            }
 
-    JsonWriter->WriteObjectEnd();
+            UpdateStartTime = 0.0;
+        }
+        break;
+    default: break;
+    }
 
-    JsonWriter->Close();
+    PhaseStartTime = CurrentTime;
+}
 
-    const auto URL = GetHotUpdateServerUrl();
+void UHotUpdateSubsystem::WriteReport(const FString& Result, const FString& Message) const
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
 
-    if (!Request.IsValid())
+    if (Report.IsValid() && HotUpdateSettings != nullptr && HotUpdateSettings->bWriteReport)
     {
-        Request = FHttpModule::Get().CreateRequest();
-    }
+        const auto& FrameBudget = FHotUpdateFrameBudget::Get();
 
-    Request->SetHeader(TEXT("Content-Type"), TEXT("application/json; charset=utf-8"));
+        Report->SetEnvironment(TEXT("GameThreadBudgetMs"), FString::SanitizeFloat(HotUpdateSettings->GameThreadBudgetMs));
 
-    Request->SetURL(URL);
+        Report->SetCounter(TEXT("LongestFrameWorkMs"), FrameBudget.GetLongestFrameTime());
 
-    Request->SetVerb(TEXT("POST"));
+        Report->SetCounter(TEXT("OverBudgetFrames"), FrameBudget.GetOverBudgetFrames());
 
-    Request->SetContentAsString(JsonStr);
+        const auto& Memory = FHotUpdateMemory::Get();
 
-    Request->OnProcessRequestComplete().BindUObject(this, &UHotUpdateSubsystem::RetGetVersion);
+        Report->SetEnvironment(TEXT("MemoryBudget"), FString::Printf(TEXT("%lld"), FHotUpdateMemory::GetBudget()));
 
-    Request->ProcessRequest();
+        Report->SetCounter(TEXT("PeakMemory"), Memory.GetPeak());
 
-    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+        for (auto i = 0; i < static_cast<int32>(EHotUpdateMemoryStage::Num); ++i)
+        {
+            const auto Stage = static_cast<EHotUpdateMemoryStage>(i);
 
-    GetWorld()->GetTimerManager().SetTimer(TimeOutHandle, this, &UHotUpdateSubsystem::OnReqGetVersionTimeOut,
-                                           HotUpdateSettings != nullptr ? HotUpdateSettings->TimeOutDelay : 10.f,
-                                           false);
+            Report->SetCounter(FString::Printf(TEXT("PeakMemory.%s"), FHotUpdateMemory::GetStageName(Stage)),
+                               Memory.GetStagePeak(Stage));
+        }
+
+        Report->Write(Result, Message);
+    }
 }
 
-void UHotUpdateSubsystem::OnReqGetVersionTimeOut()
+void UHotUpdateSubsystem::ReqGetVersion()
 {
+    HOTUPDATE_TRACE_SCOPE(HotUpdate_ReqGetVersion);
+
+    OnHotUpdateStateEvent.Execute(EHotUpdateState::BEGIN_GETVERSION, TEXT("Begin to get version"));
+
+    if (!Request.IsValid())
+    {
+        Request = FHttpModule::Get().CreateRequest();
+    }
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings != nullptr && HotUpdateSettings->bUseStaticManifest)
+    {
+        // The pointer is the only mutable file of a published tree, the manifest it names never changes
+        Request->SetURL(GetContentURL() + TEXT("pointer.json"));
+
+        Request->SetVerb(TEXT("GET"));
+
+        Request->OnProcessRequestComplete().BindUObject(this, &UHotUpdateSubsystem::RetGetPointer);
+    }
+    else
+    {
+        FString JsonStr;
+
+        auto JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonStr);
+
+        JsonWriter->WriteObjectStart();
+
+        JsonWriter->WriteValue(TEXT("version"), GetRequestVersion());
+
+        JsonWriter->WriteValue(TEXT("platform"), GetRequestPlatform());
+
+        JsonWriter->WriteObjectEnd();
+
+        JsonWriter->Close();
+
+        Request->SetHeader(TEXT("Content-Type"), TEXT("application/json; charset=utf-8"));
+
+        Request->SetURL(GetHotUpdateServerUrl());
+
+        Request->SetVerb(TEXT("POST"));
+
+        Request->SetContentAsString(JsonStr);
+
+        Request->OnProcessRequestComplete().BindUObject(this, &UHotUpdateSubsystem::RetGetVersion);
+    }
+
+    Request->ProcessRequest();
+
+    WarmUpConnections();
+
+    SetTimeOut();
+}
+
+void UHotUpdateSubsystem::SetTimeOut()
+{
+    ClearTimeOut();
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    TimeOutHandle = FTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateUObject(this, &UHotUpdateSubsystem::OnReqGetVersionTimeOut),
+        HotUpdateSettings != nullptr ? HotUpdateSettings->TimeOutDelay : 10.f);
+}
+
+void UHotUpdateSubsystem::ClearTimeOut()
+{
+    if (TimeOutHandle.IsValid())
+    {
+        FTicker::GetCoreTicker().RemoveTicker(TimeOutHandle);
+
+        TimeOutHandle.Reset();
+    }
+}
+
+void UHotUpdateSubsystem::WarmUpConnections() const
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    const auto ConnectionNum = HotUpdateSettings != nullptr ? HotUpdateSettings->WarmUpConnections : 0;
+
+    const auto& URL = GetContentURL();
+
+    // DNS, TCP and TLS are paid here while the manifest is on its way, the tasks reuse the pooled connections
+    for (auto i = 0; i < ConnectionNum; ++i)
+    {
+        const auto WarmUpRequest = FHttpModule::Get().CreateRequest();
+
+        const auto StartTime = FPlatformTime::Seconds();
+
+        WarmUpRequest->SetVerb(TEXT("HEAD"));
+
+        WarmUpRequest->SetURL(URL);
+
+        WarmUpRequest->OnProcessRequestComplete().BindLambda(
+            [StartTime](FHttpRequestPtr, FHttpResponsePtr, const bool bConnectedSuccessfully)
+            {
+                UE_LOG(LogHotUpdate, Verbose, TEXT("Warm up connection %s in %.2f ms"),
+                       bConnectedSuccessfully ? TEXT("succeeded") : TEXT("failed"),
+                       (FPlatformTime::Seconds() - StartTime) * 1000.0);
+            });
+
+        WarmUpRequest->ProcessRequest();
+    }
+}
+
+bool UHotUpdateSubsystem::OnReqGetVersionTimeOut(float)
+{
+    // Fires once, returning false removes it from the ticker
+    TimeOutHandle.Reset();
+
     if (Request.IsValid())
     {
         Request->OnProcessRequestComplete().Unbind();
@@ -269,20 +777,57 @@ void UHotUpdateSubsystem::OnReqGetVersionTimeOut()
     {
         CurrentTimeRetry = 0;
 
-        GetWorld()->GetTimerManager().ClearTimer(TimeOutHandle);
-
         OnHotUpdateStateEvent.Execute(EHotUpdateState::ERROR, TEXT("Error: Failed to req version"));
     }
+
+    return false;
 }
 
-void UHotUpdateSubsystem::RetGetVersion(FHttpRequestPtr, const FHttpResponsePtr Response,
+void UHotUpdateSubsystem::RetGetPointer(FHttpRequestPtr, const FHttpResponsePtr Response,
                                         const bool bConnectedSuccessfully)
 {
-    if (TimeOutHandle.IsValid())
+    if (!bConnectedSuccessfully || !Response.IsValid() || Response->GetResponseCode() >= 400 ||
+        Response->GetResponseCode() < 200)
+    {
+        RetGetVersion(nullptr, Response, bConnectedSuccessfully);
+
+        return;
+    }
+
+    TSharedPtr<FJsonObject> Pointer;
+
+    FString ManifestPath;
+
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Response->GetContentAsString()), Pointer) ||
+        !Pointer.IsValid() || !Pointer->TryGetStringField(TEXT("Manifest"), ManifestPath))
     {
-        GetWorld()->GetTimerManager().ClearTimer(TimeOutHandle);
+        ClearTimeOut();
+
+        OnHotUpdateStateEvent.Execute(EHotUpdateState::ERROR, TEXT("Error: Failed to deserialize json"));
+
+        return;
     }
 
+    UE_LOG(LogHotUpdate, Log, TEXT("Manifest pointer: %s"), *ManifestPath);
+
+    Request = FHttpModule::Get().CreateRequest();
+
+    Request->SetURL(GetHotUpdateServerUrl() + "/" + ManifestPath);
+
+    Request->SetVerb(TEXT("GET"));
+
+    Request->OnProcessRequestComplete().BindUObject(this, &UHotUpdateSubsystem::RetGetVersion);
+
+    Request->ProcessRequest();
+
+    SetTimeOut();
+}
+
+void UHotUpdateSubsystem::RetGetVersion(FHttpRequestPtr, const FHttpResponsePtr Response,
+                                        const bool bConnectedSuccessfully)
+{
+    ClearTimeOut();
+
     if (!bConnectedSuccessfully || !Response.IsValid())
     {
         OnHotUpdateStateEvent.Execute(EHotUpdateState::ERROR,
@@ -307,48 +852,322 @@ void UHotUpdateSubsystem::RetGetVersion(FHttpRequestPtr, const FHttpResponsePtr
         return;
     }
 
-    const auto& URL = GetHotUpdateServerUrl() + "/" + FNetworkVersion::GetProjectVersion() + "/" + GetPlatform() + "/";
+    ReleaseManifest();
+
+    ManifestPlanner.Reset();
+
+    ManifestPlanner.SetReport(Report);
+
+    ManifestPlanner.OnVerified.BindUObject(this, &UHotUpdateSubsystem::VerifyManifest);
+
+    ActiveTags = TSet<FString>(GetSelectedTags());
+
+    AvailableTags.Reset();
+
+    SkippedEntryNum = 0;
+
+    SkippedEntrySize = 0;
+
+    if (Report.IsValid())
+    {
+        Report->SetEnvironment(TEXT("Tags"), FString::Join(ActiveTags.Array(), TEXT(",")));
+    }
+
+    ManifestURL = GetContentURL();
+
+    ManifestResponse = Response;
+
+    ManifestMemorySize = Response->GetContent().Num();
+
+    FHotUpdateMemory::Get().Alloc(EHotUpdateMemoryStage::GetVersion, ManifestMemorySize);
+
+    ManifestParser = MakeShareable(new FManifestParser(Response->GetContent()));
+
+    ManifestParser->OnEntry.BindUObject(this, &UHotUpdateSubsystem::OnManifestEntry);
+
+    ParseManifest();
+}
+
+void UHotUpdateSubsystem::ParseManifest()
+{
+    if (!ManifestParser.IsValid())
+    {
+        return;
+    }
+
+    HOTUPDATE_TRACE_SCOPE(HotUpdate_ParseManifest);
 
-    TSharedPtr<FJsonObject> JsonObject;
+    HOTUPDATE_LLM_SCOPE();
 
-    const auto& JsonReader = TJsonReaderFactory<>::Create(Response->GetContentAsString());
+    const auto Result = ManifestParser->Parse(GetSliceTime());
 
-    if (FJsonSerializer::Deserialize(JsonReader, JsonObject))
+    if (Result == EManifestParseResult::Pending)
     {
-        for (const auto& Value : JsonObject->Values)
+        FHotUpdateFrameBudget::Get().Enqueue(this, [this]()
         {
-            const auto& Files = Value.Value->AsArray();
+            ParseManifest();
+        });
 
-            for (const auto& File : Files)
-            {
-                const auto& FileObject = File->AsObject();
+        return;
+    }
 
-                const auto& FileName = FileObject->GetStringField("File");
+    UE_LOG(LogHotUpdate, Log, TEXT("Parse manifest: %d entries, %d unique files, %d not selected by tags (%s)"),
+           ManifestParser->GetEntryNum(), ManifestPlanner.GetEntries().Num(), SkippedEntryNum,
+           *FDownloadProgress::ConvertIntToSize(SkippedEntrySize));
 
-                const auto& Hash = FileObject->GetStringField("HASH");
+    if (Report.IsValid())
+    {
+        Report->SetCounter(TEXT("UnselectedEntries"), SkippedEntryNum);
 
-                const auto Size = FileObject->GetIntegerField("Size");
+        Report->SetCounter(TEXT("UnselectedBytes"), SkippedEntrySize);
+    }
 
-                FPakFileProperty PakFileProperty(FileName, Size, Hash);
+    const auto ErrorMessage = ManifestParser->GetErrorMessage();
 
-                if (!FFilePakManager::IsPakValid(PakFileProperty))
-                {
-                    DownloadManager->AddTask(URL + FileName, FileName, Size);
-                }
+    ReleaseManifest();
 
-                PakManager->AddPakFile(MoveTemp(PakFileProperty));
-            }
-        }
+    if (Result == EManifestParseResult::Finished)
+    {
+        StartMissingTasks();
 
-        OnHotUpdateStateEvent.Execute(EHotUpdateState::END_GETVERSION, TEXT("End to get version"));
+        VerifyManifest();
     }
     else
     {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to parse manifest: %s"), *ErrorMessage);
+
         OnHotUpdateStateEvent.Execute(EHotUpdateState::ERROR,
                                       TEXT("Error: Failed to deserialize json"));
     }
 }
 
+void UHotUpdateSubsystem::OnManifestEntry(const FManifestEntry& Entry)
+{
+    AvailableTags.Append(Entry.Tags);
+
+    if (!Entry.MatchesTags(ActiveTags))
+    {
+        SkippedEntryNum++;
+
+        SkippedEntrySize += Entry.Size;
+
+        return;
+    }
+
+    ManifestPlanner.AddEntry(Entry);
+}
+
+void UHotUpdateSubsystem::StartMissingTasks()
+{
+    if (!DownloadManager.IsValid())
+    {
+        return;
+    }
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    const auto MaxNum = HotUpdateSettings != nullptr
+                            ? FMath::Max3(HotUpdateSettings->MaxConcurrency, HotUpdateSettings->WarmUpConnections, 1)
+                            : 1;
+
+    TArray<int32> Indices;
+
+    ManifestPlanner.TakeMissingEntries(MaxNum, Indices);
+
+    if (Indices.Num() <= 0)
+    {
+        return;
+    }
+
+    const auto& Entries = ManifestPlanner.GetEntries();
+
+    for (const auto Index : Indices)
+    {
+        const auto& Entry = Entries[Index];
+
+        DownloadManager->AddTask(GetEntryURL(Entry), Entry.ToPakFileProperty());
+    }
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Start %d missing files before verify"), Indices.Num());
+
+    DownloadManager->StartUp();
+}
+
+void UHotUpdateSubsystem::VerifyManifest()
+{
+    HOTUPDATE_TRACE_SCOPE(HotUpdate_VerifyManifest);
+
+    // The planner calls back once the paks are verified on the thread pool
+    if (!ManifestPlanner.Verify())
+    {
+        return;
+    }
+
+    ScheduleManifest();
+}
+
+void UHotUpdateSubsystem::ScheduleManifest()
+{
+    if (!DownloadManager.IsValid() || !PakManager.IsValid())
+    {
+        return;
+    }
+
+    const auto& Entries = ManifestPlanner.GetEntries();
+
+    auto LocalCopyNum = 0;
+
+    auto RepairNum = 0;
+
+    auto RemotePakNum = 0;
+
+    int64 RemotePakSize = 0;
+
+    auto OnDemandNum = 0;
+
+    int64 OnDemandSize = 0;
+
+    if (OnDemand.IsValid())
+    {
+        OnDemand->Reset();
+    }
+
+    if (WarmUp.IsValid())
+    {
+        WarmUp->Reset();
+    }
+
+    for (auto i = 0; i < Entries.Num(); ++i)
+    {
+        const auto& Entry = Entries[i];
+
+        // Installed by the first request for its content, seeding keeps every file. Paks already on disk, such as
+        // prefetched ones, are mounted by the update and only tracked for usage
+        if (!Entry.OnDemand.IsEmpty() && ManifestPlanner.IsEntryValid(i) && !bIsHeadless && OnDemand.IsValid())
+        {
+            OnDemand->AddPak(GetEntryURL(Entry), Entry.ToPakFileProperty(), Entry.OnDemand, true);
+        }
+        else if (!Entry.OnDemand.IsEmpty() && !bIsHeadless && OnDemand.IsValid())
+        {
+            OnDemand->AddPak(GetEntryURL(Entry), Entry.ToPakFileProperty(), Entry.OnDemand, false);
+
+            OnDemandNum++;
+
+            OnDemandSize += Entry.Size;
+
+            continue;
+        }
+
+        PakManager->AddPakFile(Entry.ToPakFileProperty());
+
+        // Only what this update patches starts cold
+        if (!ManifestPlanner.IsEntryValid(i) && WarmUp.IsValid())
+        {
+            WarmUp->AddPackages(Entry.WarmUp);
+        }
+
+        if (ManifestPlanner.IsEntryValid(i) || ManifestPlanner.IsEntryTaken(i))
+        {
+            continue;
+        }
+
+        const auto Source = ManifestPlanner.FindValidSource(i);
+
+        // Copied on the thread pool, the download only finishes once the copy is in place
+        if (Source != INDEX_NONE)
+        {
+            const auto& SourceFile = FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), Entries[Source].File);
+
+            DownloadManager->AddLocalCopy(GetEntryURL(Entry), Entry.ToPakFileProperty(), SourceFile);
+
+            LocalCopyNum++;
+
+            continue;
+        }
+
+        if (const auto RepairBlocks = ManifestPlanner.FindRepairBlocks(i))
+        {
+            DownloadManager->AddRepairTask(GetEntryURL(Entry), Entry.ToPakFileProperty(), *RepairBlocks);
+
+            RepairNum++;
+
+            continue;
+        }
+
+        // Seeding keeps whole files, the game mounts large paks from the server and fills them in the background
+        if (!bIsHeadless && FRemotePakPlatformFile::CanStream(Entry.ToPakFileProperty()))
+        {
+            if (!RemotePakFile.IsValid())
+            {
+                RemotePakFile = MakeShared<FRemotePakPlatformFile>();
+
+                RemotePakFile->OnInstalled.BindUObject(this, &UHotUpdateSubsystem::OnRemotePaksInstalled);
+            }
+
+            PakManager->SetRemotePakPlatformFile(RemotePakFile);
+
+            PakManager->AddRemotePak(GetEntryURL(Entry), Entry.ToPakFileProperty());
+
+            RemotePakNum++;
+
+            RemotePakSize += Entry.Size;
+
+            continue;
+        }
+
+        DownloadManager->AddTask(GetEntryURL(Entry), Entry.ToPakFileProperty());
+    }
+
+    if (Report.IsValid())
+    {
+        Report->SetCounter(TEXT("DuplicatedPaths"), ManifestPlanner.GetDuplicatedPathNum());
+
+        Report->SetCounter(TEXT("LocalCopies"), LocalCopyNum);
+
+        Report->SetCounter(TEXT("Repairs"), RepairNum);
+
+        Report->SetCounter(TEXT("RemotePaks"), RemotePakNum);
+
+        Report->SetCounter(TEXT("RemotePakBytes"), RemotePakSize);
+
+        Report->SetCounter(TEXT("OnDemandPaks"), OnDemandNum);
+
+        Report->SetCounter(TEXT("OnDemandBytes"), OnDemandSize);
+    }
+
+    ManifestPlanner.Reset();
+
+    DownloadManager->SealTasks();
+
+    OnHotUpdateStateEvent.Execute(EHotUpdateState::END_GETVERSION, TEXT("End to get version"));
+}
+
+bool UHotUpdateSubsystem::IsNetworkBusy(const EHotUpdateGameplayState InState)
+{
+    return InState == EHotUpdateGameplayState::InMatch || InState == EHotUpdateGameplayState::LatencySensitive;
+}
+
+double UHotUpdateSubsystem::GetSliceTime()
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    return HotUpdateSettings != nullptr ? FMath::Max(HotUpdateSettings->GameThreadBudgetMs / 1000.0, 0.0) : 0.0;
+}
+
+void UHotUpdateSubsystem::ReleaseManifest()
+{
+    if (ManifestParser.IsValid())
+    {
+        FHotUpdateMemory::Get().Free(EHotUpdateMemoryStage::GetVersion, ManifestMemorySize);
+
+        ManifestMemorySize = 0;
+    }
+
+    ManifestParser = nullptr;
+
+    ManifestResponse = nullptr;
+}
+
 bool UHotUpdateSubsystem::IsSuccessful() const
 {
     if (!DownloadManager.IsValid() || !DownloadManager->IsSuccessful())
@@ -375,6 +1194,18 @@ void UHotUpdateSubsystem::OnDownloadEvent(const EDownloadState Event, const FTas
         break;
     case EDownloadState::END_DOWNLOAD:
         {
+            if (DownloadManager.IsValid() && !DownloadManager->IsSuccessful())
+            {
+                OnHotUpdateStateEvent.Execute(EHotUpdateState::ERROR, TEXT("Download failed"));
+
+                return;
+            }
+
+            if (DownloadManager.IsValid() && DownloadManager->IsTuningSample())
+            {
+                FHotUpdateTuning::Get().End(DownloadManager->GetDownloadedSize(), DownloadManager->GetElapsedTime());
+            }
+
             OnHotUpdateStateEvent.Execute(EHotUpdateState::END_DOWNLOAD, FString(TEXT("EndDownload")));
         }
         break;
@@ -400,3 +1231,23 @@ FString UHotUpdateSubsystem::GetHotUpdateServerUrl() const
 
     return HotUpdateSettings != nullptr ? HotUpdateSettings->HotUpdateServerUrl : "";
 }
+
+FString UHotUpdateSubsystem::GetContentURL() const
+{
+    return GetHotUpdateServerUrl() + "/" + GetRequestVersion() + "/" + GetRequestPlatform() + "/";
+}
+
+FString UHotUpdateSubsystem::GetRequestVersion() const
+{
+    return HeadlessVersion.IsEmpty() ? FNetworkVersion::GetProjectVersion() : HeadlessVersion;
+}
+
+FString UHotUpdateSubsystem::GetRequestPlatform() const
+{
+    return HeadlessPlatform.IsEmpty() ? GetPlatform() : HeadlessPlatform;
+}
+
+FString UHotUpdateSubsystem::GetEntryURL(const FManifestEntry& Entry) const
+{
+    return Entry.Url.IsEmpty() ? ManifestURL + Entry.File : GetHotUpdateServerUrl() + "/" + Entry.Url;
+}
@@ -0,0 +1,233 @@
+#include "HotUpdateTuning.h"
+#include "FileDownLog.h"
+#include "DownLoadTask.h"
+#include "PlatformHttp.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/JsonSerializer.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+
+FHotUpdateTuning& FHotUpdateTuning::Get()
+{
+    static FHotUpdateTuning Instance;
+
+    return Instance;
+}
+
+FString FHotUpdateTuning::GetKey(const FString& ServerUrl)
+{
+    return FString::Printf(TEXT("%s|%s"), LexToString(FPlatformMisc::GetNetworkConnectionType()),
+                           *FPlatformHttp::GetUrlDomain(ServerUrl));
+}
+
+void FHotUpdateTuning::Begin(const FString& InKey, const int32 DefaultConcurrency, int32& OutConcurrency,
+                             int32& OutChunkSize)
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    if (!bIsLoaded)
+    {
+        LoadProfiles();
+
+        bIsLoaded = true;
+    }
+
+    Key = InKey;
+
+    OutConcurrency = DefaultConcurrency;
+
+    OutChunkSize = 0;
+
+    // Unlimited downloads have no concurrency to start from
+    if (DefaultConcurrency <= 0)
+    {
+        TrialConcurrency = 0;
+
+        UE_LOG(LogHotUpdate, Log, TEXT("Max concurrency is unlimited, no tuning for %s"), *Key);
+
+        return;
+    }
+
+    const auto Profile = Profiles.Find(Key);
+
+    if (Profile == nullptr || Profile->Concurrency <= 0)
+    {
+        TrialConcurrency = DefaultConcurrency;
+
+        UE_LOG(LogHotUpdate, Log, TEXT("No tuning profile for %s"), *Key);
+
+        return;
+    }
+
+    TrialConcurrency = Profile->Concurrency;
+
+    if (Profile->Sessions % 2 == 1)
+    {
+        // At 1 or MaxProbeConcurrency the only way left to probe is back
+        if (FMath::Clamp(Profile->Concurrency + Profile->Direction, 1, MaxProbeConcurrency) == Profile->Concurrency)
+        {
+            Profile->Direction = -Profile->Direction;
+        }
+
+        TrialConcurrency = FMath::Clamp(Profile->Concurrency + Profile->Direction, 1, MaxProbeConcurrency);
+    }
+
+    OutConcurrency = TrialConcurrency;
+
+    OutChunkSize = Profile->ChunkSize;
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Tuning profile %s: concurrency %d (best %d at %.1f KB/s), chunk size %d"), *Key,
+           TrialConcurrency, Profile->Concurrency, Profile->Throughput / 1024.0, Profile->ChunkSize);
+}
+
+void FHotUpdateTuning::End(const int64 DownloadedSize, const double Seconds)
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    if (Key.IsEmpty() || TrialConcurrency <= 0)
+    {
+        return;
+    }
+
+    if (DownloadedSize < MinSampleSize || Seconds <= 0.0)
+    {
+        UE_LOG(LogHotUpdate, Log, TEXT("Session too short to tune: %lld bytes in %.2f s"), DownloadedSize, Seconds);
+
+        Key.Empty();
+
+        return;
+    }
+
+    const auto Throughput = DownloadedSize / Seconds;
+
+    auto& Profile = Profiles.FindOrAdd(Key);
+
+    if (Profile.Concurrency <= 0)
+    {
+        Profile.Concurrency = TrialConcurrency;
+
+        Profile.Throughput = Throughput;
+    }
+    else if (TrialConcurrency != Profile.Concurrency)
+    {
+        // A probe has to win clearly, the same setting varies a few percent between sessions
+        if (Throughput > Profile.Throughput * 1.05)
+        {
+            Profile.Concurrency = TrialConcurrency;
+
+            Profile.Throughput = Throughput;
+        }
+        else
+        {
+            Profile.Direction = -Profile.Direction;
+        }
+    }
+    else
+    {
+        // Follow the network drifting, a single slow session doesn't wipe out the history
+        Profile.Throughput = FMath::Lerp(Profile.Throughput, Throughput, 0.3);
+    }
+
+    const auto ConnectionThroughput = Profile.Throughput / FMath::Max(Profile.Concurrency, 1);
+
+    const auto RangeSize = FMath::Clamp<double>(ConnectionThroughput * TargetRangeSeconds, FDownloadTask::MinChunkSize,
+                                                FDownloadTask::DefaultChunkSize);
+
+    Profile.ChunkSize = FMath::RoundUpToPowerOfTwo(static_cast<uint32>(RangeSize));
+
+    ++Profile.Sessions;
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Tuning %s: %.1f KB/s at concurrency %d, best %d at %.1f KB/s, chunk size %d"),
+           *Key, Throughput / 1024.0, TrialConcurrency, Profile.Concurrency, Profile.Throughput / 1024.0,
+           Profile.ChunkSize);
+
+    Key.Empty();
+
+    SaveProfiles();
+}
+
+void FHotUpdateTuning::LoadProfiles()
+{
+    Profiles.Empty();
+
+    FString JsonStr;
+
+    if (!FFileHelper::LoadFileToString(JsonStr, *GetProfilePath()))
+    {
+        return;
+    }
+
+    TSharedPtr<FJsonObject> JsonObject;
+
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonStr), JsonObject) || !JsonObject.IsValid())
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to read tuning profiles: %s"), *GetProfilePath());
+
+        return;
+    }
+
+    for (const auto& Value : JsonObject->Values)
+    {
+        const auto& ProfileObject = Value.Value->AsObject();
+
+        if (!ProfileObject.IsValid())
+        {
+            continue;
+        }
+
+        FHotUpdateTuningProfile Profile;
+
+        Profile.Concurrency = ProfileObject->GetIntegerField(TEXT("Concurrency"));
+
+        Profile.ChunkSize = ProfileObject->GetIntegerField(TEXT("ChunkSize"));
+
+        Profile.Throughput = ProfileObject->GetNumberField(TEXT("Throughput"));
+
+        Profile.Direction = ProfileObject->GetIntegerField(TEXT("Direction")) < 0 ? -1 : 1;
+
+        Profile.Sessions = ProfileObject->GetIntegerField(TEXT("Sessions"));
+
+        Profiles.Add(Value.Key, Profile);
+    }
+}
+
+void FHotUpdateTuning::SaveProfiles() const
+{
+    FString JsonStr;
+
+    auto JsonWriter = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&JsonStr);
+
+    JsonWriter->WriteObjectStart();
+
+    for (const auto& Profile : Profiles)
+    {
+        JsonWriter->WriteObjectStart(Profile.Key);
+
+        JsonWriter->WriteValue(TEXT("Concurrency"), Profile.Value.Concurrency);
+
+        JsonWriter->WriteValue(TEXT("ChunkSize"), Profile.Value.ChunkSize);
+
+        JsonWriter->WriteValue(TEXT("Throughput"), Profile.Value.Throughput);
+
+        JsonWriter->WriteValue(TEXT("Direction"), Profile.Value.Direction);
+
+        JsonWriter->WriteValue(TEXT("Sessions"), Profile.Value.Sessions);
+
+        JsonWriter->WriteObjectEnd();
+    }
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->Close();
+
+    if (!FFileHelper::SaveStringToFile(JsonStr, *GetProfilePath(), FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to write tuning profiles: %s"), *GetProfilePath());
+    }
+}
+
+FString FHotUpdateTuning::GetProfilePath()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HotUpdate"), TEXT("Tuning.json"));
+}
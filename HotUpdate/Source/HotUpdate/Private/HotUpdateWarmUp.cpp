@@ -0,0 +1,437 @@
+#include "HotUpdateWarmUp.h"
+#include "FileDownLog.h"
+#include "HotUpdateSettings.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+
+FHotUpdateWarmUp::~FHotUpdateWarmUp()
+{
+    ShutDown();
+}
+
+void FHotUpdateWarmUp::Reset()
+{
+    Stop();
+
+    Release();
+
+    Packages.Reset();
+
+    PackageNames.Reset();
+
+    ReadAheadIndex = 0;
+
+    LoadIndex = 0;
+
+    LoadingNum = 0;
+
+    WarmedSize = 0;
+
+    bHasPlayed = false;
+}
+
+void FHotUpdateWarmUp::AddPackages(const TArray<FString>& InPackageNames)
+{
+    for (const auto& PackageName : InPackageNames)
+    {
+        auto bIsAlreadyInSet = false;
+
+        PackageNames.Add(PackageName, &bIsAlreadyInSet);
+
+        if (!bIsAlreadyInSet)
+        {
+            Packages.AddDefaulted_GetRef().PackageName = PackageName;
+        }
+    }
+}
+
+void FHotUpdateWarmUp::StartUp()
+{
+    Stop();
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings == nullptr || HotUpdateSettings->WarmUpBudget <= 0 || IsRunningCommandlet())
+    {
+        OnFinished.ExecuteIfBound();
+
+        return;
+    }
+
+    LoadRecord();
+
+    if (LoadIndex >= Packages.Num())
+    {
+        OnFinished.ExecuteIfBound();
+
+        return;
+    }
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Warm up %d packages"), Packages.Num() - LoadIndex);
+
+    StartTime = FPlatformTime::Seconds();
+
+    TickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FHotUpdateWarmUp::Tick));
+}
+
+void FHotUpdateWarmUp::Cancel()
+{
+    Stop();
+}
+
+void FHotUpdateWarmUp::ShutDown()
+{
+    Stop();
+
+    Release();
+
+    StopRecording();
+
+    OnFinished.Unbind();
+}
+
+void FHotUpdateWarmUp::SetGameplayState(const EHotUpdateGameplayState InState)
+{
+    GameplayState = InState;
+
+    if (GameplayState == EHotUpdateGameplayState::InMatch)
+    {
+        bHasPlayed = true;
+
+        return;
+    }
+
+    // The first match after the update is over, its packages are loaded by now or were not needed
+    if (bHasPlayed &&
+        (GameplayState == EHotUpdateGameplayState::Idle || GameplayState == EHotUpdateGameplayState::Menu))
+    {
+        bHasPlayed = false;
+
+        Release();
+
+        StopRecording();
+    }
+}
+
+void FHotUpdateWarmUp::StartRecording()
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (bIsRecording || HotUpdateSettings == nullptr || HotUpdateSettings->WarmUpRecordLimit <= 0)
+    {
+        return;
+    }
+
+    bIsRecording = true;
+
+    bHasPlayed = false;
+
+    Record.Reset();
+
+    RecordedNames.Reset();
+
+    AsyncLoadHandle = FCoreDelegates::OnAsyncLoadPackage.AddSP(this, &FHotUpdateWarmUp::OnLoadPackage);
+
+    SyncLoadHandle = FCoreDelegates::OnSyncLoadPackage.AddSP(this, &FHotUpdateWarmUp::OnLoadPackage);
+}
+
+void FHotUpdateWarmUp::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    Collector.AddReferencedObjects(LoadedPackages);
+}
+
+bool FHotUpdateWarmUp::Tick(float)
+{
+    for (auto i = ReadAheads.Num() - 1; i >= 0; --i)
+    {
+        if (ReadAheads[i].Request->PollCompletion())
+        {
+            delete ReadAheads[i].Request;
+
+            delete ReadAheads[i].Handle;
+
+            ReadAheads.RemoveAtSwap(i);
+        }
+    }
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings == nullptr)
+    {
+        TickHandle.Reset();
+
+        Finish();
+
+        return false;
+    }
+
+    const auto Budget = static_cast<int64>(HotUpdateSettings->WarmUpBudget) * 1024 * 1024;
+
+    const auto Concurrency = FMath::Max(HotUpdateSettings->WarmUpConcurrency, 1);
+
+    // Reads run a few packages in front of the loads, so the loads find their bytes cached
+    while (ReadAheadIndex < Packages.Num() && ReadAheadIndex < LoadIndex + Concurrency * 2 && WarmedSize < Budget)
+    {
+        ReadAhead(Packages[ReadAheadIndex++]);
+    }
+
+    while (LoadingNum < Concurrency && LoadIndex < ReadAheadIndex)
+    {
+        const auto& Package = Packages[LoadIndex++];
+
+        if (!Package.bExists)
+        {
+            continue;
+        }
+
+        LoadingNum++;
+
+        LoadPackageAsync(Package.PackageName,
+                         FLoadPackageAsyncDelegate::CreateSP(this, &FHotUpdateWarmUp::OnPackageLoaded, Generation));
+    }
+
+    const auto bIsDone = LoadIndex >= ReadAheadIndex && LoadingNum == 0 &&
+        (ReadAheadIndex >= Packages.Num() || WarmedSize >= Budget);
+
+    const auto bIsOutOfTime = FPlatformTime::Seconds() - StartTime >= HotUpdateSettings->WarmUpTimeLimit;
+
+    // Loads in flight still finish and are kept when the player starts to play
+    const auto bHasLeftMenu = GameplayState == EHotUpdateGameplayState::InMatch ||
+        GameplayState == EHotUpdateGameplayState::LatencySensitive;
+
+    if (bIsDone || bIsOutOfTime || bHasLeftMenu)
+    {
+        TickHandle.Reset();
+
+        Finish();
+
+        return false;
+    }
+
+    return true;
+}
+
+void FHotUpdateWarmUp::ReadAhead(FWarmUpPackage& Package)
+{
+    FString Filename;
+
+    Package.bExists = FPackageName::DoesPackageExist(Package.PackageName, nullptr, &Filename);
+
+    if (!Package.bExists)
+    {
+        UE_LOG(LogHotUpdate, Verbose, TEXT("Skip warm up of missing package %s"), *Package.PackageName);
+
+        return;
+    }
+
+    auto& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+    for (const auto& File : {Filename, FPaths::ChangeExtension(Filename, TEXT(".uexp"))})
+    {
+        const auto Size = PlatformFile.FileSize(*File);
+
+        if (Size <= 0)
+        {
+            continue;
+        }
+
+        Package.Size += Size;
+
+        FReadAhead Read;
+
+        Read.Handle = PlatformFile.OpenAsyncRead(*File);
+
+        if (Read.Handle == nullptr)
+        {
+            continue;
+        }
+
+        Read.Request = Read.Handle->ReadRequest(0, Size, AIOP_Precache);
+
+        if (Read.Request == nullptr)
+        {
+            delete Read.Handle;
+
+            continue;
+        }
+
+        ReadAheads.Add(Read);
+    }
+
+    WarmedSize += Package.Size;
+}
+
+void FHotUpdateWarmUp::OnPackageLoaded(const FName& PackageName, UPackage* Package,
+                                       const EAsyncLoadingResult::Type Result, const uint32 InGeneration)
+{
+    if (InGeneration != Generation)
+    {
+        return;
+    }
+
+    LoadingNum = FMath::Max(LoadingNum - 1, 0);
+
+    if (Result == EAsyncLoadingResult::Succeeded && Package != nullptr)
+    {
+        LoadedPackages.Add(Package);
+    }
+    else
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to warm up package %s"), *PackageName.ToString());
+    }
+}
+
+void FHotUpdateWarmUp::Finish()
+{
+    Stop();
+
+    UE_LOG(LogHotUpdate, Display, TEXT("Warmed up %d of %d packages, %.2f MB in %.2f s"), LoadedPackages.Num(),
+           Packages.Num(), WarmedSize / 1024.0 / 1024.0, FPlatformTime::Seconds() - StartTime);
+
+    OnFinished.ExecuteIfBound();
+}
+
+void FHotUpdateWarmUp::Stop()
+{
+    if (TickHandle.IsValid())
+    {
+        FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+        TickHandle.Reset();
+    }
+
+    ReleaseReadAheads();
+}
+
+void FHotUpdateWarmUp::ReleaseReadAheads()
+{
+    for (const auto& Read : ReadAheads)
+    {
+        Read.Request->Cancel();
+
+        Read.Request->WaitCompletion();
+
+        delete Read.Request;
+
+        delete Read.Handle;
+    }
+
+    ReadAheads.Empty();
+}
+
+void FHotUpdateWarmUp::Release()
+{
+    Generation++;
+
+    LoadingNum = 0;
+
+    LoadedPackages.Empty();
+}
+
+void FHotUpdateWarmUp::OnLoadPackage(const FString& PackageName)
+{
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings == nullptr || Record.Num() >= HotUpdateSettings->WarmUpRecordLimit ||
+        !FPackageName::IsValidLongPackageName(PackageName) || PackageName.StartsWith(TEXT("/Script/")) ||
+        PackageName.StartsWith(TEXT("/Temp/")))
+    {
+        return;
+    }
+
+    auto bIsAlreadyInSet = false;
+
+    RecordedNames.Add(PackageName, &bIsAlreadyInSet);
+
+    if (!bIsAlreadyInSet)
+    {
+        Record.Add(PackageName);
+    }
+}
+
+void FHotUpdateWarmUp::StopRecording()
+{
+    if (!bIsRecording)
+    {
+        return;
+    }
+
+    bIsRecording = false;
+
+    FCoreDelegates::OnAsyncLoadPackage.Remove(AsyncLoadHandle);
+
+    FCoreDelegates::OnSyncLoadPackage.Remove(SyncLoadHandle);
+
+    // Nothing was played, keep the record of the last match
+    if (Record.Num() == 0)
+    {
+        return;
+    }
+
+    FString JsonStr;
+
+    auto JsonWriter = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&JsonStr);
+
+    JsonWriter->WriteObjectStart();
+
+    JsonWriter->WriteArrayStart(TEXT("Packages"));
+
+    for (const auto& PackageName : Record)
+    {
+        JsonWriter->WriteValue(PackageName);
+    }
+
+    JsonWriter->WriteArrayEnd();
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->Close();
+
+    if (FFileHelper::SaveStringToFile(JsonStr, *GetPath(), FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+    {
+        UE_LOG(LogHotUpdate, Log, TEXT("Recorded %d packages for warm up"), Record.Num());
+    }
+    else
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to write warm up record: %s"), *GetPath());
+    }
+
+    Record.Empty();
+
+    RecordedNames.Empty();
+}
+
+void FHotUpdateWarmUp::LoadRecord()
+{
+    FString JsonStr;
+
+    if (!FFileHelper::LoadFileToString(JsonStr, *GetPath()))
+    {
+        return;
+    }
+
+    TSharedPtr<FJsonObject> JsonObject;
+
+    TArray<FString> RecordedPackages;
+
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonStr), JsonObject) || !JsonObject.IsValid() ||
+        !JsonObject->TryGetStringArrayField(TEXT("Packages"), RecordedPackages))
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to read warm up record: %s"), *GetPath());
+
+        return;
+    }
+
+    AddPackages(RecordedPackages);
+}
+
+FString FHotUpdateWarmUp::GetPath()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HotUpdate"), TEXT("WarmUp.json"));
+}
@@ -0,0 +1,233 @@
+#include "ManifestParser.h"
+
+namespace ManifestParser
+{
+    /** The reader widens each utf8 byte to one TCHAR, put multi-byte sequences back together */
+    static FString DecodeUTF8(const FString& Value)
+    {
+        auto bIsMultiByte = false;
+
+        for (const auto Char : Value)
+        {
+            if (Char > 0xFF)
+            {
+                return Value;
+            }
+
+            bIsMultiByte |= Char >= 0x80;
+        }
+
+        if (!bIsMultiByte)
+        {
+            return Value;
+        }
+
+        TArray<ANSICHAR> Bytes;
+
+        Bytes.Reserve(Value.Len() + 1);
+
+        for (const auto Char : Value)
+        {
+            Bytes.Add(static_cast<ANSICHAR>(Char));
+        }
+
+        Bytes.Add('\0');
+
+        return FString(UTF8_TO_TCHAR(Bytes.GetData()));
+    }
+}
+
+FPakFileProperty FManifestEntry::ToPakFileProperty() const
+{
+    FPakFileProperty PakFileProperty(File, Size, Hash);
+
+    PakFileProperty.IndexHash = IndexHash;
+
+    PakFileProperty.BlockSize = BlockSize;
+
+    PakFileProperty.BlockHashes = Blocks;
+
+    return PakFileProperty;
+}
+
+bool FManifestEntry::MatchesTags(const TSet<FString>& SelectedTags) const
+{
+    TSet<FString> Dimensions;
+
+    TSet<FString> MatchedDimensions;
+
+    for (const auto& Tag : Tags)
+    {
+        const auto& Dimension = GetTagDimension(Tag);
+
+        Dimensions.Add(Dimension);
+
+        if (SelectedTags.Contains(Tag))
+        {
+            MatchedDimensions.Add(Dimension);
+        }
+    }
+
+    return MatchedDimensions.Num() == Dimensions.Num();
+}
+
+FString FManifestEntry::GetTagDimension(const FString& Tag)
+{
+    FString Dimension;
+
+    return Tag.Split(TEXT(":"), &Dimension, nullptr) ? Dimension : Tag;
+}
+
+FManifestParser::FManifestParser(const TArray<uint8>& Content) : Archive(Content),
+                                                                 Reader(TJsonReaderFactory<UTF8CHAR>::Create(&Archive))
+{
+}
+
+EManifestParseResult FManifestParser::Parse(const double TimeLimit)
+{
+    const auto StartTime = FPlatformTime::Seconds();
+
+    EJsonNotation Notation;
+
+    while (Reader->ReadNext(Notation))
+    {
+        switch (Notation)
+        {
+        case EJsonNotation::ObjectStart:
+        case EJsonNotation::ArrayStart:
+            {
+                bIsBlockArray = Depth == 3 && bIsEntryArray && Notation == EJsonNotation::ArrayStart &&
+                    Reader->GetIdentifier() == TEXT("Blocks");
+
+                bIsTagArray = Depth == 3 && bIsEntryArray && Notation == EJsonNotation::ArrayStart &&
+                    Reader->GetIdentifier() == TEXT("Tags");
+
+                bIsWarmUpArray = Depth == 3 && bIsEntryArray && Notation == EJsonNotation::ArrayStart &&
+                    Reader->GetIdentifier() == TEXT("WarmUp");
+
+                Depth++;
+
+                if (Depth == 2)
+                {
+                    bIsEntryArray = Notation == EJsonNotation::ArrayStart;
+                }
+                else if (Depth == 3 && bIsEntryArray)
+                {
+                    Entry = FManifestEntry();
+                }
+            }
+            break;
+        case EJsonNotation::ObjectEnd:
+        case EJsonNotation::ArrayEnd:
+            {
+                const auto bIsEntryEnd = Depth == 3 && bIsEntryArray && Notation == EJsonNotation::ObjectEnd;
+
+                bIsBlockArray = false;
+
+                bIsTagArray = false;
+
+                bIsWarmUpArray = false;
+
+                Depth--;
+
+                if (Depth <= 0)
+                {
+                    return EManifestParseResult::Finished;
+                }
+
+                if (bIsEntryEnd)
+                {
+                    EntryNum++;
+
+                    OnEntry.ExecuteIfBound(Entry);
+
+                    if (TimeLimit > 0.0 && FPlatformTime::Seconds() - StartTime >= TimeLimit)
+                    {
+                        return EManifestParseResult::Pending;
+                    }
+                }
+            }
+            break;
+        case EJsonNotation::Error:
+            {
+                ErrorMessage = Reader->GetErrorMessage();
+
+                return EManifestParseResult::Error;
+            }
+        default:
+            {
+                OnValue(Notation);
+            }
+            break;
+        }
+    }
+
+    ErrorMessage = Reader->GetErrorMessage();
+
+    if (ErrorMessage.IsEmpty())
+    {
+        ErrorMessage = TEXT("Unexpected end of manifest");
+    }
+
+    return EManifestParseResult::Error;
+}
+
+void FManifestParser::OnValue(const EJsonNotation Notation)
+{
+    if (bIsBlockArray && Depth == 4 && Notation == EJsonNotation::String)
+    {
+        Entry.Blocks.Add(Reader->GetValueAsString());
+
+        return;
+    }
+
+    if (bIsTagArray && Depth == 4 && Notation == EJsonNotation::String)
+    {
+        Entry.Tags.Add(ManifestParser::DecodeUTF8(Reader->GetValueAsString()));
+
+        return;
+    }
+
+    if (bIsWarmUpArray && Depth == 4 && Notation == EJsonNotation::String)
+    {
+        Entry.WarmUp.Add(ManifestParser::DecodeUTF8(Reader->GetValueAsString()));
+
+        return;
+    }
+
+    if (Depth != 3 || !bIsEntryArray)
+    {
+        return;
+    }
+
+    const auto& Identifier = Reader->GetIdentifier();
+
+    if (Identifier == TEXT("File") && Notation == EJsonNotation::String)
+    {
+        Entry.File = ManifestParser::DecodeUTF8(Reader->GetValueAsString());
+    }
+    else if (Identifier == TEXT("HASH") && Notation == EJsonNotation::String)
+    {
+        Entry.Hash = Reader->GetValueAsString();
+    }
+    else if (Identifier == TEXT("Size") && Notation == EJsonNotation::Number)
+    {
+        Entry.Size = static_cast<int64>(Reader->GetValueAsNumber());
+    }
+    else if (Identifier == TEXT("Url") && Notation == EJsonNotation::String)
+    {
+        Entry.Url = ManifestParser::DecodeUTF8(Reader->GetValueAsString());
+    }
+    else if (Identifier == TEXT("IndexHash") && Notation == EJsonNotation::String)
+    {
+        Entry.IndexHash = Reader->GetValueAsString();
+    }
+    else if (Identifier == TEXT("BlockSize") && Notation == EJsonNotation::Number)
+    {
+        Entry.BlockSize = static_cast<int32>(Reader->GetValueAsNumber());
+    }
+    else if (Identifier == TEXT("OnDemand") && Notation == EJsonNotation::String)
+    {
+        Entry.OnDemand = ManifestParser::DecodeUTF8(Reader->GetValueAsString());
+    }
+}
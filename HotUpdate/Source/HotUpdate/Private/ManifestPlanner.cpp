@@ -0,0 +1,214 @@
+#include "ManifestPlanner.h"
+#include "FileDownLog.h"
+#include "FilePakManager.h"
+#include "PakVerifier.h"
+#include "FileDownloadManager.h"
+#include "RemotePakFile.h"
+#include "Async/Async.h"
+
+void FManifestPlanner::Reset()
+{
+    Entries.Empty();
+
+    PathIndices.Empty();
+
+    ValidEntries.Empty();
+
+    ValidContents.Empty();
+
+    RepairBlocks.Empty();
+
+    TakenEntries.Empty();
+
+    DuplicatedPathNum = 0;
+
+    bIsVerifying = false;
+
+    bIsVerified = false;
+
+    VerifyToken = MakeShared<int32, ESPMode::ThreadSafe>(0);
+}
+
+void FManifestPlanner::SetReport(const TSharedPtr<FHotUpdateReport>& InReport)
+{
+    Report = InReport;
+}
+
+void FManifestPlanner::AddEntry(const FManifestEntry& Entry)
+{
+    if (Entry.File.IsEmpty())
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Skip manifest entry without file name"));
+
+        return;
+    }
+
+    if (const auto Index = PathIndices.Find(Entry.File))
+    {
+        UE_LOG(LogHotUpdate, Log, TEXT("Manifest entry %s is overridden by a later version"), *Entry.File);
+
+        Entries[*Index] = Entry;
+
+        DuplicatedPathNum++;
+
+        return;
+    }
+
+    PathIndices.Add(Entry.File, Entries.Add(Entry));
+}
+
+void FManifestPlanner::TakeMissingEntries(const int32 MaxNum, TArray<int32>& OutIndices)
+{
+    TMap<FString, int32> ContentNums;
+
+    for (const auto& Entry : Entries)
+    {
+        if (!Entry.Hash.IsEmpty())
+        {
+            ContentNums.FindOrAdd(GetContentKey(Entry.Hash, Entry.Size))++;
+        }
+    }
+
+    for (auto i = 0; i < Entries.Num() && OutIndices.Num() < MaxNum; ++i)
+    {
+        const auto& Entry = Entries[i];
+
+        if (!Entry.Hash.IsEmpty() && ContentNums.FindRef(GetContentKey(Entry.Hash, Entry.Size)) > 1)
+        {
+            continue;
+        }
+
+        if (IFileManager::Get().FileExists(*FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), Entry.File)))
+        {
+            continue;
+        }
+
+        // Left to the schedule, which mounts it from the server or on first use
+        if (!Entry.OnDemand.IsEmpty() || FRemotePakPlatformFile::CanStream(Entry.ToPakFileProperty()))
+        {
+            continue;
+        }
+
+        TakenEntries.Add(i);
+
+        OutIndices.Add(i);
+    }
+}
+
+bool FManifestPlanner::Verify()
+{
+    if (bIsVerified)
+    {
+        return true;
+    }
+
+    if (bIsVerifying)
+    {
+        return false;
+    }
+
+    bIsVerifying = true;
+
+    TArray<FEntryVerify> EntryVerifies;
+
+    for (auto i = 0; i < Entries.Num(); ++i)
+    {
+        // Taken entries are being downloaded, their files are not worth checking
+        if (!TakenEntries.Contains(i))
+        {
+            EntryVerifies.Emplace(i, Entries[i].ToPakFileProperty(),
+                                  FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), Entries[i].File));
+        }
+    }
+
+    const TWeakPtr<int32, ESPMode::ThreadSafe> WeakToken = VerifyToken;
+
+    Async(EAsyncExecution::ThreadPool, [this, WeakToken, EntryVerifies = MoveTemp(EntryVerifies)]() mutable
+    {
+        for (auto& EntryVerify : EntryVerifies)
+        {
+            VerifyEntry(EntryVerify);
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [this, WeakToken, EntryVerifies = MoveTemp(EntryVerifies)]() mutable
+        {
+            if (WeakToken.IsValid())
+            {
+                OnEntriesVerified(MoveTemp(EntryVerifies));
+            }
+        });
+    });
+
+    return false;
+}
+
+void FManifestPlanner::VerifyEntry(FEntryVerify& EntryVerify)
+{
+    const auto StartTime = FPlatformTime::Seconds();
+
+    EntryVerify.bIsValid = FFilePakManager::IsPakValid(EntryVerify.PakInfo);
+
+    EntryVerify.VerifyTime = FPlatformTime::Seconds() - StartTime;
+
+    if (!EntryVerify.bIsValid && EntryVerify.PakInfo.BlockHashes.Num() > 0 &&
+        IFileManager::Get().FileSize(*EntryVerify.PakPath) == EntryVerify.PakInfo.PakSize)
+    {
+        EntryVerify.bIsScanned = FPakVerifier::FindBadBlocks(EntryVerify.PakInfo, EntryVerify.BadBlocks);
+    }
+}
+
+void FManifestPlanner::OnEntriesVerified(TArray<FEntryVerify>&& EntryVerifies)
+{
+    bIsVerifying = false;
+
+    bIsVerified = true;
+
+    ValidEntries.Init(false, Entries.Num());
+
+    for (auto& EntryVerify : EntryVerifies)
+    {
+        const auto& Entry = Entries[EntryVerify.Index];
+
+        if (Report.IsValid())
+        {
+            Report->AddVerifyTime(Entry.File, EntryVerify.VerifyTime);
+        }
+
+        ValidEntries[EntryVerify.Index] = EntryVerify.bIsValid;
+
+        if (EntryVerify.bIsValid && !Entry.Hash.IsEmpty())
+        {
+            ValidContents.Add(GetContentKey(Entry.Hash, Entry.Size), EntryVerify.Index);
+        }
+
+        // Repair only pays off while most of the installed file is intact
+        auto& BadBlocks = EntryVerify.BadBlocks;
+
+        if (EntryVerify.bIsScanned && BadBlocks.Num() > 0 && BadBlocks.Num() * 2 <= Entry.Blocks.Num())
+        {
+            UE_LOG(LogHotUpdate, Log, TEXT("%s has %d damaged blocks of %d"), *Entry.File, BadBlocks.Num(),
+                   Entry.Blocks.Num());
+
+            RepairBlocks.Add(EntryVerify.Index, MoveTemp(BadBlocks));
+        }
+    }
+
+    OnVerified.ExecuteIfBound();
+}
+
+int32 FManifestPlanner::FindValidSource(const int32 Index) const
+{
+    if (!Entries.IsValidIndex(Index) || Entries[Index].Hash.IsEmpty())
+    {
+        return INDEX_NONE;
+    }
+
+    const auto Source = ValidContents.Find(GetContentKey(Entries[Index].Hash, Entries[Index].Size));
+
+    return Source != nullptr && *Source != Index ? *Source : INDEX_NONE;
+}
+
+FString FManifestPlanner::GetContentKey(const FString& Hash, const int64 Size)
+{
+    return FString::Printf(TEXT("%s:%lld"), *Hash.ToLower(), Size);
+}
@@ -0,0 +1,235 @@
+#include "PakBlockCache.h"
+#include "FileDownLog.h"
+#include "FileDownloadManager.h"
+#include "HotUpdateSettings.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+FPakBlockCache& FPakBlockCache::Get()
+{
+    static FPakBlockCache Instance;
+
+    return Instance;
+}
+
+bool FPakBlockCache::Read(const FString& PakHash, const int32 Index, TArray<uint8>& OutData)
+{
+    const auto& Key = GetKey(PakHash, Index);
+
+    {
+        FScopeLock ScopeLock(&CriticalSection);
+
+        Load();
+
+        const auto Record = Blocks.Find(Key);
+
+        if (Record == nullptr)
+        {
+            return false;
+        }
+
+        MarkUsed(Key, *Record);
+
+        if (!Record->bIsTouched)
+        {
+            Record->bIsTouched = true;
+
+            IFileManager::Get().SetTimeStamp(*FPaths::Combine(GetCacheRoot(), Key), FDateTime::UtcNow());
+        }
+    }
+
+    if (FFileHelper::LoadFileToArray(OutData, *FPaths::Combine(GetCacheRoot(), Key), FILEREAD_Silent))
+    {
+        return true;
+    }
+
+    FScopeLock ScopeLock(&CriticalSection);
+
+    RemoveRecord(Key);
+
+    return false;
+}
+
+void FPakBlockCache::Write(const FString& PakHash, const int32 Index, const TArray<uint8>& Data)
+{
+    const auto& Key = GetKey(PakHash, Index);
+
+    const auto& Path = FPaths::Combine(GetCacheRoot(), Key);
+
+    // Readers of the same block only ever see a complete file
+    const auto& TempPath = Path + TEXT(".tmp");
+
+    if (!FFileHelper::SaveArrayToFile(Data, *TempPath) || !IFileManager::Get().Move(*Path, *TempPath, true))
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to write cached block: %s"), *Path);
+
+        return;
+    }
+
+    FScopeLock ScopeLock(&CriticalSection);
+
+    Load();
+
+    auto& Record = Blocks.FindOrAdd(Key);
+
+    TotalSize += Data.Num() - Record.Size;
+
+    Record.Size = Data.Num();
+
+    MarkUsed(Key, Record);
+
+    Record.bIsTouched = true;
+
+    Evict();
+}
+
+bool FPakBlockCache::Contains(const FString& PakHash, const int32 Index)
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    Load();
+
+    return Blocks.Contains(GetKey(PakHash, Index));
+}
+
+void FPakBlockCache::Remove(const FString& PakHash)
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    Load();
+
+    const auto& Prefix = PakHash.ToLower() + TEXT("/");
+
+    for (auto It = Blocks.CreateIterator(); It; ++It)
+    {
+        if (It.Key().StartsWith(Prefix))
+        {
+            TotalSize -= It.Value().Size;
+
+            RecentBlocks.RemoveNode(It.Value().Node);
+
+            It.RemoveCurrent();
+        }
+    }
+
+    IFileManager::Get().DeleteDirectory(*FPaths::Combine(GetCacheRoot(), PakHash.ToLower()), false, true);
+}
+
+int64 FPakBlockCache::GetCapacity()
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    Load();
+
+    return Capacity;
+}
+
+void FPakBlockCache::Load()
+{
+    if (bIsLoaded)
+    {
+        return;
+    }
+
+    bIsLoaded = true;
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    Capacity = static_cast<int64>(HotUpdateSettings != nullptr ? HotUpdateSettings->BlockCacheSize : 2048) * 1024 *
+        1024;
+
+    TArray<TPair<FDateTime, FString>> Files;
+
+    const auto& CacheRoot = GetCacheRoot();
+
+    IFileManager::Get().IterateDirectoryStatRecursively(*CacheRoot, [&Files, &CacheRoot](
+        const TCHAR* Path, const FFileStatData& StatData)
+        {
+            if (!StatData.bIsDirectory && FPaths::GetExtension(Path) == TEXT("block"))
+            {
+                auto Key = FString(Path);
+
+                FPaths::MakePathRelativeTo(Key, *(CacheRoot + TEXT("/")));
+
+                Files.Emplace(StatData.ModificationTime, Key);
+            }
+            else if (!StatData.bIsDirectory && FPaths::GetExtension(Path) == TEXT("tmp"))
+            {
+                IFileManager::Get().Delete(Path, false, true, true);
+            }
+
+            return true;
+        });
+
+    Files.Sort([](const TPair<FDateTime, FString>& A, const TPair<FDateTime, FString>& B)
+    {
+        return A.Key < B.Key;
+    });
+
+    for (const auto& File : Files)
+    {
+        auto& Record = Blocks.Add(File.Value);
+
+        Record.Size = IFileManager::Get().FileSize(*FPaths::Combine(CacheRoot, File.Value));
+
+        MarkUsed(File.Value, Record);
+
+        TotalSize += Record.Size;
+    }
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Block cache: %d blocks, %lld of %lld bytes"), Blocks.Num(), TotalSize, Capacity);
+
+    Evict();
+}
+
+void FPakBlockCache::MarkUsed(const FString& Key, FBlockRecord& Record)
+{
+    if (Record.Node == nullptr)
+    {
+        RecentBlocks.AddHead(Key);
+
+        Record.Node = RecentBlocks.GetHead();
+    }
+    else if (Record.Node != RecentBlocks.GetHead())
+    {
+        RecentBlocks.RemoveNode(Record.Node, false);
+
+        RecentBlocks.AddHead(Record.Node);
+    }
+}
+
+void FPakBlockCache::RemoveRecord(const FString& Key)
+{
+    if (const auto Record = Blocks.Find(Key))
+    {
+        TotalSize -= Record->Size;
+
+        RecentBlocks.RemoveNode(Record->Node);
+
+        Blocks.Remove(Key);
+    }
+}
+
+void FPakBlockCache::Evict()
+{
+    while (TotalSize > Capacity && RecentBlocks.GetTail() != nullptr)
+    {
+        const auto Key = RecentBlocks.GetTail()->GetValue();
+
+        IFileManager::Get().Delete(*FPaths::Combine(GetCacheRoot(), Key), false, true, true);
+
+        RemoveRecord(Key);
+    }
+}
+
+FString FPakBlockCache::GetKey(const FString& PakHash, const int32 Index)
+{
+    return FString::Printf(TEXT("%s/%d.block"), *PakHash.ToLower(), Index);
+}
+
+FString FPakBlockCache::GetCacheRoot()
+{
+    return FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), TEXT("BlockCache"));
+}
@@ -0,0 +1,465 @@
+#include "PakVerifier.h"
+#include "FileDownLog.h"
+#include "FileDownloadManager.h"
+#include "HotUpdateSettings.h"
+#include "HotUpdateTrace.h"
+#include "HotUpdateStats.h"
+#include "HotUpdateFileIO.h"
+#include "IPlatformFilePak.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Math/RandomStream.h"
+#include "Serialization/JsonSerializer.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+
+FPakVerifier& FPakVerifier::Get()
+{
+    static FPakVerifier Instance;
+
+    return Instance;
+}
+
+void FPakVerifier::BeginUpdate()
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    LoadRecords();
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    Tier = HotUpdateSettings != nullptr ? HotUpdateSettings->VerifyTier : EHotUpdateVerifyTier::Full;
+
+    const auto FullVerifyInterval = HotUpdateSettings != nullptr ? HotUpdateSettings->FullVerifyInterval : 0;
+
+    const auto& MarkerPath = GetMarkerPath();
+
+    if (IFileManager::Get().FileExists(*MarkerPath))
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Last update did not finish, verify paks in full"));
+
+        Tier = EHotUpdateVerifyTier::Full;
+    }
+    else if (FullVerifyInterval > 0 && FDateTime::UtcNow() - LastFullVerify > FTimespan::FromHours(FullVerifyInterval))
+    {
+        UE_LOG(LogHotUpdate, Log, TEXT("Last full verify at %s, verify paks in full"), *LastFullVerify.ToIso8601());
+
+        Tier = EHotUpdateVerifyTier::Full;
+    }
+
+    for (auto& Record : Records)
+    {
+        Record.Value.bIsSessionVerified = false;
+    }
+
+    if (!FFileHelper::SaveStringToFile(FDateTime::UtcNow().ToIso8601(), *MarkerPath))
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to write marker: %s"), *MarkerPath);
+    }
+
+    bIsUpdating = true;
+
+    UE_LOG(LogHotUpdate, Log, TEXT("Verify tier: %s"), GetTierName(Tier));
+}
+
+void FPakVerifier::EndUpdate(const bool bIsSuccessful)
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    if (!bIsUpdating)
+    {
+        return;
+    }
+
+    bIsUpdating = false;
+
+    if (bIsSuccessful && Tier == EHotUpdateVerifyTier::Full)
+    {
+        LastFullVerify = FDateTime::UtcNow();
+    }
+
+    SaveRecords();
+
+    IFileManager::Get().Delete(*GetMarkerPath(), false, true, true);
+}
+
+bool FPakVerifier::Verify(const FPakFileProperty& PakInfo)
+{
+    const auto& PakPath = FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), PakInfo.PakName);
+
+    const auto Size = IFileManager::Get().FileSize(*PakPath);
+
+    if (Size < 0 || Size != PakInfo.PakSize)
+    {
+        return false;
+    }
+
+    const auto TimeStamp = IFileManager::Get().GetTimeStamp(*PakPath).GetTicks();
+
+    const auto& Hash = PakInfo.MD5.ToLower();
+
+    auto CurrentTier = EHotUpdateVerifyTier::Full;
+
+    {
+        FScopeLock ScopeLock(&CriticalSection);
+
+        const auto Record = Records.Find(PakInfo.PakName);
+
+        if (Record != nullptr && Record->Size == Size && Record->TimeStamp == TimeStamp && Record->Hash == Hash)
+        {
+            if (Tier == EHotUpdateVerifyTier::Metadata || Record->bIsSessionVerified)
+            {
+                return true;
+            }
+
+            CurrentTier = Tier;
+        }
+    }
+
+    const auto bCanVerifySampled = PakInfo.BlockSize > 0 &&
+        PakInfo.BlockHashes.Num() == FMath::DivideAndRoundUp<int64>(Size, PakInfo.BlockSize);
+
+    if (CurrentTier == EHotUpdateVerifyTier::Index && PakInfo.IndexHash.IsEmpty())
+    {
+        CurrentTier = EHotUpdateVerifyTier::Sampled;
+    }
+
+    if (CurrentTier == EHotUpdateVerifyTier::Sampled && !bCanVerifySampled)
+    {
+        CurrentTier = EHotUpdateVerifyTier::Full;
+    }
+
+    auto bIsValid = false;
+
+    switch (CurrentTier)
+    {
+    case EHotUpdateVerifyTier::Index:
+        bIsValid = VerifyIndex(PakPath, PakInfo);
+        break;
+    case EHotUpdateVerifyTier::Sampled:
+        bIsValid = VerifySampled(PakPath, PakInfo);
+        break;
+    default:
+        bIsValid = VerifyFull(PakPath, PakInfo);
+        break;
+    }
+
+    UE_LOG(LogHotUpdate, Verbose, TEXT("Verify %s at %s tier: %s"), *PakInfo.PakName, GetTierName(CurrentTier),
+           bIsValid ? TEXT("valid") : TEXT("invalid"));
+
+    FScopeLock ScopeLock(&CriticalSection);
+
+    if (bIsValid)
+    {
+        auto& Record = Records.FindOrAdd(PakInfo.PakName);
+
+        Record.Size = Size;
+
+        Record.TimeStamp = TimeStamp;
+
+        Record.Hash = Hash;
+
+        Record.bIsSessionVerified = true;
+    }
+    else
+    {
+        Records.Remove(PakInfo.PakName);
+    }
+
+    return bIsValid;
+}
+
+bool FPakVerifier::VerifyFull(const FString& PakPath, const FPakFileProperty& PakInfo)
+{
+    HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.HashPak %s"), *PakInfo.PakName);
+
+    const auto StartTime = FPlatformTime::Seconds();
+
+    const auto& Hash = FHotUpdateFileIO::HashFile(PakPath);
+
+    const auto HashTime = FPlatformTime::Seconds() - StartTime;
+
+    if (HashTime > 0.0)
+    {
+        SET_FLOAT_STAT(STAT_HotUpdate_HashThroughput, PakInfo.PakSize / HashTime / (1024.0 * 1024.0));
+    }
+
+    if (!Hash.IsValid())
+    {
+        return false;
+    }
+
+    return BytesToHex(Hash.GetBytes(), Hash.GetSize()).Equals(PakInfo.MD5, ESearchCase::IgnoreCase);
+}
+
+bool FPakVerifier::VerifyIndex(const FString& PakPath, const FPakFileProperty& PakInfo)
+{
+    HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.HashPakIndex %s"), *PakInfo.PakName);
+
+    const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*PakPath));
+
+    int64 IndexOffset = 0;
+
+    if (!Reader.IsValid() || !ReadIndexOffset(*Reader, IndexOffset))
+    {
+        return false;
+    }
+
+    return HashRange(*Reader, IndexOffset, Reader->TotalSize() - IndexOffset).Equals(
+        PakInfo.IndexHash, ESearchCase::IgnoreCase);
+}
+
+bool FPakVerifier::VerifySampled(const FString& PakPath, const FPakFileProperty& PakInfo)
+{
+    HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.HashPakBlocks %s"), *PakInfo.PakName);
+
+    const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*PakPath));
+
+    if (!Reader.IsValid())
+    {
+        return false;
+    }
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    const auto SampledBlockCount = FMath::Max(HotUpdateSettings != nullptr ? HotUpdateSettings->SampledBlockCount : 8, 1);
+
+    const auto BlockNum = PakInfo.BlockHashes.Num();
+
+    const auto TotalSize = Reader->TotalSize();
+
+    FRandomStream RandomStream(static_cast<int32>(FPlatformTime::Cycles()));
+
+    // The last block is always checked, it holds the index and footer and catches truncation
+    for (auto i = 0; i < FMath::Min(SampledBlockCount, BlockNum); ++i)
+    {
+        const auto Block = i == 0 ? BlockNum - 1 : RandomStream.RandHelper(BlockNum);
+
+        const auto Offset = static_cast<int64>(Block) * PakInfo.BlockSize;
+
+        const auto& Hash = HashRange(*Reader, Offset, FMath::Min<int64>(PakInfo.BlockSize, TotalSize - Offset));
+
+        if (!Hash.Equals(PakInfo.BlockHashes[Block], ESearchCase::IgnoreCase))
+        {
+            UE_LOG(LogHotUpdate, Warning, TEXT("Block %d of %s doesn't match"), Block, *PakInfo.PakName);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool FPakVerifier::FindBadBlocks(const FPakFileProperty& PakInfo, TArray<int32>& OutBlocks)
+{
+    OutBlocks.Reset();
+
+    const auto& PakPath = FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), PakInfo.PakName);
+
+    if (PakInfo.BlockSize <= 0 || IFileManager::Get().FileSize(*PakPath) != PakInfo.PakSize ||
+        PakInfo.BlockHashes.Num() != FMath::DivideAndRoundUp<int64>(PakInfo.PakSize, PakInfo.BlockSize))
+    {
+        return false;
+    }
+
+    HOTUPDATE_TRACE_SCOPE_FORMAT(TEXT("HotUpdate.FindBadBlocks %s"), *PakInfo.PakName);
+
+    const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*PakPath));
+
+    if (!Reader.IsValid())
+    {
+        return false;
+    }
+
+    for (auto Block = 0; Block < PakInfo.BlockHashes.Num(); ++Block)
+    {
+        const auto Offset = static_cast<int64>(Block) * PakInfo.BlockSize;
+
+        const auto& Hash = HashRange(*Reader, Offset, FMath::Min<int64>(PakInfo.BlockSize, PakInfo.PakSize - Offset));
+
+        if (!Hash.Equals(PakInfo.BlockHashes[Block], ESearchCase::IgnoreCase))
+        {
+            OutBlocks.Add(Block);
+        }
+    }
+
+    return true;
+}
+
+bool FPakVerifier::ReadIndexOffset(FArchive& Reader, int64& IndexOffset)
+{
+    const auto TotalSize = Reader.TotalSize();
+
+    for (int32 Version = FPakInfo::PakFile_Version_Latest; Version > FPakInfo::PakFile_Version_Initial; --Version)
+    {
+        FPakInfo Info;
+
+        const auto InfoSize = Info.GetSerializedSize(Version);
+
+        if (TotalSize < InfoSize)
+        {
+            continue;
+        }
+
+        Reader.Seek(TotalSize - InfoSize);
+
+        Info.Serialize(Reader, Version);
+
+        if (!Reader.IsError() && Info.Magic == FPakInfo::PakFile_Magic && Info.IndexOffset >= 0 &&
+            Info.IndexOffset < TotalSize)
+        {
+            IndexOffset = Info.IndexOffset;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+FString FPakVerifier::HashRange(FArchive& Reader, const int64 Offset, const int64 Size)
+{
+    static const int64 BufferSize = 64 * 1024;
+
+    TArray<uint8> Buffer;
+
+    Buffer.SetNumUninitialized(FMath::Clamp<int64>(Size, 1, BufferSize));
+
+    FMD5 Md5;
+
+    Reader.Seek(Offset);
+
+    auto RemainingSize = Size;
+
+    while (RemainingSize > 0)
+    {
+        const auto ReadSize = FMath::Min<int64>(RemainingSize, Buffer.Num());
+
+        Reader.Serialize(Buffer.GetData(), ReadSize);
+
+        if (Reader.IsError())
+        {
+            return FString();
+        }
+
+        Md5.Update(Buffer.GetData(), ReadSize);
+
+        RemainingSize -= ReadSize;
+    }
+
+    uint8 Digest[16];
+
+    Md5.Final(Digest);
+
+    return BytesToHex(Digest, sizeof(Digest));
+}
+
+const TCHAR* FPakVerifier::GetTierName(const EHotUpdateVerifyTier InTier)
+{
+    switch (InTier)
+    {
+    case EHotUpdateVerifyTier::Metadata: return TEXT("Metadata");
+    case EHotUpdateVerifyTier::Index: return TEXT("Index");
+    case EHotUpdateVerifyTier::Sampled: return TEXT("Sampled");
+    default: return TEXT("Full");
+    }
+}
+
+void FPakVerifier::LoadRecords()
+{
+    Records.Empty();
+
+    LastFullVerify = FDateTime::MinValue();
+
+    FString JsonStr;
+
+    if (!FFileHelper::LoadFileToString(JsonStr, *GetRecordPath()))
+    {
+        return;
+    }
+
+    TSharedPtr<FJsonObject> JsonObject;
+
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonStr), JsonObject) || !JsonObject.IsValid())
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to read verify records: %s"), *GetRecordPath());
+
+        return;
+    }
+
+    FDateTime::ParseIso8601(*JsonObject->GetStringField(TEXT("LastFullVerify")), LastFullVerify);
+
+    const TSharedPtr<FJsonObject>* Paks = nullptr;
+
+    if (!JsonObject->TryGetObjectField(TEXT("Paks"), Paks))
+    {
+        return;
+    }
+
+    for (const auto& Pak : (*Paks)->Values)
+    {
+        const auto& PakObject = Pak.Value->AsObject();
+
+        if (!PakObject.IsValid())
+        {
+            continue;
+        }
+
+        FPakVerifyRecord Record;
+
+        Record.Size = FCString::Atoi64(*PakObject->GetStringField(TEXT("Size")));
+
+        Record.TimeStamp = FCString::Atoi64(*PakObject->GetStringField(TEXT("TimeStamp")));
+
+        Record.Hash = PakObject->GetStringField(TEXT("Hash"));
+
+        Records.Add(Pak.Key, MoveTemp(Record));
+    }
+}
+
+void FPakVerifier::SaveRecords() const
+{
+    FString JsonStr;
+
+    auto JsonWriter = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&JsonStr);
+
+    JsonWriter->WriteObjectStart();
+
+    JsonWriter->WriteValue(TEXT("LastFullVerify"), LastFullVerify.ToIso8601());
+
+    JsonWriter->WriteObjectStart(TEXT("Paks"));
+
+    for (const auto& Record : Records)
+    {
+        JsonWriter->WriteObjectStart(Record.Key);
+
+        JsonWriter->WriteValue(TEXT("Size"), FString::Printf(TEXT("%lld"), Record.Value.Size));
+
+        JsonWriter->WriteValue(TEXT("TimeStamp"), FString::Printf(TEXT("%lld"), Record.Value.TimeStamp));
+
+        JsonWriter->WriteValue(TEXT("Hash"), Record.Value.Hash);
+
+        JsonWriter->WriteObjectEnd();
+    }
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->Close();
+
+    if (!FFileHelper::SaveStringToFile(JsonStr, *GetRecordPath(), FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to write verify records: %s"), *GetRecordPath());
+    }
+}
+
+FString FPakVerifier::GetRecordPath()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HotUpdate"), TEXT("VerifyRecords.json"));
+}
+
+FString FPakVerifier::GetMarkerPath()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HotUpdate"), TEXT("Updating.marker"));
+}
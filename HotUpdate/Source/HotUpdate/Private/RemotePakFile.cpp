@@ -0,0 +1,695 @@
+#include "RemotePakFile.h"
+#include "FileDownLog.h"
+#include "FileDownloadManager.h"
+#include "DownLoadTask.h"
+#include "HotUpdateSettings.h"
+#include "PakBlockCache.h"
+#include "HotUpdateFileIO.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+#include "Async/Async.h"
+
+struct FRemotePak::FBlockFetch
+{
+    explicit FBlockFetch(const int32 InIndex) : Index(InIndex), Event(FPlatformProcess::GetSynchEventFromPool(true))
+    {
+    }
+
+    ~FBlockFetch()
+    {
+        FPlatformProcess::ReturnSynchEventToPool(Event);
+    }
+
+    int32 Index;
+
+    /** Triggered once the block is cached or every retry failed, all readers of the block wait on it */
+    FEvent* Event;
+
+    TArray<uint8> Data;
+
+    bool bIsSucceeded = false;
+
+    uint32 RetryCount = 0;
+};
+
+/** Reads a remote pak block by block, switches to the installed file once the pak is installed */
+class FRemotePakHandle final : public IFileHandle
+{
+public:
+    FRemotePakHandle(const TSharedRef<FRemotePak, ESPMode::ThreadSafe>& InRemotePak, IPlatformFile* InLowerLevel) :
+        RemotePak(InRemotePak), LowerLevel(InLowerLevel)
+    {
+    }
+
+    virtual int64 Tell() override
+    {
+        return Position;
+    }
+
+    virtual bool Seek(const int64 NewPosition) override
+    {
+        if (NewPosition < 0 || NewPosition > RemotePak->GetSize())
+        {
+            return false;
+        }
+
+        Position = NewPosition;
+
+        return true;
+    }
+
+    virtual bool SeekFromEnd(const int64 NewPositionRelativeToEnd) override
+    {
+        return Seek(RemotePak->GetSize() + NewPositionRelativeToEnd);
+    }
+
+    virtual bool Read(uint8* Destination, int64 BytesToRead) override;
+
+    virtual bool Write(const uint8* Source, int64 BytesToWrite) override
+    {
+        return false;
+    }
+
+    virtual bool Flush(const bool bFullFlush = false) override
+    {
+        return false;
+    }
+
+    virtual bool Truncate(int64 NewSize) override
+    {
+        return false;
+    }
+
+    virtual int64 Size() override
+    {
+        return RemotePak->GetSize();
+    }
+
+private:
+    TSharedRef<FRemotePak, ESPMode::ThreadSafe> RemotePak;
+
+    IPlatformFile* LowerLevel;
+
+    TUniquePtr<IFileHandle> InstalledHandle;
+
+    int64 Position = 0;
+
+    int32 BlockIndex = INDEX_NONE;
+
+    TArray<uint8> Block;
+};
+
+bool FRemotePakHandle::Read(uint8* Destination, int64 BytesToRead)
+{
+    if (BytesToRead < 0 || Position + BytesToRead > RemotePak->GetSize())
+    {
+        return false;
+    }
+
+    // Handles opened before the install keep working, the cached blocks are dropped by then
+    if (RemotePak->IsInstalled())
+    {
+        if (!InstalledHandle.IsValid())
+        {
+            InstalledHandle.Reset(LowerLevel->OpenRead(*RemotePak->GetPath()));
+        }
+
+        if (!InstalledHandle.IsValid() || !InstalledHandle->Seek(Position) ||
+            !InstalledHandle->Read(Destination, BytesToRead))
+        {
+            return false;
+        }
+
+        Position += BytesToRead;
+
+        return true;
+    }
+
+    while (BytesToRead > 0)
+    {
+        const auto Index = static_cast<int32>(Position / RemotePak->GetBlockSize());
+
+        if (Index != BlockIndex)
+        {
+            BlockIndex = INDEX_NONE;
+
+            if (!RemotePak->ReadBlock(Index, Block))
+            {
+                return RemotePak->IsInstalled() && Read(Destination, BytesToRead);
+            }
+
+            BlockIndex = Index;
+        }
+
+        const auto Offset = Position - static_cast<int64>(Index) * RemotePak->GetBlockSize();
+
+        const auto CopySize = FMath::Min<int64>(BytesToRead, Block.Num() - Offset);
+
+        if (CopySize <= 0)
+        {
+            return false;
+        }
+
+        FMemory::Memcpy(Destination, Block.GetData() + Offset, CopySize);
+
+        Destination += CopySize;
+
+        BytesToRead -= CopySize;
+
+        Position += CopySize;
+    }
+
+    return true;
+}
+
+FRemotePak::FRemotePak(const FString& InURL, const FPakFileProperty& InPakInfo) : PakInfo(InPakInfo)
+{
+    URL = FDownloadTask::EncodeURL(InURL);
+
+    Path = FPaths::Combine(FFileDownloadManager::GetPakSaveRoot(), PakInfo.PakName);
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings != nullptr)
+    {
+        MaxRetryTime = HotUpdateSettings->MaxRetryTime;
+
+        TimeOutDelay = HotUpdateSettings->TimeOutDelay;
+    }
+}
+
+bool FRemotePak::ReadBlock(const int32 Index, TArray<uint8>& OutData)
+{
+    if (!PakInfo.BlockHashes.IsValidIndex(Index))
+    {
+        return false;
+    }
+
+    if (FPakBlockCache::Get().Read(PakInfo.MD5, Index, OutData))
+    {
+        return true;
+    }
+
+    const auto Fetch = BeginFetch(Index);
+
+    // Each try may run into the timeout before the fetch gives up
+    const auto WaitTime = static_cast<uint32>(TimeOutDelay * 1000.f) * (MaxRetryTime + 1);
+
+    if (!Fetch->Event->Wait(WaitTime) || !Fetch->bIsSucceeded)
+    {
+        UE_LOG(LogHotUpdate, Error, TEXT("Failed to read block %d of remote pak %s"), Index, *PakInfo.PakName);
+
+        return false;
+    }
+
+    OutData = Fetch->Data;
+
+    return true;
+}
+
+bool FRemotePak::PrefetchBlock()
+{
+    if (bIsRefetchNeeded)
+    {
+        bIsRefetchNeeded = false;
+
+        PrefetchIndex = 0;
+    }
+
+    while (PrefetchIndex < PakInfo.BlockHashes.Num())
+    {
+        const auto Index = PrefetchIndex++;
+
+        if (FPakBlockCache::Get().Contains(PakInfo.MD5, Index))
+        {
+            continue;
+        }
+
+        {
+            FScopeLock ScopeLock(&CriticalSection);
+
+            if (Fetches.Contains(Index))
+            {
+                continue;
+            }
+        }
+
+        BeginFetch(Index);
+
+        return true;
+    }
+
+    return false;
+}
+
+void FRemotePak::InstallAsync(IPlatformFile* PlatformFile)
+{
+    if (!CanPrefetch() || PlatformFile == nullptr)
+    {
+        return;
+    }
+
+    bIsInstalling = true;
+
+    InstallCount++;
+
+    const auto RemotePak = AsShared();
+
+    Async(EAsyncExecution::ThreadPool, [RemotePak, PlatformFile]()
+    {
+        RemotePak->Install(*PlatformFile);
+
+        RemotePak->bIsInstalling = false;
+    });
+}
+
+int32 FRemotePak::GetFetchNum()
+{
+    FScopeLock ScopeLock(&CriticalSection);
+
+    return Fetches.Num();
+}
+
+TSharedRef<FRemotePak::FBlockFetch, ESPMode::ThreadSafe> FRemotePak::BeginFetch(const int32 Index)
+{
+    TSharedPtr<FBlockFetch, ESPMode::ThreadSafe> Fetch;
+
+    {
+        FScopeLock ScopeLock(&CriticalSection);
+
+        if (const auto InFlightFetch = Fetches.Find(Index))
+        {
+            return *InFlightFetch;
+        }
+
+        Fetch = MakeShared<FBlockFetch, ESPMode::ThreadSafe>(Index);
+
+        Fetches.Add(Index, Fetch.ToSharedRef());
+    }
+
+    SendFetch(Fetch.ToSharedRef());
+
+    return Fetch.ToSharedRef();
+}
+
+void FRemotePak::SendFetch(const TSharedRef<FBlockFetch, ESPMode::ThreadSafe>& Fetch)
+{
+    const auto Request = FHttpModule::Get().CreateRequest();
+
+    Request->SetVerb("GET");
+
+    Request->SetURL(URL);
+
+    Request->AppendToHeader(FString("Range"), FString::Printf(TEXT("bytes=%lld-%lld"), GetBlockOffset(Fetch->Index),
+                                                             GetBlockOffset(Fetch->Index + 1) - 1));
+
+#if HOTUPDATE_WITH_REMOTE_PAK
+    Request->SetTimeout(TimeOutDelay);
+
+    // The reader may be the game thread waiting for this very block
+    Request->SetDelegateThreadPolicy(EHttpRequestDelegateThreadPolicy::CompleteOnHttpThread);
+#endif
+
+    const TWeakPtr<FRemotePak, ESPMode::ThreadSafe> WeakThis = AsShared();
+
+    Request->OnProcessRequestComplete().BindLambda(
+        [WeakThis, Fetch](FHttpRequestPtr, const FHttpResponsePtr Response, const bool bConnectedSuccessfully)
+        {
+            const auto bIsSucceeded = bConnectedSuccessfully && Response.IsValid() && Response->GetResponseCode() >=
+                200 && Response->GetResponseCode() < 400;
+
+            if (const auto RemotePak = WeakThis.Pin())
+            {
+                RemotePak->OnFetched(Fetch, bIsSucceeded ? &Response->GetContent() : nullptr);
+            }
+            else
+            {
+                Fetch->Event->Trigger();
+            }
+        });
+
+    Request->ProcessRequest();
+}
+
+void FRemotePak::OnFetched(const TSharedRef<FBlockFetch, ESPMode::ThreadSafe>& Fetch, const TArray<uint8>* Content)
+{
+    const auto Index = Fetch->Index;
+
+    auto bIsValid = Content != nullptr && Content->Num() == GetBlockOffset(Index + 1) - GetBlockOffset(Index);
+
+    if (bIsValid)
+    {
+        FMD5 Md5;
+
+        Md5.Update(Content->GetData(), Content->Num());
+
+        uint8 Digest[16];
+
+        Md5.Final(Digest);
+
+        bIsValid = BytesToHex(Digest, sizeof(Digest)).Equals(PakInfo.BlockHashes[Index], ESearchCase::IgnoreCase);
+    }
+
+    if (!bIsValid && Fetch->RetryCount < MaxRetryTime)
+    {
+        Fetch->RetryCount++;
+
+        UE_LOG(LogHotUpdate, Warning, TEXT("Retry block %d of remote pak %s"), Index, *PakInfo.PakName);
+
+        SendFetch(Fetch);
+
+        return;
+    }
+
+    if (bIsValid)
+    {
+        FPakBlockCache::Get().Write(PakInfo.MD5, Index, *Content);
+
+        Fetch->Data = *Content;
+
+        Fetch->bIsSucceeded = true;
+    }
+    else
+    {
+        UE_LOG(LogHotUpdate, Error, TEXT("Failed to fetch block %d of remote pak %s"), Index, *PakInfo.PakName);
+    }
+
+    {
+        FScopeLock ScopeLock(&CriticalSection);
+
+        Fetches.Remove(Index);
+    }
+
+    Fetch->Event->Trigger();
+}
+
+bool FRemotePak::Install(IPlatformFile& PlatformFile)
+{
+    const auto& TempPath = Path + TEXT(".tmp");
+
+    PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+
+    auto bIsWritten = false;
+
+    if (const auto Handle = TUniquePtr<IFileHandle>(PlatformFile.OpenWrite(*TempPath)))
+    {
+        TArray<uint8> Data;
+
+        bIsWritten = true;
+
+        for (auto i = 0; bIsWritten && i < PakInfo.BlockHashes.Num(); ++i)
+        {
+            bIsWritten = FPakBlockCache::Get().Read(PakInfo.MD5, i, Data) && Handle->Write(Data.GetData(), Data.Num());
+        }
+    }
+
+    const auto Hash = bIsWritten ? FHotUpdateFileIO::HashFile(TempPath) : FMD5Hash();
+
+    const auto bIsValid = Hash.IsValid() && BytesToHex(Hash.GetBytes(), Hash.GetSize()).Equals(
+        PakInfo.MD5, ESearchCase::IgnoreCase);
+
+    // The file of an older version at the same path is hidden by the remote pak until now
+    PlatformFile.DeleteFile(*Path);
+
+    if (!bIsValid || !PlatformFile.MoveFile(*Path, *TempPath))
+    {
+        UE_LOG(LogHotUpdate, Warning, TEXT("Failed to install remote pak %s"), *PakInfo.PakName);
+
+        PlatformFile.DeleteFile(*TempPath);
+
+        // Blocks evicted meanwhile are fetched again before the next try, PrefetchBlock owns the index
+        bIsRefetchNeeded = true;
+
+        return false;
+    }
+
+    bIsInstalled = true;
+
+    FPakBlockCache::Get().Remove(PakInfo.MD5);
+
+    UE_LOG(LogHotUpdate, Display, TEXT("Success to install remote pak: %s"), *Path);
+
+    return true;
+}
+
+int64 FRemotePak::GetBlockOffset(const int32 Index) const
+{
+    return FMath::Min<int64>(static_cast<int64>(Index) * PakInfo.BlockSize, PakInfo.PakSize);
+}
+
+FRemotePakPlatformFile::~FRemotePakPlatformFile()
+{
+    if (TickHandle.IsValid())
+    {
+        FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+        TickHandle.Reset();
+    }
+}
+
+bool FRemotePakPlatformFile::CanStream(const FPakFileProperty& PakInfo)
+{
+#if HOTUPDATE_WITH_REMOTE_PAK
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings == nullptr || HotUpdateSettings->RemotePakThreshold <= 0)
+    {
+        return false;
+    }
+
+    return FPaths::GetExtension(PakInfo.PakName) == TEXT("pak") && !PakInfo.MD5.IsEmpty() && PakInfo.BlockSize > 0 &&
+        PakInfo.PakSize >= static_cast<int64>(HotUpdateSettings->RemotePakThreshold) * 1024 * 1024 &&
+        PakInfo.BlockHashes.Num() == FMath::DivideAndRoundUp(PakInfo.PakSize, PakInfo.BlockSize);
+#else
+    return false;
+#endif
+}
+
+void FRemotePakPlatformFile::AddRemotePak(const FString& URL, const FPakFileProperty& PakInfo)
+{
+    const auto RemotePak = MakeShared<FRemotePak, ESPMode::ThreadSafe>(URL, PakInfo);
+
+    const auto& Path = FPaths::ConvertRelativePathToFull(RemotePak->GetPath());
+
+    // Started again after a tag change, the pak is still being fetched from the last run
+    if (const auto StreamedPak = RemotePaks.Find(Path))
+    {
+        if (!(*StreamedPak)->IsInstalled() && (*StreamedPak)->GetHash().Equals(PakInfo.MD5, ESearchCase::IgnoreCase))
+        {
+            return;
+        }
+    }
+
+    RemotePaks.Add(Path, RemotePak);
+}
+
+bool FRemotePakPlatformFile::Initialize(IPlatformFile* Inner, const TCHAR* CmdLine)
+{
+    LowerLevel = Inner;
+
+    const auto HotUpdateSettings = GetMutableDefault<UHotUpdateSettings>();
+
+    if (HotUpdateSettings != nullptr)
+    {
+        PrefetchConcurrency = HotUpdateSettings->RemotePakPrefetchConcurrency;
+    }
+
+    if (!TickHandle.IsValid())
+    {
+        TickHandle = FTicker::GetCoreTicker().AddTicker(
+            FTickerDelegate::CreateRaw(this, &FRemotePakPlatformFile::Tick));
+    }
+
+    return LowerLevel != nullptr;
+}
+
+TSharedPtr<FRemotePak, ESPMode::ThreadSafe> FRemotePakPlatformFile::FindRemotePak(const TCHAR* Filename) const
+{
+    if (RemotePaks.Num() <= 0 || FCString::Stristr(Filename, TEXT(".pak")) == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto RemotePak = RemotePaks.Find(FPaths::ConvertRelativePathToFull(Filename));
+
+    return RemotePak != nullptr && !(*RemotePak)->IsInstalled() ? *RemotePak : nullptr;
+}
+
+bool FRemotePakPlatformFile::Tick(float DeltaTime)
+{
+    if (bIsPrefetchPaused || PrefetchConcurrency <= 0)
+    {
+        return true;
+    }
+
+    const auto Capacity = FPakBlockCache::Get().GetCapacity();
+
+    auto FetchNum = 0;
+
+    auto bIsAllInstalled = true;
+
+    for (const auto& RemotePak : RemotePaks)
+    {
+        const auto& Pak = RemotePak.Value;
+
+        bIsAllInstalled &= Pak->IsInstalled();
+
+        // A pak larger than the cache would evict its own blocks before it is complete, it is only read on demand
+        if (!Pak->CanPrefetch() || Pak->GetSize() > Capacity)
+        {
+            continue;
+        }
+
+        FetchNum += Pak->GetFetchNum();
+
+        while (FetchNum < PrefetchConcurrency && Pak->PrefetchBlock())
+        {
+            FetchNum++;
+        }
+
+        if (FetchNum < PrefetchConcurrency && Pak->GetFetchNum() <= 0)
+        {
+            Pak->InstallAsync(LowerLevel);
+        }
+    }
+
+    if (bIsAllInstalled && RemotePaks.Num() > 0)
+    {
+        UE_LOG(LogHotUpdate, Log, TEXT("All %d remote paks are installed"), RemotePaks.Num());
+
+        TickHandle.Reset();
+
+        // The layer may be gone after this, nothing of it is touched any more
+        OnInstalled.ExecuteIfBound();
+
+        return false;
+    }
+
+    return true;
+}
+
+bool FRemotePakPlatformFile::FileExists(const TCHAR* Filename)
+{
+    return FindRemotePak(Filename).IsValid() || LowerLevel->FileExists(Filename);
+}
+
+int64 FRemotePakPlatformFile::FileSize(const TCHAR* Filename)
+{
+    if (const auto RemotePak = FindRemotePak(Filename))
+    {
+        return RemotePak->GetSize();
+    }
+
+    return LowerLevel->FileSize(Filename);
+}
+
+bool FRemotePakPlatformFile::DeleteFile(const TCHAR* Filename)
+{
+    return LowerLevel->DeleteFile(Filename);
+}
+
+bool FRemotePakPlatformFile::IsReadOnly(const TCHAR* Filename)
+{
+    return FindRemotePak(Filename).IsValid() || LowerLevel->IsReadOnly(Filename);
+}
+
+bool FRemotePakPlatformFile::MoveFile(const TCHAR* To, const TCHAR* From)
+{
+    return LowerLevel->MoveFile(To, From);
+}
+
+bool FRemotePakPlatformFile::SetReadOnly(const TCHAR* Filename, const bool bNewReadOnlyValue)
+{
+    return LowerLevel->SetReadOnly(Filename, bNewReadOnlyValue);
+}
+
+FDateTime FRemotePakPlatformFile::GetTimeStamp(const TCHAR* Filename)
+{
+    return FindRemotePak(Filename).IsValid() ? FDateTime::MinValue() : LowerLevel->GetTimeStamp(Filename);
+}
+
+void FRemotePakPlatformFile::SetTimeStamp(const TCHAR* Filename, const FDateTime DateTime)
+{
+    LowerLevel->SetTimeStamp(Filename, DateTime);
+}
+
+FDateTime FRemotePakPlatformFile::GetAccessTimeStamp(const TCHAR* Filename)
+{
+    return FindRemotePak(Filename).IsValid() ? FDateTime::MinValue() : LowerLevel->GetAccessTimeStamp(Filename);
+}
+
+FString FRemotePakPlatformFile::GetFilenameOnDisk(const TCHAR* Filename)
+{
+    return LowerLevel->GetFilenameOnDisk(Filename);
+}
+
+IFileHandle* FRemotePakPlatformFile::OpenRead(const TCHAR* Filename, const bool bAllowWrite)
+{
+    if (const auto RemotePak = FindRemotePak(Filename))
+    {
+        return new FRemotePakHandle(RemotePak.ToSharedRef(), LowerLevel);
+    }
+
+    return LowerLevel->OpenRead(Filename, bAllowWrite);
+}
+
+IFileHandle* FRemotePakPlatformFile::OpenWrite(const TCHAR* Filename, const bool bAppend, const bool bAllowRead)
+{
+    return LowerLevel->OpenWrite(Filename, bAppend, bAllowRead);
+}
+
+IAsyncReadFileHandle* FRemotePakPlatformFile::OpenAsyncRead(const TCHAR* Filename)
+{
+    // The generic handle reads through OpenRead on a worker
+    if (FindRemotePak(Filename).IsValid())
+    {
+        return IPlatformFile::OpenAsyncRead(Filename);
+    }
+
+    return LowerLevel->OpenAsyncRead(Filename);
+}
+
+IMappedFileHandle* FRemotePakPlatformFile::OpenMapped(const TCHAR* Filename)
+{
+    return FindRemotePak(Filename).IsValid() ? nullptr : LowerLevel->OpenMapped(Filename);
+}
+
+bool FRemotePakPlatformFile::DirectoryExists(const TCHAR* Directory)
+{
+    return LowerLevel->DirectoryExists(Directory);
+}
+
+bool FRemotePakPlatformFile::CreateDirectory(const TCHAR* Directory)
+{
+    return LowerLevel->CreateDirectory(Directory);
+}
+
+bool FRemotePakPlatformFile::DeleteDirectory(const TCHAR* Directory)
+{
+    return LowerLevel->DeleteDirectory(Directory);
+}
+
+FFileStatData FRemotePakPlatformFile::GetStatData(const TCHAR* FilenameOrDirectory)
+{
+    if (const auto RemotePak = FindRemotePak(FilenameOrDirectory))
+    {
+        return FFileStatData(FDateTime::MinValue(), FDateTime::MinValue(), FDateTime::MinValue(), RemotePak->GetSize(),
+                             false, true);
+    }
+
+    return LowerLevel->GetStatData(FilenameOrDirectory);
+}
+
+bool FRemotePakPlatformFile::IterateDirectory(const TCHAR* Directory, FDirectoryVisitor& Visitor)
+{
+    return LowerLevel->IterateDirectory(Directory, Visitor);
+}
+
+bool FRemotePakPlatformFile::IterateDirectoryStat(const TCHAR* Directory, FDirectoryStatVisitor& Visitor)
+{
+    return LowerLevel->IterateDirectoryStat(Directory, Visitor);
+}
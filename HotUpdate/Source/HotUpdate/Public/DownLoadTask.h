@@ -3,6 +3,7 @@
 #include "Interfaces/IHttpRequest.h"
 #include "TaskInfo.h"
 #include "FileDownType.h"
+#include "HotUpdateFileIO.h"
 
 enum class EDownloadTaskState : uint8
 {
@@ -13,6 +14,15 @@ enum class EDownloadTaskState : uint8
 
 DECLARE_DELEGATE_TwoParams(FOnTaskEvent, const EDownloadTaskEvent, const FTaskInfo&);
 
+DECLARE_DELEGATE_RetVal_OneParam(bool, FOnCanRequestChunk, const FTaskInfo&);
+
+struct FDownloadRange
+{
+    int64 Offset;
+
+    int64 Size;
+};
+
 class FDownloadTask final
 {
 public:
@@ -23,6 +33,16 @@ public:
 
     void Stop();
 
+    /** Patches a copy of the installed SourceFile, only the damaged blocks are requested */
+    void SetRepair(const FString& SourceFile, const FPakFileProperty& PakInfo, const TArray<int32>& Blocks);
+
+    bool IsRepair() const
+    {
+        return RepairBlocks.Num() > 0;
+    }
+
+    int64 GetRepairSize() const;
+
     bool IsPending() const
     {
         return State == EDownloadTaskState::Pending;
@@ -33,29 +53,113 @@ public:
         return State == EDownloadTaskState::Finished;
     }
 
+    bool IsWaitingChunk() const
+    {
+        return bIsWaitingChunk;
+    }
+
+    void ResumeChunk();
+
+    int32 GetBytesInFlight() const;
+
+    /** Seconds the range in flight has been waiting for its response, 0 when no range is in flight */
+    double GetRangeElapsed() const;
+
+    int32 GetRangeSize() const
+    {
+        return RangeSize;
+    }
+
+    bool IsHedged() const
+    {
+        return HedgeRequest.IsValid();
+    }
+
+    /** Requests the range in flight again on a new connection, the first response wins and the other is cancelled */
+    bool Hedge();
+
     FString GetFilePath() const;
 
     FGuid GetGuid() const;
 
     FTaskInfo GetTaskInfo() const;
 
+    int32 GetChunkSize() const
+    {
+        return ChunkSize;
+    }
+
+    /** Largest range size, ranges shrink under memory pressure and grow back up to it */
+    void SetChunkSize(const int32 InChunkSize)
+    {
+        PreferredChunkSize = FMath::Clamp(InChunkSize, MinChunkSize, DefaultChunkSize);
+
+        ChunkSize = PreferredChunkSize;
+    }
+
+    /** Size of the next range under the current memory pressure, applied once when the range is issued */
+    int32 GetNextChunkSize() const;
+
+    static const int32 DefaultChunkSize = 4 * 1024 * 1024;
+
+    static const int32 MinChunkSize = 256 * 1024;
+
     FOnTaskEvent OnTaskEvent;
 
+    FOnCanRequestChunk OnCanRequestChunk;
+
     static FString TempFileExtension;
 
+    /** Url encodes each path segment after the host */
+    static FString EncodeURL(const FString& URL);
+
 protected:
     void ReqGetHead();
 
     void RetGetHead(FHttpRequestPtr, const FHttpResponsePtr Response, const bool bConnectedSuccessfully);
 
+    void OnSizeKnown();
+
+    void RequestNextChunk();
+
+    void BeginWrite();
+
+    void PrepareRepair();
+
+    void OnRepairPrepared(bool bIsCopied);
+
+    bool VerifyRepair() const;
+
+    void ClearRepair();
+
+    int64 GetFileOffset(int64 FetchedSize, int64& RangeEnd) const;
+
     void ReqGetChunk();
 
-    void GetChunkProgress(FHttpRequestPtr, int32 BytesSent, int32 BytesReceived);
+    TSharedRef<class IHttpRequest> CreateRangeRequest(int64 BeginPosition, int64 EndPosition);
 
-    void RetGetChunk(FHttpRequestPtr, const FHttpResponsePtr Response, const bool bConnectedSuccessfully);
+    /** Settles a range raced by two requests, false while the other request still has to answer */
+    bool ResolveHedge(const FHttpRequestPtr& InRequest, bool bIsSucceeded);
+
+    void CancelRangeRequest(const TSharedPtr<class IHttpRequest>& InRequest) const;
+
+    void ReleaseHedge();
+
+    void GetChunkProgress(FHttpRequestPtr InRequest, int32 BytesSent, int32 BytesReceived);
+
+    void RetGetChunk(FHttpRequestPtr InRequest, const FHttpResponsePtr Response, const bool bConnectedSuccessfully);
+
+    void WriteChunk(const FHttpResponsePtr& Response);
+
+    /** Serial of the run the write was issued in, a stopped run ignores its late writes */
+    void OnChunkWritten(bool bWritten, int32 BufferSize, uint32 Serial);
 
     void OnWriteChunkEnd(int32 BufferSize);
 
+    bool RetryChunk();
+
+    void ReleaseRangeMemory();
+
     void OnTaskCompleted();
 
     FString GetEncodedURL() const;
@@ -69,11 +173,46 @@ private:
 
     EDownloadTaskState State;
 
-    const int32 ChunkSize = 4 * 1024 * 1024;
+    int32 ChunkSize = DefaultChunkSize;
+
+    int32 PreferredChunkSize = DefaultChunkSize;
 
     FString TempFileName;
 
-    IFileHandle* TempFileHandle;
+    TUniquePtr<FHotUpdateFileWriter> TempFileWriter;
+
+    double RequestStartTime = 0.0;
+
+    int32 RangeReceivedSize = 0;
+
+    int32 RangeSize = 0;
+
+    int64 RangeOffset = 0;
+
+    FString RepairSource;
+
+    int32 RepairBlockSize = 0;
+
+    TArray<int32> RepairBlocks;
+
+    TArray<FString> RepairHashes;
+
+    TArray<FDownloadRange> RepairRanges;
+
+    bool bIsWaitingChunk = false;
+
+    bool bIsWriteQueued = false;
+
+    uint32 WriteSerial = 0;
+
+    /** Lives as long as the task, work on other threads checks it on the game thread before touching the task */
+    TSharedPtr<int32, ESPMode::ThreadSafe> AliveToken = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+    int32 ReservedRangeSize = 0;
 
     TSharedPtr<class IHttpRequest> Request;
+
+    TSharedPtr<class IHttpRequest> HedgeRequest;
+
+    int32 HedgeReservedSize = 0;
 };
@@ -9,6 +9,7 @@ enum class EDownloadTaskEvent : uint8
     RET_HEAD,
     BEGIN_DOWNLOAD,
     UPDATE_DOWNLOAD,
+    END_RANGE,
     END_DOWNLOAD,
     ERROR
 };
@@ -23,6 +24,48 @@ enum class EDownloadState : uint8
     END_DOWNLOAD,
 };
 
+UENUM(BlueprintType)
+enum class EHotUpdateVerifyTier : uint8
+{
+    /** Size and modify time against the record of the last successful check */
+    Metadata,
+    /** MD5 of the pak index and footer */
+    Index,
+    /** MD5 of a few random blocks */
+    Sampled,
+    /** MD5 of the whole file */
+    Full
+};
+
+/** What the game is doing, picks the download policy so background downloads don't compete with gameplay traffic */
+UENUM(BlueprintType)
+enum class EHotUpdateGameplayState : uint8
+{
+    Idle,
+    Menu,
+    /** Replication traffic shares the link */
+    InMatch,
+    /** No new ranges are requested, ranges in flight still finish */
+    LatencySensitive
+};
+
+USTRUCT()
+struct FHotUpdateDownloadPolicy
+{
+    GENERATED_BODY()
+
+    /** Files downloaded at the same time, 0 is unlimited */
+    UPROPERTY(EditAnywhere)
+    int32 MaxConcurrency = 0;
+
+    /** Download rate limit in KB/s, 0 is unlimited */
+    UPROPERTY(EditAnywhere)
+    int32 RateLimit = 0;
+
+    UPROPERTY(EditAnywhere)
+    bool bPauseNewRanges = false;
+};
+
 UENUM(BlueprintType)
 enum class EHotUpdateState : uint8
 {
@@ -33,6 +76,8 @@ enum class EHotUpdateState : uint8
     END_DOWNLOAD,
     BEGIN_MOUNT,
     END_MOUNT,
+    BEGIN_WARMUP,
+    END_WARMUP,
     END_HOTUPDATE,
     ERROR
 };
@@ -50,6 +95,14 @@ struct FPakFileProperty
 
     FString MD5;
 
+    /** Optional MD5 from the pak index offset to the end of the file, used by the index verify tier */
+    FString IndexHash;
+
+    /** Optional MD5 of every BlockSize bytes, used by the sampled verify tier */
+    int32 BlockSize = 0;
+
+    TArray<FString> BlockHashes;
+
     bool operator ==(const FPakFileProperty& Other) const
     {
         return PakName.Equals(Other.PakName) && PakSize == Other.PakSize && MD5.ToLower().Equals(Other.MD5.ToLower());
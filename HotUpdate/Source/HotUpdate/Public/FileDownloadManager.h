@@ -3,48 +3,297 @@
 #include "TaskInfo.h"
 #include "DownLoadTask.h"
 #include "FileDownType.h"
+#include "HotUpdateReport.h"
+#include "HotUpdateLease.h"
+#include "Misc/Optional.h"
+#include "Containers/Ticker.h"
 
 DECLARE_DELEGATE_TwoParams(FOnDownloadEvent, EDownloadState, const FTaskInfo&);
 
 class HOTUPDATE_API FFileDownloadManager
 {
 public:
+    FFileDownloadManager();
+
+    virtual ~FFileDownloadManager() = default;
+
+    /** Tasks may still be added after StartUp, they start as soon as a slot is free */
     void StartUp();
 
+    /** No more tasks will be added, END_DOWNLOAD is sent once all of them finish */
+    void SealTasks();
+
     void ShutDown();
 
     void OnTaskFinish(const FTaskInfo& Info, bool bIsSuccess);
 
     void OnAllTaskFinish() const;
 
-    void AddTask(const FString& URL, const FString& Name, const int32 Size);
+    /** Tasks with the same hash and size are fetched once, the other names get a local copy */
+    void AddTask(const FString& URL, const FString& Name, const int32 Size, const FString& Hash);
+
+    /** Same as above, the index hash lets a file placed by another process be checked without hashing all of it */
+    void AddTask(const FString& URL, const FPakFileProperty& PakInfo);
+
+    /** Fetches only the damaged blocks of an installed pak into a patched copy */
+    void AddRepairTask(const FString& URL, const FPakFileProperty& PakInfo, const TArray<int32>& Blocks);
+
+    /** Copies an installed pak with the same content on the thread pool, the file is downloaded if the copy fails */
+    void AddLocalCopy(const FString& URL, const FPakFileProperty& PakInfo, const FString& SourceFile);
 
     void OnTaskEvent(EDownloadTaskEvent InEvent, const FTaskInfo& InInfo);
 
+    /** Before SealTasks nothing is planned yet, the manager counts as empty so a skipped update ends cleanly */
     bool IsSuccessful() const;
 
+    bool IsAllTaskFinished() const;
+
     FDownloadProgress GetDownloadProgress();
 
     static FString GetTempPakSaveRoot();
 
     static FString GetPakSaveRoot();
 
+    void SetReport(const TSharedPtr<FHotUpdateReport>& InReport);
+
+    void SetMaxConcurrency(int32 InMaxConcurrency);
+
+    int32 GetMaxConcurrency() const
+    {
+        return MaxConcurrency;
+    }
+
+    void SetRateLimit(int64 InRateLimit);
+
+    int64 GetRateLimit() const
+    {
+        return RateLimit;
+    }
+
+    /** Manual pause of the console command, kept apart from the gameplay policy and the on demand hold */
+    void SetPaused(bool bInPaused);
+
+    bool IsPaused() const
+    {
+        return bIsPaused;
+    }
+
+    /** Held back while an on demand pak downloads, whatever the gameplay policy says */
+    void SetOnDemandHeld(bool bInHeld);
+
+    /** Switches concurrency, rate limit and pause to the policy of the state */
+    void SetGameplayState(EHotUpdateGameplayState InState);
+
+    EHotUpdateGameplayState GetGameplayState() const
+    {
+        return GameplayState;
+    }
+
+    FHotUpdateDownloadPolicy GetPolicy(EHotUpdateGameplayState InState) const;
+
+    /** Concurrency of states without a policy of their own and the largest range size, learned by FHotUpdateTuning */
+    void ApplyTuning(int32 InConcurrency, int32 InChunkSize);
+
+    int64 GetDownloadedSize() const
+    {
+        return CurrentDownloadSize;
+    }
+
+    double GetElapsedTime() const
+    {
+        return (FDateTime::Now() - StartTime).GetTotalSeconds();
+    }
+
+    /** No rate limit, pause or concurrency change since StartUp, so the throughput reflects the network */
+    bool IsTuningSample() const
+    {
+        return !bWasThrottled && RateLimit <= 0;
+    }
+
+    FString GetStatus() const;
+
     FOnDownloadEvent OnDownloadEvent;
 
+protected:
+    /** Transport and storage hooks, the benchmark replaces them to drive the manager from memory */
+    virtual void StartTask(FDownloadTask& Task);
+
+    virtual void PlaceFile(const FTaskInfo& Info, const TArray<FString>& Aliases);
+
+    virtual void ClearTempPak();
+
+    /**
+     * Processes sharing the temp root fetch each file once: the holder of its lease downloads it, the others wait and
+     * take the installed file when the lease is released.
+     */
+    virtual bool AcquireLease(const FString& Name, TSharedPtr<FHotUpdateLease>& OutLease);
+
 private:
-    TMap<FGuid, TSharedPtr<FDownloadTask>> Tasks;
+    struct FTaskEntry
+    {
+        explicit FTaskEntry(const TSharedPtr<FDownloadTask>& Task) : Task(Task)
+        {
+        }
+
+        TSharedPtr<FDownloadTask> Task;
+
+        int32 DownloadSize = 0;
+
+        int32 ActiveSlot = INDEX_NONE;
+
+        bool bIsWaiting = false;
+
+        TArray<FString> Aliases;
+
+        TOptional<FPakFileProperty> PakInfo;
+
+        TSharedPtr<FHotUpdateLease> Lease;
+
+        /** The lease was released by another process, its file is verified on the thread pool */
+        bool bIsPeerChecking = false;
+    };
+
+    TArray<FTaskEntry> Tasks;
+
+    TMap<FGuid, int32> TaskIndices;
+
+    TMap<FString, int32> ContentIndices;
+
+    int32 FoldedTaskNum = 0;
+
+    TArray<int32> PendingTasks;
+
+    int32 NextPendingIndex = 0;
+
+    TArray<int32> ActiveTasks;
+
+    TArray<int32> WaitingTasks;
+
+    TArray<int32> FailedTasks;
+
+    /** Tasks whose file another process is fetching */
+    TArray<int32> LeaseWaitingTasks;
+
+    double LastLeasePollTime = 0.0;
+
+    /** Replaced on ShutDown, peer checks of the earlier tasks find it expired and are dropped */
+    TSharedPtr<int32, ESPMode::ThreadSafe> PeerCheckToken = MakeShared<int32, ESPMode::ThreadSafe>(0);
 
-    TArray<TSharedPtr<FDownloadTask>> FailedTasks;
+    /** Replaced on ShutDown like PeerCheckToken, for the copies of CopyFiles */
+    TSharedPtr<int32, ESPMode::ThreadSafe> CopyToken = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+    /** Copies still on the thread pool, the download is not finished before they are done */
+    int32 CopyingNum = 0;
+
+    int32 PeerTaskNum = 0;
+
+    int32 SucceededTaskNum = 0;
+
+    int32 MaxConcurrency = 0;
+
+    int32 BaseConcurrency = 0;
+
+    int32 PreferredChunkSize = FDownloadTask::DefaultChunkSize;
+
+    bool bWasThrottled = false;
+
+    int64 RateLimit = 0;
+
+    double RateTokens = 0.0;
+
+    double LastRefillTime = 0.0;
+
+    bool bIsPaused = false;
+
+    bool bIsPolicyPaused = false;
+
+    bool bIsOnDemandHeld = false;
+
+    /** Latencies in ms of the last ranges, a ring of MaxLatencySamples */
+    TArray<float> RangeLatencies;
+
+    int32 NextLatencyIndex = 0;
+
+    int32 HedgePercentile = 0;
+
+    int32 HedgeBudgetPercent = 0;
+
+    int32 HedgeNum = 0;
+
+    int32 HedgeWinNum = 0;
+
+    int64 HedgedSize = 0;
+
+    EHotUpdateGameplayState GameplayState = EHotUpdateGameplayState::Idle;
+
+    bool bIsStarted = false;
+
+    bool bIsSealed = false;
+
+    FDelegateHandle TickHandle;
 
     FDateTime StartTime;
 
-    uint64 CurrentDownloadSize = 0;
+    int64 CurrentDownloadSize = 0;
 
     uint64 TotalDownloadSize = 0;
 
-    float LastUpdateTime = 0.f;
+    double LastUpdateTime = 0.0;
+
+    double LastProgressTime = 0.0;
+
+    int64 LastDownloadedSize = 0;
+
+    bool bIsProgressQueued = false;
+
+    TSharedPtr<FHotUpdateReport> Report;
+
+    int32 FindTask(const FGuid& Guid) const;
+
+    int32 AddTaskEntry(const TSharedRef<FDownloadTask>& Task, int64 Size);
+
+    /** Any of the manual pause, the policy pause or the on demand hold stops new ranges */
+    bool IsHeld() const
+    {
+        return bIsPaused || bIsPolicyPaused || bIsOnDemandHeld;
+    }
+
+    void OnPauseChanged();
+
+    void StartPendingTasks();
+
+    void ActivateTask(int32 Index);
+
+    void DeactivateTask(int32 Index);
+
+    bool OnCanRequestChunk(const FTaskInfo& Info);
+
+    bool CanRequestChunk(const FDownloadTask& Task);
+
+    void RefillRateTokens();
+
+    /** Races slow ranges in the tail of the download against a second request, within the hedge budget */
+    void HedgeSlowRanges();
+
+    bool TakeLease(int32 Index);
+
+    void PollLeases();
+
+    /** Runs IsPlacedByPeer on the thread pool, the entry waits until OnPeerChecked */
+    void CheckPeer(int32 Index);
+
+    void OnPeerChecked(const FGuid& Guid, bool bIsPlaced);
+
+    static bool IsPlacedByPeer(const FPakFileProperty& PakInfo, bool bIsRepair);
+
+    void FinishFromPeer(int32 Index);
+
+    void CopyAliases(const FString& File, const TArray<FString>& Aliases);
+
+    /** Copies Source to every target on the thread pool, OnCopied runs on the game thread once all are done */
+    void CopyFiles(const FString& Source, const TArray<FString>& Targets, TFunction<void(bool bIsCopied)>&& OnCopied);
 
-    uint32 LastDownloadedSize = 0;
+    static FString GetLockPath(const FString& Name);
 
-    static void ClearTempPak();
+    bool Tick(float DeltaTime);
 };
@@ -3,9 +3,13 @@
 #include "TaskInfo.h"
 #include "FileDownType.h"
 #include "IPlatformFilePak.h"
+#include "HotUpdateReport.h"
+#include "RemotePakFile.h"
 
 DECLARE_DELEGATE_TwoParams(FOnMountUpdated, const FString&, float);
 
+DECLARE_DELEGATE_OneParam(FOnMountFinished, bool);
+
 class HOTUPDATE_API FFilePakManager
 {
 public:
@@ -21,6 +25,28 @@ public:
 
     void AddPakFile(FPakFileProperty&& PakFileProperty);
 
+    /** Mounts a pak listed by AddPakFile from the server instead of waiting for its download */
+    void AddRemotePak(const FString& URL, const FPakFileProperty& PakFileProperty);
+
+    /**
+     * Remote paks go to this layer instead of one of the manager's own. ShutDown takes it out of the platform file
+     * chain but leaves it to its owner, which keeps fetching and installing the paks after the update
+     */
+    void SetRemotePakPlatformFile(const TSharedPtr<FRemotePakPlatformFile>& InRemotePakPlatformFile)
+    {
+        RemotePakPlatformFile = InRemotePakPlatformFile;
+    }
+
+    void SetPrefetchPaused(bool bInPaused);
+
+    void SetReport(const TSharedPtr<FHotUpdateReport>& InReport);
+
+    /** Without mounting the paks are only verified where they are installed, for headless seeding */
+    void SetMountEnabled(const bool bInMountEnabled)
+    {
+        bIsMountEnabled = bInMountEnabled;
+    }
+
 protected:
     TArray<FPakFileProperty> PakFiles;
 
@@ -28,8 +54,42 @@ protected:
 
     FPakPlatformFile* PakPlatformFile;
 
+    TSharedPtr<FRemotePakPlatformFile> RemotePakPlatformFile;
+
+    TSet<FString> RemotePakNames;
+
+    bool bIsRemotePakChained = false;
+
+    bool bIsPrefetchPaused = false;
+
+    /** Value of pakcache.Enable before streaming turned it off, INDEX_NONE while it is untouched */
+    int32 PakCacheEnable = INDEX_NONE;
+
+    TSharedPtr<FHotUpdateReport> Report;
+
     void UpdateMountProgress(const int CurrentIndex);
 
+    void VerifyNextPak();
+
+    void OnPakVerified(bool bIsValid, double VerifyTime);
+
+    void MountPak();
+
+    void OnMountFinish();
+
+    int32 MountIndex = 0;
+
+    bool bIsMounting = false;
+
+    /** Replaced on ShutDown, verifies of the earlier run find it expired and are dropped */
+    TSharedPtr<int32, ESPMode::ThreadSafe> VerifyToken = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+    bool bIsMountEnabled = true;
+
+    int64 MountedIndexSize = 0;
+
 public:
     FOnMountUpdated OnMountUpdated;
+
+    FOnMountFinished OnMountFinished;
 };
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "HotUpdateCommandlet.generated.h"
+
+/**
+ * Runs the update pipeline of UHotUpdateSubsystem without a game instance, world or renderer: get the manifest,
+ * download what is missing and verify it in PakSaveRoot, nothing is mounted. Exits with 0 when every pak is in place.
+ *
+ * <Binary> <Project> -run=HotUpdate [-Version=<ClientVersion>] [-Platform=<Folder>] [-Server=<Url>]
+ *     [-Concurrency=<Num>] [-Rate=<KB/s>]
+ */
+UCLASS()
+class HOTUPDATE_API UHotUpdateCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UHotUpdateCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
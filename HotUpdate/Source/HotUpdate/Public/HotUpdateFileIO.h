@@ -0,0 +1,49 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Misc/SecureHash.h"
+
+enum class EHotUpdateIOBackend : uint8
+{
+    /** io_uring when enabled, with O_DIRECT reads for paks over DirectIOThreshold, the portable path otherwise */
+    Default,
+    /** Platform file handles */
+    Portable,
+    /** Linux io_uring, falls back to the portable path where it is unavailable */
+    IOUring,
+    /** io_uring with O_DIRECT reads and written pages dropped from the page cache */
+    IOUringDirect
+};
+
+/** Positional writer of a download temp file */
+class HOTUPDATE_API FHotUpdateFileWriter
+{
+public:
+    virtual ~FHotUpdateFileWriter() = default;
+
+    /**
+     * Data has to stay valid until OnWritten runs. The portable writer runs it before returning, the io_uring one on
+     * its worker thread. Destruction waits for the writes in flight
+     */
+    virtual void Write(int64 Offset, const uint8* Data, int64 Size, TFunction<void(bool)>&& OnWritten) = 0;
+};
+
+/**
+ * File I/O of downloads and pak verification. On Linux an io_uring backend batches the positional writes of all
+ * download tasks on one worker thread and hashes files with a deep queue of large sequential reads.
+ */
+class HOTUPDATE_API FHotUpdateFileIO
+{
+public:
+    /** Opens without truncating, nullptr on failure */
+    static TUniquePtr<FHotUpdateFileWriter> OpenWrite(const FString& Path, int64 FileSize,
+                                                      EHotUpdateIOBackend Backend = EHotUpdateIOBackend::Default);
+
+    /** MD5 of the whole file, invalid when it can't be read */
+    static FMD5Hash HashFile(const FString& Path, EHotUpdateIOBackend Backend = EHotUpdateIOBackend::Default);
+
+    /** bUseIOUring is set and the kernel offers io_uring with read and write operations */
+    static bool IsIOUringEnabled();
+
+    /** Stops the io_uring worker once its writes are done */
+    static void ShutDown();
+};
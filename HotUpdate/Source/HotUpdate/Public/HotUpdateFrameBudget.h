@@ -0,0 +1,56 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+/**
+ * Runs deferred HotUpdate work on the game thread within a per-frame millisecond budget.
+ * Work left over when the budget is spent waits for the next frame, at least one item runs per frame.
+ */
+class HOTUPDATE_API FHotUpdateFrameBudget
+{
+public:
+    static FHotUpdateFrameBudget& Get();
+
+    void Enqueue(const void* Owner, TFunction<void()>&& Work);
+
+    void Cancel(const void* Owner);
+
+    int32 GetQueuedNum() const
+    {
+        return Queue.Num() - Head;
+    }
+
+    float GetLongestFrameTime() const
+    {
+        return LongestFrameTime;
+    }
+
+    uint32 GetOverBudgetFrames() const
+    {
+        return OverBudgetFrames;
+    }
+
+    void ResetStats();
+
+private:
+    bool Tick(float DeltaTime);
+
+    static float GetBudget();
+
+    struct FWork
+    {
+        const void* Owner;
+
+        TFunction<void()> Work;
+    };
+
+    TArray<FWork> Queue;
+
+    int32 Head = 0;
+
+    FDelegateHandle TickHandle;
+
+    float LongestFrameTime = 0.f;
+
+    uint32 OverBudgetFrames = 0;
+};
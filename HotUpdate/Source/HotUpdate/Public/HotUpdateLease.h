@@ -0,0 +1,36 @@
+#pragma once
+#include "CoreMinimal.h"
+
+/**
+ * Exclusive hold on a lock file, shared by every process working in the same directory.
+ * The operating system drops the lock when its process dies, a crashed holder never blocks the others.
+ * The lock file is deleted on release, one left by a crashed holder is reused by the next one.
+ * Platforms without file locks only coordinate within the process.
+ */
+class HOTUPDATE_API FHotUpdateLease
+{
+public:
+    /** Null while another process or another lease in this process holds the lock */
+    static TSharedPtr<FHotUpdateLease> TryAcquire(const FString& InLockPath);
+
+    ~FHotUpdateLease();
+
+    const FString& GetLockPath() const
+    {
+        return LockPath;
+    }
+
+private:
+    explicit FHotUpdateLease(const FString& InLockPath);
+
+    FString LockPath;
+
+#if PLATFORM_WINDOWS
+    void* Handle = nullptr;
+#elif PLATFORM_MAC || PLATFORM_LINUX
+    int32 Descriptor = -1;
+
+    /** Only the holder deletes the lock file, a failed attempt may have opened the file of another holder */
+    bool bIsLocked = false;
+#endif
+};
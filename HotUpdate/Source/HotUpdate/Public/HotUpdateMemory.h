@@ -0,0 +1,83 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Launch/Resources/Version.h"
+#include "HAL/LowLevelMemTracker.h"
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 27
+LLM_DECLARE_TAG_API(HotUpdate, HOTUPDATE_API);
+
+#define HOTUPDATE_LLM_SCOPE() LLM_SCOPE_BYTAG(HotUpdate)
+#else
+#include "HAL/LowLevelMemStats.h"
+
+#ifndef HOTUPDATE_LLM_PROJECT_TAG_OFFSET
+#define HOTUPDATE_LLM_PROJECT_TAG_OFFSET 64
+#endif
+
+#define HOTUPDATE_LLM_TAG static_cast<ELLMTag>(static_cast<int32>(ELLMTag::ProjectTagStart) + HOTUPDATE_LLM_PROJECT_TAG_OFFSET)
+
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("HotUpdate"), STAT_HotUpdateLLM, STATGROUP_LLMFULL, HOTUPDATE_API);
+
+#define HOTUPDATE_LLM_SCOPE() LLM_SCOPE(HOTUPDATE_LLM_TAG)
+#endif
+#else
+#define HOTUPDATE_LLM_SCOPE()
+#endif
+
+enum class EHotUpdateMemoryStage : uint8
+{
+    GetVersion,
+    Download,
+    Mount,
+    Num
+};
+
+/**
+ * Accounts the large transient buffers of the pipeline (manifest, range responses, pak indexes) against MemoryBudget.
+ * Download tasks read the pressure to shrink ranges, the manager to hold back new requests before the cap is reached.
+ */
+class HOTUPDATE_API FHotUpdateMemory
+{
+public:
+    static FHotUpdateMemory& Get();
+
+    static void RegisterTag();
+
+    void Alloc(EHotUpdateMemoryStage Stage, int64 Size);
+
+    void Free(EHotUpdateMemoryStage Stage, int64 Size);
+
+    bool CanAlloc(int64 Size) const;
+
+    float GetPressure() const;
+
+    int64 GetUsed() const;
+
+    int64 GetPeak() const;
+
+    int64 GetStagePeak(EHotUpdateMemoryStage Stage) const;
+
+    static int64 GetBudget();
+
+    static const TCHAR* GetStageName(EHotUpdateMemoryStage Stage);
+
+    void ResetPeaks();
+
+    /** Ranges shrink and new tasks are held back from here on */
+    static constexpr float HighPressure = 0.75f;
+
+    /** Ranges grow back below this */
+    static constexpr float LowPressure = 0.5f;
+
+private:
+    mutable FCriticalSection CriticalSection;
+
+    int64 Used = 0;
+
+    int64 Peak = 0;
+
+    int64 StageUsed[static_cast<int32>(EHotUpdateMemoryStage::Num)] = {};
+
+    int64 StagePeak[static_cast<int32>(EHotUpdateMemoryStage::Num)] = {};
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "FileDownType.h"
+#include "FileDownloadManager.h"
+#include "FilePakManager.h"
+
+DECLARE_DELEGATE_OneParam(FOnOnDemandFinished, bool);
+
+DECLARE_DELEGATE_OneParam(FOnOnDemandBusy, bool);
+
+/**
+ * Paks of the manifest with an OnDemand content path are neither downloaded nor mounted by the update. The first
+ * request for a package under that path installs the pak, requests for it are called back once it is mounted.
+ * Mounted paks stay mounted until ShutDown, across updates. While prefetch is allowed, the paks FHotUpdatePredictor
+ * expects next are downloaded slowly in the background, a real request cancels or takes over the prefetch.
+ */
+class HOTUPDATE_API FHotUpdateOnDemand : public TSharedFromThis<FHotUpdateOnDemand>
+{
+public:
+    /** Forgets the paks not requested yet, before the paks of a new manifest are added */
+    void Reset();
+
+    /** bIsInstalled for paks already valid on disk and mounted by the update, they are only tracked for usage */
+    void AddPak(const FString& URL, const FPakFileProperty& PakInfo, const FString& ContentPath, bool bIsInstalled);
+
+    /** False while the package lives in an on demand pak that is not mounted yet */
+    bool IsContentAvailable(const FString& PackageName) const;
+
+    /** Installs the pak holding the package if needed, OnFinished runs right away when there is nothing to install */
+    void Request(const FString& PackageName, const FOnOnDemandFinished& OnFinished);
+
+    /** Set by the subsystem while the player idles in a menu and no update runs */
+    void SetPrefetchAllowed(bool bInAllowed);
+
+    void ShutDown();
+
+    bool IsBusy() const
+    {
+        return bIsBusy;
+    }
+
+    /** True while an on demand pak downloads, the update yields its bandwidth meanwhile */
+    FOnOnDemandBusy OnBusyChanged;
+
+private:
+    enum class EOnDemandState : uint8
+    {
+        Registered,
+        Prefetching,
+        /** On disk but not mounted */
+        Prefetched,
+        Downloading,
+        Mounting,
+        Mounted,
+        /** Mounted by the update */
+        Installed,
+        Failed
+    };
+
+    struct FOnDemandPak
+    {
+        FOnDemandPak(const FString& InURL, const FPakFileProperty& InPakInfo, const FString& InContentPath) :
+            URL(InURL), PakInfo(InPakInfo), ContentPath(InContentPath)
+        {
+        }
+
+        FString URL;
+
+        FPakFileProperty PakInfo;
+
+        FString ContentPath;
+
+        EOnDemandState State = EOnDemandState::Registered;
+
+        TArray<FOnOnDemandFinished> Callbacks;
+
+        TSharedPtr<FFileDownloadManager> DownloadManager;
+
+        /** Owns the mount, the pak is unmounted with it */
+        TSharedPtr<FFilePakManager> PakManager;
+    };
+
+    TSharedPtr<FOnDemandPak> FindPak(const FString& PackageName) const;
+
+    void Download(const TSharedRef<FOnDemandPak>& Pak);
+
+    void OnDownloaded(const TSharedRef<FOnDemandPak>& Pak);
+
+    /** Starts the prefetch of the most likely pak that fits the budget, if prefetch is allowed and none runs */
+    void UpdatePrefetch();
+
+    void CancelPrefetch();
+
+    static bool IsNetworkUnmetered();
+
+    /** bIsRemote mounts the pak from the server, otherwise from its downloaded file */
+    void Mount(const TSharedRef<FOnDemandPak>& Pak, bool bIsRemote);
+
+    void Finish(const TSharedRef<FOnDemandPak>& Pak, bool bIsSucceeded);
+
+    void UpdateBusy();
+
+    TArray<TSharedRef<FOnDemandPak>> Paks;
+
+    bool bIsBusy = false;
+
+    bool bIsPrefetchAllowed = false;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include "CoreMinimal.h"
+
+/**
+ * Learns from the on demand paks used on this device which one tends to come next, such as the map after the current
+ * one in a rotation, kept in Saved/HotUpdate/Predictor.json. Counts decay with every use so new habits take over.
+ */
+class HOTUPDATE_API FHotUpdatePredictor
+{
+public:
+    static FHotUpdatePredictor& Get();
+
+    void Record(const FString& PakName);
+
+    /** Chance of the pak being the next one used after the last one, 0 for paks never used */
+    float GetScore(const FString& PakName);
+
+    /** Prefetched paks count against the prefetch budget until they are used or gone from disk */
+    void AddPrefetched(const FString& PakName, int64 Size);
+
+    int64 GetPrefetchedSize();
+
+    /** What followed the last pak weighs more than how often a pak is used at all */
+    static constexpr float TransitionWeight = 0.7f;
+
+    static constexpr float Decay = 0.9f;
+
+private:
+    void Load();
+
+    void Save() const;
+
+    static FString GetPath();
+
+    TMap<FString, TMap<FString, float>> Transitions;
+
+    TMap<FString, float> Uses;
+
+    TMap<FString, int64> Prefetched;
+
+    FString LastPak;
+
+    bool bIsLoaded = false;
+};
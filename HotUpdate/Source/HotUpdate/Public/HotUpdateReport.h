@@ -0,0 +1,71 @@
+#pragma once
+#include "CoreMinimal.h"
+
+struct FHotUpdateFileReport
+{
+    FString FileName;
+
+    int64 Bytes = 0;
+
+    double BeginTime = 0.0;
+
+    double DownloadTime = 0.0;
+
+    uint32 Retries = 0;
+
+    int32 Ranges = 0;
+
+    TArray<float> RangeLatencies;
+
+    int64 DiscardedBytes = 0;
+
+    double VerifyTime = 0.0;
+
+    double MountTime = 0.0;
+
+    bool bSuccess = true;
+};
+
+/**
+ * Collects per-file and per-phase numbers of one update and writes them as json under Saved/HotUpdate/Reports.
+ */
+class HOTUPDATE_API FHotUpdateReport
+{
+public:
+    void Reset();
+
+    void SetEnvironment(const FString& Key, const FString& Value);
+
+    void SetPhaseTime(const FString& Phase, double Seconds);
+
+    void SetCounter(const FString& Counter, double Value);
+
+    void OnFileBegin(const FString& FileName);
+
+    void OnRangeEnd(const FString& FileName, float Latency);
+
+    void OnFileEnd(const FString& FileName, int64 Bytes, uint32 Retries, int64 DiscardedBytes, bool bSuccess);
+
+    void AddVerifyTime(const FString& FileName, double Seconds);
+
+    void AddMountTime(const FString& FileName, double Seconds);
+
+    bool Write(const FString& Result, const FString& Message) const;
+
+    static FString GetReportSaveRoot();
+
+    static float GetPercentile(TArray<float> Values, float Percentile);
+
+private:
+    FHotUpdateFileReport& FindOrAddFile(const FString& FileName);
+
+    TArray<FHotUpdateFileReport> Files;
+
+    TMap<FString, int32> FileIndices;
+
+    TMap<FString, FString> Environment;
+
+    TMap<FString, double> PhaseTimes;
+
+    TMap<FString, double> Counters;
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "FileDownType.h"
 #include "HotUpdateSettings.generated.h"
 
 /**
@@ -29,4 +30,127 @@ public:
 
     UPROPERTY(Config, EditAnywhere)
     uint32 MaxRetryTime = 3;
+
+    UPROPERTY(Config, EditAnywhere)
+    bool bWriteReport = true;
+
+    /** GET <Version>/<Platform>/pointer.json and the manifest it names instead of posting, for static CDN hosting */
+    UPROPERTY(Config, EditAnywhere)
+    bool bUseStaticManifest = false;
+
+    /**
+     * Manifest tags a client selects for each dimension it has not chosen itself, lang defaults to the language of the
+     * device. Entries whose tags don't match are neither downloaded nor mounted
+     */
+    UPROPERTY(Config, EditAnywhere)
+    TArray<FString> DefaultTags;
+
+    /** Files downloaded at the same time, 0 is unlimited */
+    UPROPERTY(Config, EditAnywhere)
+    int32 MaxConcurrency = 0;
+
+    /** Download rate limit in KB/s, 0 is unlimited */
+    UPROPERTY(Config, EditAnywhere)
+    int32 RateLimit = 0;
+
+    /**
+     * Start from the concurrency and range size that were fastest on this connection type and host in past sessions,
+     * kept in Saved/HotUpdate/Tuning.json. MaxConcurrency is only used until a session has been measured, with 0 the
+     * downloads stay unlimited and are not tuned
+     */
+    UPROPERTY(Config, EditAnywhere)
+    bool bUseTuningProfile = true;
+
+    /**
+     * Limits for each gameplay state set by game code. Idle and Menu default to MaxConcurrency and RateLimit, InMatch
+     * to one file at 128 KB/s and LatencySensitive to no new ranges
+     */
+    UPROPERTY(Config, EditAnywhere)
+    TMap<EHotUpdateGameplayState, FHotUpdateDownloadPolicy> GameplayPolicies;
+
+    /**
+     * Once no file is queued, a range slower than this percentile of recent range latencies is requested again on
+     * another connection and the first response wins, 0 disables hedging
+     */
+    UPROPERTY(Config, EditAnywhere)
+    int32 HedgePercentile = 95;
+
+    /** Cap of the bytes spent on hedged ranges, in percent of the download size */
+    UPROPERTY(Config, EditAnywhere)
+    int32 HedgeBudgetPercent = 5;
+
+    /** Memory cap in MB for manifest, range and pak index buffers, 0 is unlimited */
+    UPROPERTY(Config, EditAnywhere)
+    int32 MemoryBudget = 0;
+
+    /** Game thread time per frame for download callbacks, progress and mounting, 0 runs them inline */
+    UPROPERTY(Config, EditAnywhere)
+    float GameThreadBudgetMs = 2.f;
+
+    /** Connections to the content host opened while the version request is in flight, 0 disables the warm-up */
+    UPROPERTY(Config, EditAnywhere)
+    int32 WarmUpConnections = 3;
+
+    /** Check of paks already on disk, files without a record of a passed check are always hashed in full */
+    UPROPERTY(Config, EditAnywhere)
+    EHotUpdateVerifyTier VerifyTier = EHotUpdateVerifyTier::Metadata;
+
+    /** Hours between full checks of all paks, a crashed update also forces one. 0 disables the periodic check */
+    UPROPERTY(Config, EditAnywhere)
+    int32 FullVerifyInterval = 168;
+
+    /** Blocks hashed per pak by the sampled tier */
+    UPROPERTY(Config, EditAnywhere)
+    int32 SampledBlockCount = 8;
+
+    /**
+     * Paks of at least this size in MB with block hashes in the manifest are mounted from the server right away and
+     * read block by block, the rest is fetched in the background. 0 downloads every pak before mounting
+     */
+    UPROPERTY(Config, EditAnywhere)
+    int32 RemotePakThreshold = 0;
+
+    /** Blocks of streamed paks fetched at the same time in the background, 0 only fetches blocks when they are read */
+    UPROPERTY(Config, EditAnywhere)
+    int32 RemotePakPrefetchConcurrency = 2;
+
+    /** Disk cap in MB of the blocks of streamed paks, the least recently read ones are deleted first */
+    UPROPERTY(Config, EditAnywhere)
+    int32 BlockCacheSize = 2048;
+
+    /** Disk cap in MB of on demand paks downloaded ahead of their first use, 0 never prefetches */
+    UPROPERTY(Config, EditAnywhere)
+    int32 OnDemandPrefetchBudget = 512;
+
+    /** Bandwidth cap in KB/s of prefetching, which only runs on WiFi or Ethernet while idle in a menu */
+    UPROPERTY(Config, EditAnywhere)
+    int32 OnDemandPrefetchRateLimit = 256;
+
+    /** Size cap in MB of the packages loaded after the mount before the update finishes, 0 skips the warm-up */
+    UPROPERTY(Config, EditAnywhere)
+    int32 WarmUpBudget = 256;
+
+    /** Seconds the warm-up may hold back the end of the update */
+    UPROPERTY(Config, EditAnywhere)
+    float WarmUpTimeLimit = 10.f;
+
+    /** Packages of the warm-up loading at the same time */
+    UPROPERTY(Config, EditAnywhere)
+    int32 WarmUpConcurrency = 4;
+
+    /** Packages recorded in the first match after an update for the warm-up of the next one, 0 records nothing */
+    UPROPERTY(Config, EditAnywhere)
+    int32 WarmUpRecordLimit = 1024;
+
+    /** Linux only, download writes and pak hashing go through io_uring when the kernel allows it */
+    UPROPERTY(Config, EditAnywhere)
+    bool bUseIOUring = true;
+
+    /** Paks of at least this size in MB are hashed with O_DIRECT and written without staying in the page cache */
+    UPROPERTY(Config, EditAnywhere)
+    int32 DirectIOThreshold = 1024;
+
+    /** Reads or writes in flight per io_uring instance */
+    UPROPERTY(Config, EditAnywhere)
+    int32 IOQueueDepth = 32;
 };
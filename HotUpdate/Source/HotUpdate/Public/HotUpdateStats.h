@@ -0,0 +1,30 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("HotUpdate"), STATGROUP_HotUpdate, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Write Chunk"), STAT_HotUpdate_WriteChunk, STATGROUP_HotUpdate, HOTUPDATE_API);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Task Finish"), STAT_HotUpdate_TaskFinish, STATGROUP_HotUpdate, HOTUPDATE_API);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mount Pak"), STAT_HotUpdate_MountPak, STATGROUP_HotUpdate, HOTUPDATE_API);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Frame Budget"), STAT_HotUpdate_FrameBudget, STATGROUP_HotUpdate, HOTUPDATE_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active Requests"), STAT_HotUpdate_ActiveRequests, STATGROUP_HotUpdate,
+                                      HOTUPDATE_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Queued Tasks"), STAT_HotUpdate_QueuedTasks, STATGROUP_HotUpdate,
+                                      HOTUPDATE_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Write Queue Depth"), STAT_HotUpdate_WriteQueueDepth, STATGROUP_HotUpdate,
+                                      HOTUPDATE_API);
+
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Bytes In Flight"), STAT_HotUpdate_BytesInFlight, STATGROUP_HotUpdate, HOTUPDATE_API);
+
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Hash Throughput (MB/s)"), STAT_HotUpdate_HashThroughput, STATGROUP_HotUpdate,
+                                      HOTUPDATE_API);
+
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Last Mount Time (ms)"), STAT_HotUpdate_MountTime, STATGROUP_HotUpdate,
+                                      HOTUPDATE_API);
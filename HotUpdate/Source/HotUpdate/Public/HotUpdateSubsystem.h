@@ -8,7 +8,14 @@
 #include "TaskInfo.h"
 #include "Engine/EngineTypes.h"
 #include "FileDownloadManager.h"
+#include "HotUpdateReport.h"
+#include "ManifestParser.h"
+#include "ManifestPlanner.h"
+#include "HotUpdateOnDemand.h"
+#include "HotUpdateWarmUp.h"
 #include "Interfaces/IHttpRequest.h"
+#include "Containers/Ticker.h"
+#include "UObject/UObjectGlobals.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "HotUpdateSubsystem.generated.h"
 
@@ -20,6 +27,8 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnHotUpdateFinished);
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMountUpdate, FString, PakName, float, Progress);
 
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnContentReady, bool, bIsSucceeded);
+
 /**
  * 
  */
@@ -38,15 +47,50 @@ public:
 
     void ShutDown();
 
+    /** Runs the update without a game instance or world, for the given client version and platform folder */
+    void StartUpHeadless(const FString& InVersion, const FString& InPlatform);
+
     UFUNCTION(BlueprintPure, Category = "HotUpdateSubsystem")
     bool IsFinished() const { return !bIsUpdating; }
 
+    bool HasFailed() const { return bHasFailed; }
+
     UFUNCTION(BlueprintCallable)
     static bool CanSkipUpdate();
 
     UFUNCTION(BlueprintCallable)
     void ForceSkipUpdate() const;
 
+    /** Game code reports what it is doing, downloads follow the matching GameplayPolicies entry */
+    UFUNCTION(BlueprintCallable)
+    void SetGameplayState(EHotUpdateGameplayState InState);
+
+    /**
+     * Tags this device wants, saved across sessions. Dimensions left out fall back to DefaultTags and the device
+     * language. The next StartUp fetches entries that match now and didn't before
+     */
+    UFUNCTION(BlueprintCallable)
+    void SetSelectedTags(const TArray<FString>& InTags);
+
+    /** The selection in effect, including the defaults of dimensions not selected */
+    UFUNCTION(BlueprintPure, Category = "HotUpdateSubsystem")
+    TArray<FString> GetSelectedTags() const;
+
+    /** Every tag of the last manifest, for a settings screen to offer */
+    UFUNCTION(BlueprintPure, Category = "HotUpdateSubsystem")
+    TArray<FString> GetAvailableTags() const { return AvailableTags.Array(); }
+
+    /** False while the package lives in an OnDemand pak of the manifest that is not installed yet */
+    UFUNCTION(BlueprintPure, Category = "HotUpdateSubsystem")
+    bool IsContentAvailable(const FString& PackageName) const;
+
+    /** Installs the OnDemand pak holding the package ahead of the running update, OnReady runs once it is mounted */
+    UFUNCTION(BlueprintCallable)
+    void RequestContent(const FString& PackageName, const FOnContentReady& OnReady);
+
+    /** LoadPackageAsync that waits for the OnDemand pak of the package instead of failing */
+    void LoadPackageOnDemand(const FString& PackageName, const FLoadPackageAsyncDelegate& OnLoaded);
+
 public:
     FOnHotUpdatState OnHotUpdateStateEvent;
 
@@ -65,26 +109,76 @@ protected:
 private:
     void ReqGetVersion();
 
-    void OnReqGetVersionTimeOut();
+    void CreateManagers();
+
+    void SetTimeOut();
+
+    void ClearTimeOut();
+
+    bool OnReqGetVersionTimeOut(float);
+
+    void RetGetPointer(FHttpRequestPtr, const FHttpResponsePtr Response, const bool bConnectedSuccessfully);
 
     void RetGetVersion(FHttpRequestPtr, const FHttpResponsePtr Response, const bool bConnectedSuccessfully);
 
+    void WarmUpConnections() const;
+
+    void ParseManifest();
+
+    void StartMissingTasks();
+
+    void OnManifestEntry(const FManifestEntry& Entry);
+
+    void VerifyManifest();
+
+    void ScheduleManifest();
+
+    void ReleaseManifest();
+
+    static double GetSliceTime();
+
+    /** States sharing the link with gameplay traffic, background fetching of streamed paks waits for them to end */
+    static bool IsNetworkBusy(EHotUpdateGameplayState InState);
+
     void OnDownloadEvent(const EDownloadState Event, const FTaskInfo& TaskInfo) const;
 
     void OnUpdateDownloadProgress() const;
 
     FString GetHotUpdateServerUrl() const;
 
+    FString GetContentURL() const;
+
+    FString GetRequestVersion() const;
+
+    FString GetRequestPlatform() const;
+
+    FString GetEntryURL(const FManifestEntry& Entry) const;
+
     void OnSkipUpdate() const;
 
     UFUNCTION()
     void OnMountProcess(const FString& PakName, float Progress) const;
 
+    void OnMountFinished(bool bIsSuccessful);
+
+    void OnWarmUpFinished();
+
+    void OnOnDemandBusy(bool bIsBusy) const;
+
+    void OnRemotePaksInstalled();
+
+    /** On demand paks are prefetched only while the player idles in a menu and no update runs */
+    void UpdatePrefetchAllowed() const;
+
     UFUNCTION()
     void OnHotUpdateState(EHotUpdateState State, const FString& Message);
 
     static FString GetPlatform();
 
+    void TracePhase(EHotUpdateState State);
+
+    void WriteReport(const FString& Result, const FString& Message) const;
+
 public:
     TSharedPtr<FFileDownloadManager> DownloadManager;
 
@@ -92,10 +186,59 @@ public:
 
     TSharedPtr<IHttpRequest> Request;
 
+    TSharedPtr<FHotUpdateReport> Report;
+
+    /** Outlives the managers of an update, it keeps the paks it mounted */
+    TSharedPtr<FHotUpdateOnDemand> OnDemand;
+
+    /** Outlives the managers of an update, it holds the warmed packages until the first match ends */
+    TSharedPtr<FHotUpdateWarmUp> WarmUp;
+
+    /** Outlives the managers of an update, it fetches the rest of the streamed paks and installs them */
+    TSharedPtr<FRemotePakPlatformFile> RemotePakFile;
+
 private:
-    FTimerHandle TimeOutHandle;
+    /** On the core ticker rather than a world timer, the update also runs in commandlets without a world */
+    FDelegateHandle TimeOutHandle;
 
     uint32 CurrentTimeRetry = 0;
 
+    FHttpResponsePtr ManifestResponse;
+
+    TSharedPtr<FManifestParser> ManifestParser;
+
+    FManifestPlanner ManifestPlanner;
+
+    FString ManifestURL;
+
+    int64 ManifestMemorySize = 0;
+
+    double UpdateStartTime = 0.0;
+
+    double PhaseStartTime = 0.0;
+
     bool bIsUpdating = false;
+
+    bool bHasFailed = false;
+
+    EHotUpdateGameplayState GameplayState = EHotUpdateGameplayState::Idle;
+
+    UPROPERTY(Config)
+    TArray<FString> SelectedTags;
+
+    /** GetSelectedTags of the running update */
+    TSet<FString> ActiveTags;
+
+    TSet<FString> AvailableTags;
+
+    int32 SkippedEntryNum = 0;
+
+    int64 SkippedEntrySize = 0;
+
+    /** Paks are verified in place but not mounted */
+    bool bIsHeadless = false;
+
+    FString HeadlessVersion;
+
+    FString HeadlessPlatform;
 };
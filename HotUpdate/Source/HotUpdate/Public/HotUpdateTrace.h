@@ -0,0 +1,68 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Launch/Resources/Version.h"
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 26
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+#define HOTUPDATE_TRACE_ENABLED CPUPROFILERTRACE_ENABLED
+#else
+#define HOTUPDATE_TRACE_ENABLED 0
+#endif
+
+/**
+ * Insights instrumentation for the update pipeline, enabled with -trace=cpu,hotupdate.
+ * Scopes are named after the phase, file scopes carry the pak name so a single file can be followed on the timeline.
+ */
+#if HOTUPDATE_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(HotUpdateChannel, HOTUPDATE_API);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(HotUpdate_InFlightRequests);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(HotUpdate_DownloadedBytes);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(HotUpdate_FinishedTasks);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(HotUpdate_MountedPaks);
+
+TRACE_DECLARE_FLOAT_COUNTER_EXTERN(HotUpdate_RangeLatencyMs);
+
+TRACE_DECLARE_FLOAT_COUNTER_EXTERN(HotUpdate_FrameWorkMs);
+
+TRACE_DECLARE_MEMORY_COUNTER_EXTERN(HotUpdate_TrackedMemory);
+
+#define HOTUPDATE_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Name, HotUpdateChannel)
+
+/** The name is only formatted while the channel is on, file scopes run once per range and per hash */
+#define HOTUPDATE_TRACE_SCOPE_FORMAT(Format, ...) \
+    TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(UE_TRACE_CHANNELEXPR_IS_ENABLED(HotUpdateChannel) \
+                                                      ? *FString::Printf(Format, ##__VA_ARGS__) \
+                                                      : TEXT(""), HotUpdateChannel)
+
+#define HOTUPDATE_TRACE_COUNTER_SET(Counter, Value) TRACE_COUNTER_SET(Counter, Value)
+
+#define HOTUPDATE_TRACE_COUNTER_ADD(Counter, Value) TRACE_COUNTER_ADD(Counter, Value)
+
+#define HOTUPDATE_TRACE_COUNTER_SUBTRACT(Counter, Value) TRACE_COUNTER_SUBTRACT(Counter, Value)
+
+#define HOTUPDATE_TRACE_BOOKMARK(Format, ...) TRACE_BOOKMARK(Format, ##__VA_ARGS__)
+
+#else
+
+#define HOTUPDATE_TRACE_SCOPE(Name)
+
+#define HOTUPDATE_TRACE_SCOPE_FORMAT(Format, ...)
+
+#define HOTUPDATE_TRACE_COUNTER_SET(Counter, Value)
+
+#define HOTUPDATE_TRACE_COUNTER_ADD(Counter, Value)
+
+#define HOTUPDATE_TRACE_COUNTER_SUBTRACT(Counter, Value)
+
+#define HOTUPDATE_TRACE_BOOKMARK(Format, ...)
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+#include "CoreMinimal.h"
+
+struct FHotUpdateTuningProfile
+{
+    /** Best concurrency found so far and the throughput it reached in bytes per second */
+    int32 Concurrency = 0;
+
+    int32 ChunkSize = 0;
+
+    double Throughput = 0.0;
+
+    /** Step of the next probe around Concurrency, flipped when a probe loses */
+    int32 Direction = 1;
+
+    int32 Sessions = 0;
+};
+
+/**
+ * Remembers the download tuning of past sessions per connection type and host in Saved/HotUpdate/Tuning.json, so
+ * a session starts from what worked last time instead of the settings. Every other session probes one step of
+ * concurrency away from the best one and keeps the step when it is faster.
+ */
+class HOTUPDATE_API FHotUpdateTuning
+{
+public:
+    static FHotUpdateTuning& Get();
+
+    static FString GetKey(const FString& ServerUrl);
+
+    /** Concurrency and chunk size to use in this session, 0 keeps the default */
+    void Begin(const FString& InKey, int32 DefaultConcurrency, int32& OutConcurrency, int32& OutChunkSize);
+
+    /** Records the throughput of the session, sessions too short or throttled to measure are skipped */
+    void End(int64 DownloadedSize, double Seconds);
+
+    /** Target time of one range, long enough to amortize the request and short enough to react to the network */
+    static constexpr double TargetRangeSeconds = 1.0;
+
+    static const int64 MinSampleSize = 8 * 1024 * 1024;
+
+    static const int32 MaxProbeConcurrency = 16;
+
+private:
+    void LoadProfiles();
+
+    void SaveProfiles() const;
+
+    static FString GetProfilePath();
+
+    FCriticalSection CriticalSection;
+
+    TMap<FString, FHotUpdateTuningProfile> Profiles;
+
+    bool bIsLoaded = false;
+
+    FString Key;
+
+    int32 TrialConcurrency = 0;
+};
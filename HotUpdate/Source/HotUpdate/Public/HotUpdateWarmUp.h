@@ -0,0 +1,128 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "FileDownType.h"
+#include "Async/AsyncFileHandle.h"
+#include "UObject/GCObject.h"
+#include "UObject/UObjectGlobals.h"
+
+DECLARE_DELEGATE(FOnWarmUpFinished);
+
+/**
+ * Loads the packages an update patched before the first match needs them. After the mount, the WarmUp lists of the
+ * patched manifest entries and then the packages this device loaded in its first match after the last update are
+ * read ahead and loaded async in their recorded order, a few at a time, until the size budget or the time limit is
+ * spent or the player leaves the menu. Loaded packages are kept until the first match after the update ends, the
+ * loads of that match are recorded to Saved/HotUpdate/WarmUp.json for the next update.
+ */
+class HOTUPDATE_API FHotUpdateWarmUp : public TSharedFromThis<FHotUpdateWarmUp>, public FGCObject
+{
+public:
+    virtual ~FHotUpdateWarmUp() override;
+
+    /** Releases the packages of the last warm-up, before the lists of a new manifest are added */
+    void Reset();
+
+    void AddPackages(const TArray<FString>& PackageNames);
+
+    /** OnFinished runs once the warm-up stops, right away when it is disabled or there is nothing to load */
+    void StartUp();
+
+    /** Stops the running warm-up without calling OnFinished, loaded packages are kept */
+    void Cancel();
+
+    void ShutDown();
+
+    void SetGameplayState(EHotUpdateGameplayState InState);
+
+    /** Records the packages loaded from now until the end of the first match */
+    void StartRecording();
+
+    virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+    virtual FString GetReferencerName() const override
+    {
+        return TEXT("FHotUpdateWarmUp");
+    }
+
+    FOnWarmUpFinished OnFinished;
+
+private:
+    struct FWarmUpPackage
+    {
+        FString PackageName;
+
+        int64 Size = 0;
+
+        bool bExists = false;
+    };
+
+    struct FReadAhead
+    {
+        IAsyncReadFileHandle* Handle = nullptr;
+
+        IAsyncReadRequest* Request = nullptr;
+    };
+
+    bool Tick(float DeltaTime);
+
+    /** Finds the files of the package and issues precache reads for them */
+    void ReadAhead(FWarmUpPackage& Package);
+
+    void OnPackageLoaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result,
+                         uint32 InGeneration);
+
+    void Finish();
+
+    void Stop();
+
+    /** Cancels the precache reads in flight, requests have to complete before they are deleted */
+    void ReleaseReadAheads();
+
+    void Release();
+
+    void OnLoadPackage(const FString& PackageName);
+
+    void StopRecording();
+
+    void LoadRecord();
+
+    static FString GetPath();
+
+    TArray<FWarmUpPackage> Packages;
+
+    TSet<FString> PackageNames;
+
+    /** Next package to read ahead and next one to load, the read ahead runs a few packages in front */
+    int32 ReadAheadIndex = 0;
+
+    int32 LoadIndex = 0;
+
+    int32 LoadingNum = 0;
+
+    int64 WarmedSize = 0;
+
+    double StartTime = 0.0;
+
+    /** Load callbacks of an earlier warm-up are ignored */
+    uint32 Generation = 0;
+
+    TArray<FReadAhead> ReadAheads;
+
+    TArray<UPackage*> LoadedPackages;
+
+    FDelegateHandle TickHandle;
+
+    EHotUpdateGameplayState GameplayState = EHotUpdateGameplayState::Idle;
+
+    bool bHasPlayed = false;
+
+    bool bIsRecording = false;
+
+    TArray<FString> Record;
+
+    TSet<FString> RecordedNames;
+
+    FDelegateHandle AsyncLoadHandle;
+
+    FDelegateHandle SyncLoadHandle;
+};
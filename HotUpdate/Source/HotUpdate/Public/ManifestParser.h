@@ -0,0 +1,97 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/JsonReader.h"
+#include "FileDownType.h"
+
+struct FManifestEntry
+{
+    FString File;
+
+    FString Hash;
+
+    int64 Size = 0;
+
+    /** Location below the server url in a published tree, empty means <Version>/<Platform>/<File> */
+    FString Url;
+
+    FString IndexHash;
+
+    int32 BlockSize = 0;
+
+    TArray<FString> Blocks;
+
+    /** <Dimension>:<Value> such as lang:zh or quality:high, a tag without a colon is a dimension of its own */
+    TArray<FString> Tags;
+
+    /** Content path such as /Game/Cosmetics/ of a pak installed on the first request for its content, not by updates */
+    FString OnDemand;
+
+    /** Packages of the pak in the order the game first loads them, warmed up after the update patched the pak */
+    TArray<FString> WarmUp;
+
+    FPakFileProperty ToPakFileProperty() const;
+
+    /** Untagged entries always match, tagged ones when each of their dimensions has a selected tag */
+    bool MatchesTags(const TSet<FString>& SelectedTags) const;
+
+    static FString GetTagDimension(const FString& Tag);
+};
+
+DECLARE_DELEGATE_OneParam(FOnManifestEntry, const FManifestEntry&);
+
+enum class EManifestParseResult : uint8
+{
+    Pending,
+    Finished,
+    Error
+};
+
+/**
+ * Pull parser for the version manifest,
+ * {"<Version>": [{"File", "HASH", "Size", "Url", "IndexHash", "BlockSize", "Blocks", "Tags", "OnDemand", "WarmUp"}]}.
+ * Reads the utf8 response in place and hands out one entry at a time, no json tree or string copy of the content is built.
+ */
+class HOTUPDATE_API FManifestParser
+{
+public:
+    explicit FManifestParser(const TArray<uint8>& Content);
+
+    /** Parses until the end or until TimeLimit seconds are spent, 0 parses everything in one call */
+    EManifestParseResult Parse(double TimeLimit);
+
+    int32 GetEntryNum() const
+    {
+        return EntryNum;
+    }
+
+    const FString& GetErrorMessage() const
+    {
+        return ErrorMessage;
+    }
+
+    FOnManifestEntry OnEntry;
+
+private:
+    void OnValue(EJsonNotation Notation);
+
+    FMemoryReader Archive;
+
+    TSharedRef<TJsonReader<UTF8CHAR>> Reader;
+
+    int32 Depth = 0;
+
+    bool bIsEntryArray = false;
+
+    bool bIsBlockArray = false;
+
+    bool bIsTagArray = false;
+
+    bool bIsWarmUpArray = false;
+
+    FManifestEntry Entry;
+
+    int32 EntryNum = 0;
+
+    FString ErrorMessage;
+};
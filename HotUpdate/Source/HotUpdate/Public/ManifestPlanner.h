@@ -0,0 +1,117 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "ManifestParser.h"
+#include "HotUpdateReport.h"
+
+DECLARE_DELEGATE(FOnManifestVerified);
+
+/**
+ * Collapses the manifest before anything is scheduled: one entry per target path, the last version wins,
+ * and entries sharing a content hash are resolved against whatever is already valid on disk.
+ */
+class HOTUPDATE_API FManifestPlanner
+{
+public:
+    void Reset();
+
+    void SetReport(const TSharedPtr<FHotUpdateReport>& InReport);
+
+    void AddEntry(const FManifestEntry& Entry);
+
+    /**
+     * Picks up to MaxNum entries with no file on disk and no other entry sharing their content, in manifest order.
+     * They need neither verify nor local copy, so they are fetched while the rest is still being verified.
+     */
+    void TakeMissingEntries(int32 MaxNum, TArray<int32>& OutIndices);
+
+    bool IsEntryTaken(const int32 Index) const
+    {
+        return TakenEntries.Contains(Index);
+    }
+
+    /**
+     * Verifies the local pak of each entry not taken, and scans damaged ones for bad blocks, on the thread pool.
+     * Returns false until OnVerified runs, true once every entry is verified
+     */
+    bool Verify();
+
+    const TArray<FManifestEntry>& GetEntries() const
+    {
+        return Entries;
+    }
+
+    bool IsEntryValid(const int32 Index) const
+    {
+        return ValidEntries.IsValidIndex(Index) && ValidEntries[Index];
+    }
+
+    /** Another entry with the same content that is already valid on disk, INDEX_NONE if there is none */
+    int32 FindValidSource(int32 Index) const;
+
+    /** Damaged blocks of an installed pak that is cheaper to repair than to download again, nullptr otherwise */
+    const TArray<int32>* FindRepairBlocks(const int32 Index) const
+    {
+        return RepairBlocks.Find(Index);
+    }
+
+    int32 GetDuplicatedPathNum() const
+    {
+        return DuplicatedPathNum;
+    }
+
+    static FString GetContentKey(const FString& Hash, int64 Size);
+
+    /** Game thread, planning goes on from here once the paks are verified */
+    FOnManifestVerified OnVerified;
+
+private:
+    struct FEntryVerify
+    {
+        FEntryVerify(const int32 InIndex, FPakFileProperty&& InPakInfo, FString&& InPakPath) : Index(InIndex),
+            PakInfo(MoveTemp(InPakInfo)), PakPath(MoveTemp(InPakPath))
+        {
+        }
+
+        int32 Index;
+
+        FPakFileProperty PakInfo;
+
+        FString PakPath;
+
+        bool bIsValid = false;
+
+        double VerifyTime = 0.0;
+
+        bool bIsScanned = false;
+
+        TArray<int32> BadBlocks;
+    };
+
+    /** Thread pool, hashing every block of an installed pak takes far longer than a frame */
+    static void VerifyEntry(FEntryVerify& EntryVerify);
+
+    void OnEntriesVerified(TArray<FEntryVerify>&& EntryVerifies);
+
+    TArray<FManifestEntry> Entries;
+
+    TMap<FString, int32> PathIndices;
+
+    TBitArray<> ValidEntries;
+
+    TMap<FString, int32> ValidContents;
+
+    TMap<int32, TArray<int32>> RepairBlocks;
+
+    TSet<int32> TakenEntries;
+
+    int32 DuplicatedPathNum = 0;
+
+    bool bIsVerifying = false;
+
+    bool bIsVerified = false;
+
+    /** Replaced on Reset, verifies of an earlier manifest find it expired and are dropped */
+    TSharedPtr<int32, ESPMode::ThreadSafe> VerifyToken = MakeShared<int32, ESPMode::ThreadSafe>(0);
+
+    TSharedPtr<FHotUpdateReport> Report;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Containers/List.h"
+
+/**
+ * Blocks of remote paks kept on disk across sessions, one file per block under <PakSaveRoot>/BlockCache/<PakHash>.
+ * Once the blocks pass BlockCacheSize the least recently read ones are deleted. Recency survives restarts through the
+ * file time, which is refreshed the first time a block is read in a session. Thread safe.
+ */
+class HOTUPDATE_API FPakBlockCache
+{
+public:
+    static FPakBlockCache& Get();
+
+    bool Read(const FString& PakHash, int32 Index, TArray<uint8>& OutData);
+
+    void Write(const FString& PakHash, int32 Index, const TArray<uint8>& Data);
+
+    bool Contains(const FString& PakHash, int32 Index);
+
+    /** Drops every block of a pak, once it is installed in full */
+    void Remove(const FString& PakHash);
+
+    int64 GetCapacity();
+
+private:
+    typedef TDoubleLinkedList<FString>::TDoubleLinkedListNode FRecentNode;
+
+    struct FBlockRecord
+    {
+        int64 Size = 0;
+
+        /** Position of the block in RecentBlocks */
+        FRecentNode* Node = nullptr;
+
+        bool bIsTouched = false;
+    };
+
+    void Load();
+
+    void MarkUsed(const FString& Key, FBlockRecord& Record);
+
+    void RemoveRecord(const FString& Key);
+
+    void Evict();
+
+    static FString GetKey(const FString& PakHash, int32 Index);
+
+    static FString GetCacheRoot();
+
+    FCriticalSection CriticalSection;
+
+    TMap<FString, FBlockRecord> Blocks;
+
+    /** Keys of the blocks, the most recently used at the head, eviction takes them from the tail */
+    TDoubleLinkedList<FString> RecentBlocks;
+
+    int64 TotalSize = 0;
+
+    int64 Capacity = 0;
+
+    bool bIsLoaded = false;
+};
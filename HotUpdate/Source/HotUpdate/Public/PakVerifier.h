@@ -0,0 +1,72 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "FileDownType.h"
+
+struct FPakVerifyRecord
+{
+    int64 Size = 0;
+
+    int64 TimeStamp = 0;
+
+    FString Hash;
+
+    /** Passed a check in this update, later checks of the same file only compare metadata */
+    bool bIsSessionVerified = false;
+};
+
+/**
+ * Checks local paks at the configured VerifyTier, falling back to a stronger tier when the manifest lacks its data.
+ * A file without a record is always hashed in full. After a crash or every FullVerifyInterval hours the whole update
+ * runs at the full tier. Records of passed files are kept in Saved/HotUpdate/VerifyRecords.json.
+ */
+class HOTUPDATE_API FPakVerifier
+{
+public:
+    static FPakVerifier& Get();
+
+    void BeginUpdate();
+
+    void EndUpdate(bool bIsSuccessful);
+
+    /** Thread safe */
+    bool Verify(const FPakFileProperty& PakInfo);
+
+    EHotUpdateVerifyTier GetTier() const
+    {
+        return Tier;
+    }
+
+    static bool VerifyFull(const FString& PakPath, const FPakFileProperty& PakInfo);
+
+    static bool VerifyIndex(const FString& PakPath, const FPakFileProperty& PakInfo);
+
+    static bool VerifySampled(const FString& PakPath, const FPakFileProperty& PakInfo);
+
+    /** Hashes every block of the installed pak, false when the file or the manifest can't locate damage by block */
+    static bool FindBadBlocks(const FPakFileProperty& PakInfo, TArray<int32>& OutBlocks);
+
+    static bool ReadIndexOffset(FArchive& Reader, int64& IndexOffset);
+
+    static FString HashRange(FArchive& Reader, int64 Offset, int64 Size);
+
+    static const TCHAR* GetTierName(EHotUpdateVerifyTier InTier);
+
+private:
+    void LoadRecords();
+
+    void SaveRecords() const;
+
+    static FString GetRecordPath();
+
+    static FString GetMarkerPath();
+
+    mutable FCriticalSection CriticalSection;
+
+    TMap<FString, FPakVerifyRecord> Records;
+
+    FDateTime LastFullVerify = FDateTime::MinValue();
+
+    EHotUpdateVerifyTier Tier = EHotUpdateVerifyTier::Full;
+
+    bool bIsUpdating = false;
+};
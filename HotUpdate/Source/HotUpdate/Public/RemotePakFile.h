@@ -0,0 +1,213 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "FileDownType.h"
+#include "Launch/Resources/Version.h"
+#include "Containers/Ticker.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+/**
+ * Reads of a streamed pak block until the block arrives, which needs http responses completed on the http thread.
+ * Older engines complete them on the game thread, so streamed paks are downloaded in full before mounting there
+ */
+#define HOTUPDATE_WITH_REMOTE_PAK (ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 26)
+
+DECLARE_DELEGATE(FOnRemotePaksInstalled);
+
+/**
+ * A pak on the server read through the block cache, each block is fetched by range and checked against the block
+ * hashes of the manifest. Once every block is cached the pak is assembled into a local file and reads switch to it.
+ */
+class HOTUPDATE_API FRemotePak : public TSharedFromThis<FRemotePak, ESPMode::ThreadSafe>
+{
+public:
+    FRemotePak(const FString& InURL, const FPakFileProperty& InPakInfo);
+
+    /** Waits until the block is fetched or every retry failed, callable from any thread but the http one */
+    bool ReadBlock(int32 Index, TArray<uint8>& OutData);
+
+    /** Starts fetching the next block that is neither cached nor in flight, false once there is none */
+    bool PrefetchBlock();
+
+    /** Writes the pak file from the cached blocks on a worker, reads switch to it once it matches the pak hash */
+    void InstallAsync(IPlatformFile* PlatformFile);
+
+    /** Not installed, not being installed and not given up after failed installs */
+    bool CanPrefetch() const
+    {
+        return !bIsInstalled && !bIsInstalling && InstallCount <= MaxRetryTime;
+    }
+
+    int32 GetFetchNum();
+
+    int64 GetSize() const
+    {
+        return PakInfo.PakSize;
+    }
+
+    int32 GetBlockSize() const
+    {
+        return PakInfo.BlockSize;
+    }
+
+    const FString& GetName() const
+    {
+        return PakInfo.PakName;
+    }
+
+    const FString& GetPath() const
+    {
+        return Path;
+    }
+
+    const FString& GetHash() const
+    {
+        return PakInfo.MD5;
+    }
+
+    bool IsInstalled() const
+    {
+        return bIsInstalled;
+    }
+
+private:
+    struct FBlockFetch;
+
+    TSharedRef<FBlockFetch, ESPMode::ThreadSafe> BeginFetch(int32 Index);
+
+    void SendFetch(const TSharedRef<FBlockFetch, ESPMode::ThreadSafe>& Fetch);
+
+    void OnFetched(const TSharedRef<FBlockFetch, ESPMode::ThreadSafe>& Fetch, const TArray<uint8>* Content);
+
+    bool Install(IPlatformFile& PlatformFile);
+
+    int64 GetBlockOffset(int32 Index) const;
+
+    FString URL;
+
+    FPakFileProperty PakInfo;
+
+    FString Path;
+
+    uint32 MaxRetryTime = 3;
+
+    float TimeOutDelay = 10.f;
+
+    FCriticalSection CriticalSection;
+
+    TMap<int32, TSharedRef<FBlockFetch, ESPMode::ThreadSafe>> Fetches;
+
+    /** Game thread only, a failed install asks for a new pass through bIsRefetchNeeded */
+    int32 PrefetchIndex = 0;
+
+    FThreadSafeBool bIsRefetchNeeded;
+
+    uint32 InstallCount = 0;
+
+    FThreadSafeBool bIsInstalling;
+
+    FThreadSafeBool bIsInstalled;
+};
+
+/**
+ * Platform file layer below the pak platform file that serves streamed paks at their install path, every other file
+ * goes to the lower level. Remote paks are added before the layer is put into the chain and never removed. The layer
+ * keeps fetching and installing after it leaves the chain, until every pak is installed.
+ */
+class HOTUPDATE_API FRemotePakPlatformFile : public IPlatformFile
+{
+public:
+    ~FRemotePakPlatformFile();
+
+    /** Whether the entry can be mounted before it is downloaded, it needs block hashes and the size threshold */
+    static bool CanStream(const FPakFileProperty& PakInfo);
+
+    /** A pak already streamed at the same path with the same hash keeps its progress */
+    void AddRemotePak(const FString& URL, const FPakFileProperty& PakInfo);
+
+    bool HasRemotePaks() const
+    {
+        return RemotePaks.Num() > 0;
+    }
+
+    /** Background fetching of the blocks not read yet, paused while the game needs the network */
+    void SetPrefetchPaused(const bool bInPaused)
+    {
+        bIsPrefetchPaused = bInPaused;
+    }
+
+    virtual bool Initialize(IPlatformFile* Inner, const TCHAR* CmdLine) override;
+
+    virtual IPlatformFile* GetLowerLevel() override
+    {
+        return LowerLevel;
+    }
+
+    virtual void SetLowerLevel(IPlatformFile* NewLowerLevel) override
+    {
+        LowerLevel = NewLowerLevel;
+    }
+
+    virtual const TCHAR* GetName() const override
+    {
+        return TEXT("RemotePakFile");
+    }
+
+    virtual bool FileExists(const TCHAR* Filename) override;
+
+    virtual int64 FileSize(const TCHAR* Filename) override;
+
+    virtual bool DeleteFile(const TCHAR* Filename) override;
+
+    virtual bool IsReadOnly(const TCHAR* Filename) override;
+
+    virtual bool MoveFile(const TCHAR* To, const TCHAR* From) override;
+
+    virtual bool SetReadOnly(const TCHAR* Filename, bool bNewReadOnlyValue) override;
+
+    virtual FDateTime GetTimeStamp(const TCHAR* Filename) override;
+
+    virtual void SetTimeStamp(const TCHAR* Filename, FDateTime DateTime) override;
+
+    virtual FDateTime GetAccessTimeStamp(const TCHAR* Filename) override;
+
+    virtual FString GetFilenameOnDisk(const TCHAR* Filename) override;
+
+    virtual IFileHandle* OpenRead(const TCHAR* Filename, bool bAllowWrite = false) override;
+
+    virtual IFileHandle* OpenWrite(const TCHAR* Filename, bool bAppend = false, bool bAllowRead = false) override;
+
+    virtual IAsyncReadFileHandle* OpenAsyncRead(const TCHAR* Filename) override;
+
+    virtual IMappedFileHandle* OpenMapped(const TCHAR* Filename) override;
+
+    virtual bool DirectoryExists(const TCHAR* Directory) override;
+
+    virtual bool CreateDirectory(const TCHAR* Directory) override;
+
+    virtual bool DeleteDirectory(const TCHAR* Directory) override;
+
+    virtual FFileStatData GetStatData(const TCHAR* FilenameOrDirectory) override;
+
+    virtual bool IterateDirectory(const TCHAR* Directory, FDirectoryVisitor& Visitor) override;
+
+    virtual bool IterateDirectoryStat(const TCHAR* Directory, FDirectoryStatVisitor& Visitor) override;
+
+    /** Game thread, once every pak is installed and the ticker stopped, the owner may release the layer here */
+    FOnRemotePaksInstalled OnInstalled;
+
+private:
+    /** The remote pak at Filename while it is not installed, nullptr otherwise */
+    TSharedPtr<FRemotePak, ESPMode::ThreadSafe> FindRemotePak(const TCHAR* Filename) const;
+
+    bool Tick(float DeltaTime);
+
+    IPlatformFile* LowerLevel = nullptr;
+
+    TMap<FString, TSharedPtr<FRemotePak, ESPMode::ThreadSafe>> RemotePaks;
+
+    FDelegateHandle TickHandle;
+
+    bool bIsPrefetchPaused = false;
+
+    int32 PrefetchConcurrency = 2;
+};
@@ -8,7 +8,8 @@ struct FTaskInfo
 {
     GENERATED_BODY()
 
-    FTaskInfo() : FileSize(0), CurrentSize(0), DownloadSize(0), TotalSize(0), GUID(FGuid::NewGuid())
+    FTaskInfo() : FileSize(0), CurrentSize(0), DownloadSize(0), TotalSize(0), RetryCount(0), DiscardedSize(0),
+                  RangeLatency(0.f), HedgeWins(0), GUID(FGuid::NewGuid())
     {
     }
 
@@ -24,5 +25,14 @@ struct FTaskInfo
 
     int32 TotalSize;
 
+    uint32 RetryCount;
+
+    int32 DiscardedSize;
+
+    float RangeLatency;
+
+    /** Ranges whose hedged request answered first */
+    uint32 HedgeWins;
+
     FGuid GUID;
 };
@@ -0,0 +1,7 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HotUpdateEditor.h"
+
+DEFINE_LOG_CATEGORY(LogHotUpdateEditor);
+
+IMPLEMENT_MODULE(FHotUpdateEditorModule, HotUpdateEditor)
@@ -0,0 +1,260 @@
+#include "HotUpdateManifestCommandlet.h"
+#include "HotUpdateEditor.h"
+#include "PakHasher.h"
+#include "PakTagRules.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace HotUpdateManifest
+{
+    /** Pak names from an order file, one per line, anything after the name such as a priority is ignored */
+    static TArray<FString> LoadOrder(const FString& Path)
+    {
+        TArray<FString> Lines;
+
+        TArray<FString> Order;
+
+        FFileHelper::LoadFileToStringArray(Lines, *Path);
+
+        for (const auto& Line : Lines)
+        {
+            TArray<FString> Tokens;
+
+            Line.TrimStartAndEnd().ParseIntoArrayWS(Tokens);
+
+            if (Tokens.Num() > 0 && !Tokens[0].StartsWith(TEXT("#")))
+            {
+                Order.Add(FPaths::GetCleanFilename(Tokens[0].TrimQuotes()));
+            }
+        }
+
+        return Order;
+    }
+
+    static void SortPaks(TArray<FString>& PakNames, const TArray<FString>& Order)
+    {
+        PakNames.Sort([&Order](const FString& A, const FString& B)
+        {
+            auto IndexA = Order.IndexOfByPredicate([&A](const FString& Name)
+            {
+                return Name.Equals(A, ESearchCase::IgnoreCase);
+            });
+
+            auto IndexB = Order.IndexOfByPredicate([&B](const FString& Name)
+            {
+                return Name.Equals(B, ESearchCase::IgnoreCase);
+            });
+
+            IndexA = IndexA == INDEX_NONE ? MAX_int32 : IndexA;
+
+            IndexB = IndexB == INDEX_NONE ? MAX_int32 : IndexB;
+
+            return IndexA != IndexB ? IndexA < IndexB : A < B;
+        });
+    }
+
+    static TSharedRef<FJsonObject> ToJson(const FManifestEntry& Entry, const int32 Order)
+    {
+        const auto JsonObject = MakeShared<FJsonObject>();
+
+        JsonObject->SetStringField(TEXT("File"), Entry.File);
+
+        JsonObject->SetStringField(TEXT("HASH"), Entry.Hash);
+
+        JsonObject->SetNumberField(TEXT("Size"), Entry.Size);
+
+        JsonObject->SetNumberField(TEXT("Order"), Order);
+
+        if (!Entry.IndexHash.IsEmpty())
+        {
+            JsonObject->SetStringField(TEXT("IndexHash"), Entry.IndexHash);
+        }
+
+        if (Entry.BlockSize > 0)
+        {
+            JsonObject->SetNumberField(TEXT("BlockSize"), Entry.BlockSize);
+
+            TArray<TSharedPtr<FJsonValue>> Blocks;
+
+            for (const auto& Block : Entry.Blocks)
+            {
+                Blocks.Add(MakeShared<FJsonValueString>(Block));
+            }
+
+            JsonObject->SetArrayField(TEXT("Blocks"), Blocks);
+        }
+
+        if (Entry.Tags.Num() > 0)
+        {
+            TArray<TSharedPtr<FJsonValue>> Tags;
+
+            for (const auto& Tag : Entry.Tags)
+            {
+                Tags.Add(MakeShared<FJsonValueString>(Tag));
+            }
+
+            JsonObject->SetArrayField(TEXT("Tags"), Tags);
+        }
+
+        if (!Entry.OnDemand.IsEmpty())
+        {
+            JsonObject->SetStringField(TEXT("OnDemand"), Entry.OnDemand);
+        }
+
+        if (Entry.WarmUp.Num() > 0)
+        {
+            TArray<TSharedPtr<FJsonValue>> WarmUp;
+
+            for (const auto& PackageName : Entry.WarmUp)
+            {
+                WarmUp.Add(MakeShared<FJsonValueString>(PackageName));
+            }
+
+            JsonObject->SetArrayField(TEXT("WarmUp"), WarmUp);
+        }
+
+        return JsonObject;
+    }
+}
+
+UHotUpdateManifestCommandlet::UHotUpdateManifestCommandlet()
+{
+    IsClient = false;
+
+    IsServer = false;
+
+    IsEditor = true;
+
+    LogToConsole = true;
+}
+
+int32 UHotUpdateManifestCommandlet::Main(const FString& Params)
+{
+    FString PaksDir;
+
+    FString OutputPath;
+
+    FString Version;
+
+    if (!FParse::Value(*Params, TEXT("Paks="), PaksDir) || !FParse::Value(*Params, TEXT("Output="), OutputPath) ||
+        !FParse::Value(*Params, TEXT("Version="), Version))
+    {
+        UE_LOG(LogHotUpdateEditor, Error, TEXT("Usage: -run=HotUpdateManifest -Paks=<Dir> -Output=<File> ")
+               TEXT("-Version=<PatchVersion> [-BlockSize=<Bytes>] [-Order=<File>] [-Tags=<File>] [-NoCache]"));
+
+        return 1;
+    }
+
+    auto BlockSize = 0;
+
+    FParse::Value(*Params, TEXT("BlockSize="), BlockSize);
+
+    if (BlockSize > 0)
+    {
+        BlockSize = FMath::Max(BlockSize, 4 * 1024);
+    }
+
+    TArray<FString> PakNames;
+
+    IFileManager::Get().FindFiles(PakNames, *FPaths::Combine(PaksDir, TEXT("*.pak")), true, false);
+
+    FString OrderPath;
+
+    HotUpdateManifest::SortPaks(PakNames, FParse::Value(*Params, TEXT("Order="), OrderPath)
+                                              ? HotUpdateManifest::LoadOrder(OrderPath)
+                                              : TArray<FString>());
+
+    TArray<FString> PakPaths;
+
+    for (const auto& PakName : PakNames)
+    {
+        PakPaths.Add(FPaths::Combine(PaksDir, PakName));
+    }
+
+    const auto StartTime = FPlatformTime::Seconds();
+
+    FPakHasher Hasher(BlockSize);
+
+    Hasher.LoadCache(FParse::Param(*Params, TEXT("NoCache")) ? FString() : FPakHasher::GetDefaultCachePath());
+
+    TArray<FManifestEntry> Entries;
+
+    const auto bIsHashed = Hasher.HashFiles(PakPaths, Entries);
+
+    Hasher.SaveCache();
+
+    if (!bIsHashed)
+    {
+        return 1;
+    }
+
+    FString TagsPath;
+
+    if (FParse::Value(*Params, TEXT("Tags="), TagsPath))
+    {
+        FPakTagRules TagRules;
+
+        if (!TagRules.Load(TagsPath))
+        {
+            return 1;
+        }
+
+        for (auto& Entry : Entries)
+        {
+            TagRules.Apply(Entry);
+        }
+    }
+
+    const auto HashTime = FPlatformTime::Seconds() - StartTime;
+
+    FString JsonStr;
+
+    TSharedPtr<FJsonObject> Manifest;
+
+    if (FFileHelper::LoadFileToString(JsonStr, *OutputPath) &&
+        !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonStr), Manifest))
+    {
+        UE_LOG(LogHotUpdateEditor, Error, TEXT("Failed to read existing manifest %s"), *OutputPath);
+
+        return 1;
+    }
+
+    if (!Manifest.IsValid())
+    {
+        Manifest = MakeShared<FJsonObject>();
+    }
+
+    TArray<TSharedPtr<FJsonValue>> Values;
+
+    for (auto i = 0; i < Entries.Num(); ++i)
+    {
+        Values.Add(MakeShared<FJsonValueObject>(HotUpdateManifest::ToJson(Entries[i], i)));
+    }
+
+    Manifest->SetArrayField(Version, Values);
+
+    JsonStr.Reset();
+
+    FJsonSerializer::Serialize(Manifest.ToSharedRef(), TJsonWriterFactory<>::Create(&JsonStr));
+
+    // Servers read version.json while it is regenerated, it only ever changes by a rename
+    const auto& TempPath = OutputPath + TEXT(".tmp");
+
+    if (!FFileHelper::SaveStringToFile(JsonStr, *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM) ||
+        !IFileManager::Get().Move(*OutputPath, *TempPath, true))
+    {
+        UE_LOG(LogHotUpdateEditor, Error, TEXT("Failed to write manifest %s"), *OutputPath);
+
+        return 1;
+    }
+
+    const auto HashedMB = Hasher.GetHashedBytes() / (1024.0 * 1024.0);
+
+    UE_LOG(LogHotUpdateEditor, Display, TEXT("%s: %d paks in %s, %d from the hash cache, %.1f MB hashed in %.2fs ")
+           TEXT("(%.1f MB/s)"), *Version, Entries.Num(), *OutputPath, Hasher.GetCacheHits(), HashedMB, HashTime,
+           HashedMB / FMath::Max(HashTime, 0.001));
+
+    return 0;
+}
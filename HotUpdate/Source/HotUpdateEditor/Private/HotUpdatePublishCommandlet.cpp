@@ -0,0 +1,756 @@
+#include "HotUpdatePublishCommandlet.h"
+#include "HotUpdateEditor.h"
+#include "PakHasher.h"
+#include "PakTagRules.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+
+namespace HotUpdatePublish
+{
+    static const int32 DefaultBlockSize = 1024 * 1024;
+
+    static const uint32 BinaryManifestMagic = 0x464D5548;
+
+    static const uint32 DeltaMagic = 0x4C445548;
+
+    static const int32 FormatVersion = 1;
+
+    /** 2 adds the tags of each entry, 3 its on demand content path, 4 its warm-up packages */
+    static const int32 ManifestFormatVersion = 4;
+
+    struct FPublishedPak : FManifestEntry
+    {
+        FString SourcePath;
+
+        TArray<TSharedPtr<FJsonValue>> Deltas;
+    };
+
+    /** Earlier version of a pak as a client may still have it installed */
+    struct FPreviousPak
+    {
+        FString Hash;
+
+        int32 BlockSize = 0;
+
+        TArray<FString> Blocks;
+    };
+
+    struct FPublishStats
+    {
+        int32 NewPaks = 0;
+
+        int64 NewBytes = 0;
+
+        int32 Deltas = 0;
+
+        int64 DeltaBytes = 0;
+    };
+
+    static FString GetShardedPath(const FString& Folder, const FString& Hash, const FString& Extension)
+    {
+        return FString::Printf(TEXT("%s/%s/%s%s"), *Folder, *Hash.Left(2), *Hash, *Extension);
+    }
+
+    static FString ToHex(FMD5& Md5)
+    {
+        uint8 Digest[16];
+
+        Md5.Final(Digest);
+
+        return BytesToHex(Digest, sizeof(Digest));
+    }
+
+    /** Immutable files are written under a temporary name first, a half written file must never get its final name */
+    static bool CopyImmutable(const FString& Source, const FString& Destination)
+    {
+        if (IFileManager::Get().FileSize(*Destination) == IFileManager::Get().FileSize(*Source))
+        {
+            return true;
+        }
+
+        const auto& TempPath = Destination + TEXT(".tmp");
+
+        return IFileManager::Get().Copy(*TempPath, *Source) == COPY_OK &&
+            IFileManager::Get().Move(*Destination, *TempPath, true);
+    }
+
+    static bool SaveAtomically(const FString& Content, const FString& Path)
+    {
+        const auto& TempPath = Path + TEXT(".tmp");
+
+        return FFileHelper::SaveStringToFile(Content, *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM) &&
+            IFileManager::Get().Move(*Path, *TempPath, true);
+    }
+
+    static bool SaveArrayAtomically(const TArray<uint8>& Content, const FString& Path)
+    {
+        const auto& TempPath = Path + TEXT(".tmp");
+
+        return FFileHelper::SaveArrayToFile(Content, *TempPath) && IFileManager::Get().Move(*Path, *TempPath, true);
+    }
+
+    static FString ToJsonString(const TSharedRef<FJsonObject>& JsonObject)
+    {
+        FString JsonStr;
+
+        const auto JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonStr);
+
+        FJsonSerializer::Serialize(JsonObject, JsonWriter);
+
+        return JsonStr;
+    }
+
+    static TSharedPtr<FJsonObject> LoadJson(const FString& Path)
+    {
+        FString JsonStr;
+
+        TSharedPtr<FJsonObject> JsonObject;
+
+        if (!FFileHelper::LoadFileToString(JsonStr, *Path) ||
+            !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonStr), JsonObject))
+        {
+            return nullptr;
+        }
+
+        return JsonObject;
+    }
+
+    static TArray<FString> GetStringArray(const TSharedPtr<FJsonObject>& JsonObject, const FString& Field)
+    {
+        TArray<FString> Values;
+
+        const TArray<TSharedPtr<FJsonValue>>* Array = nullptr;
+
+        if (JsonObject->TryGetArrayField(Field, Array))
+        {
+            for (const auto& Value : *Array)
+            {
+                Values.Add(Value->AsString());
+            }
+        }
+
+        return Values;
+    }
+
+    static TSharedRef<FJsonObject> ToJson(const FPublishedPak& Pak)
+    {
+        const auto JsonObject = MakeShared<FJsonObject>();
+
+        JsonObject->SetStringField(TEXT("File"), Pak.File);
+
+        JsonObject->SetStringField(TEXT("HASH"), Pak.Hash);
+
+        JsonObject->SetNumberField(TEXT("Size"), Pak.Size);
+
+        JsonObject->SetStringField(TEXT("Url"), Pak.Url);
+
+        if (!Pak.IndexHash.IsEmpty())
+        {
+            JsonObject->SetStringField(TEXT("IndexHash"), Pak.IndexHash);
+        }
+
+        JsonObject->SetNumberField(TEXT("BlockSize"), Pak.BlockSize);
+
+        TArray<TSharedPtr<FJsonValue>> Blocks;
+
+        for (const auto& Block : Pak.Blocks)
+        {
+            Blocks.Add(MakeShared<FJsonValueString>(Block));
+        }
+
+        JsonObject->SetArrayField(TEXT("Blocks"), Blocks);
+
+        if (Pak.Tags.Num() > 0)
+        {
+            TArray<TSharedPtr<FJsonValue>> Tags;
+
+            for (const auto& Tag : Pak.Tags)
+            {
+                Tags.Add(MakeShared<FJsonValueString>(Tag));
+            }
+
+            JsonObject->SetArrayField(TEXT("Tags"), Tags);
+        }
+
+        if (!Pak.OnDemand.IsEmpty())
+        {
+            JsonObject->SetStringField(TEXT("OnDemand"), Pak.OnDemand);
+        }
+
+        if (Pak.WarmUp.Num() > 0)
+        {
+            TArray<TSharedPtr<FJsonValue>> WarmUp;
+
+            for (const auto& PackageName : Pak.WarmUp)
+            {
+                WarmUp.Add(MakeShared<FJsonValueString>(PackageName));
+            }
+
+            JsonObject->SetArrayField(TEXT("WarmUp"), WarmUp);
+        }
+
+        if (Pak.Deltas.Num() > 0)
+        {
+            JsonObject->SetArrayField(TEXT("Deltas"), Pak.Deltas);
+        }
+
+        return JsonObject;
+    }
+
+    /** Every hash an earlier manifest gave each file, newest first */
+    static TMap<FString, TArray<FPreviousPak>> CollectPreviousPaks(const TSharedPtr<FJsonObject>& Manifest)
+    {
+        TMap<FString, TArray<FPreviousPak>> PreviousPaks;
+
+        if (!Manifest.IsValid())
+        {
+            return PreviousPaks;
+        }
+
+        for (const auto& Version : Manifest->Values)
+        {
+            const TArray<TSharedPtr<FJsonValue>>* Entries = nullptr;
+
+            if (!Version.Value.IsValid() || !Version.Value->TryGetArray(Entries))
+            {
+                continue;
+            }
+
+            for (const auto& Value : *Entries)
+            {
+                const auto& Entry = Value->AsObject();
+
+                FString File;
+
+                FPreviousPak PreviousPak;
+
+                double BlockSize = 0.0;
+
+                if (!Entry.IsValid() || !Entry->TryGetStringField(TEXT("File"), File) ||
+                    !Entry->TryGetStringField(TEXT("HASH"), PreviousPak.Hash) ||
+                    !Entry->TryGetNumberField(TEXT("BlockSize"), BlockSize))
+                {
+                    continue;
+                }
+
+                PreviousPak.BlockSize = static_cast<int32>(BlockSize);
+
+                PreviousPak.Blocks = GetStringArray(Entry, TEXT("Blocks"));
+
+                auto& Paks = PreviousPaks.FindOrAdd(File);
+
+                Paks.RemoveAll([&PreviousPak](const FPreviousPak& Pak)
+                {
+                    return Pak.Hash.Equals(PreviousPak.Hash, ESearchCase::IgnoreCase);
+                });
+
+                Paks.Insert(PreviousPak, 0);
+            }
+        }
+
+        return PreviousPaks;
+    }
+
+    /**
+     * Blocks of Pak that differ from Previous, packed into one object so a CDN serves a patch as a single cacheable
+     * file. Layout: magic, format version, from hash, to hash, to size, block size, block indices, block data.
+     */
+    static bool WriteDelta(const FString& OutputDir, FPublishedPak& Pak, const FPreviousPak& Previous,
+                           FPublishStats& Stats)
+    {
+        TArray<int32> Blocks;
+
+        for (auto Block = 0; Block < Pak.Blocks.Num(); ++Block)
+        {
+            if (!Previous.Blocks.IsValidIndex(Block) ||
+                !Previous.Blocks[Block].Equals(Pak.Blocks[Block], ESearchCase::IgnoreCase))
+            {
+                Blocks.Add(Block);
+            }
+        }
+
+        // Same threshold as the client side block repair, past it a whole download is about as cheap
+        if (Blocks.Num() <= 0 || Blocks.Num() > Pak.Blocks.Num() / 2)
+        {
+            return false;
+        }
+
+        const auto& Url = FString::Printf(TEXT("deltas/%s/%s.delta"), *Previous.Hash.ToLower(), *Pak.Hash);
+
+        const auto& Path = FPaths::Combine(OutputDir, Url);
+
+        auto Size = IFileManager::Get().FileSize(*Path);
+
+        if (Size < 0)
+        {
+            const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Pak.SourcePath));
+
+            if (!Reader.IsValid())
+            {
+                return false;
+            }
+
+            TArray<uint8> Content;
+
+            FMemoryWriter Writer(Content);
+
+            auto Magic = DeltaMagic;
+
+            auto Version = FormatVersion;
+
+            auto FromHash = Previous.Hash.ToLower();
+
+            auto ToHash = Pak.Hash;
+
+            auto ToSize = Pak.Size;
+
+            auto BlockSize = Pak.BlockSize;
+
+            Writer << Magic << Version << FromHash << ToHash << ToSize << BlockSize << Blocks;
+
+            TArray<uint8> Buffer;
+
+            Buffer.SetNumUninitialized(Pak.BlockSize);
+
+            for (const auto Block : Blocks)
+            {
+                const auto Offset = static_cast<int64>(Block) * Pak.BlockSize;
+
+                const auto ReadSize = FMath::Min<int64>(Pak.BlockSize, Pak.Size - Offset);
+
+                Reader->Seek(Offset);
+
+                Reader->Serialize(Buffer.GetData(), ReadSize);
+
+                if (Reader->IsError())
+                {
+                    return false;
+                }
+
+                Writer.Serialize(Buffer.GetData(), ReadSize);
+            }
+
+            if (!SaveArrayAtomically(Content, Path))
+            {
+                UE_LOG(LogHotUpdateEditor, Warning, TEXT("Failed to write delta %s"), *Path);
+
+                return false;
+            }
+
+            Size = Content.Num();
+
+            Stats.Deltas++;
+
+            Stats.DeltaBytes += Size;
+        }
+
+        const auto Delta = MakeShared<FJsonObject>();
+
+        Delta->SetStringField(TEXT("From"), Previous.Hash.ToLower());
+
+        Delta->SetStringField(TEXT("Url"), Url);
+
+        Delta->SetNumberField(TEXT("Size"), Size);
+
+        Delta->SetNumberField(TEXT("Blocks"), Blocks.Num());
+
+        Pak.Deltas.Add(MakeShared<FJsonValueObject>(Delta));
+
+        return true;
+    }
+
+    /**
+     * Same content as the json manifest for loaders that skip json parsing. Layout: magic, format version, version
+     * count, then per version its name, entry count and entries of file, hash, size, url, index hash, block size,
+     * raw 16 byte block digests, deltas, tags, on demand content path and warm-up packages.
+     */
+    static TArray<uint8> ToBinaryManifest(const FJsonObject& Manifest)
+    {
+        TArray<uint8> Content;
+
+        FMemoryWriter Writer(Content);
+
+        auto Magic = BinaryManifestMagic;
+
+        auto Version = ManifestFormatVersion;
+
+        auto VersionNum = Manifest.Values.Num();
+
+        Writer << Magic << Version << VersionNum;
+
+        for (const auto& Pair : Manifest.Values)
+        {
+            auto Name = Pair.Key;
+
+            const TArray<TSharedPtr<FJsonValue>>* Entries = nullptr;
+
+            const TArray<TSharedPtr<FJsonValue>> Empty;
+
+            if (!Pair.Value.IsValid() || !Pair.Value->TryGetArray(Entries))
+            {
+                Entries = &Empty;
+            }
+
+            auto EntryNum = Entries->Num();
+
+            Writer << Name << EntryNum;
+
+            for (const auto& Value : *Entries)
+            {
+                const auto& Entry = Value->AsObject();
+
+                auto File = Entry->GetStringField(TEXT("File"));
+
+                auto Hash = Entry->GetStringField(TEXT("HASH"));
+
+                auto Size = static_cast<int64>(Entry->GetNumberField(TEXT("Size")));
+
+                FString Url;
+
+                FString IndexHash;
+
+                double BlockSizeValue = 0.0;
+
+                Entry->TryGetStringField(TEXT("Url"), Url);
+
+                Entry->TryGetStringField(TEXT("IndexHash"), IndexHash);
+
+                Entry->TryGetNumberField(TEXT("BlockSize"), BlockSizeValue);
+
+                auto BlockSize = static_cast<int32>(BlockSizeValue);
+
+                const auto& Blocks = GetStringArray(Entry, TEXT("Blocks"));
+
+                auto BlockNum = Blocks.Num();
+
+                Writer << File << Hash << Size << Url << IndexHash << BlockSize << BlockNum;
+
+                for (const auto& Block : Blocks)
+                {
+                    uint8 Digest[16] = {};
+
+                    HexToBytes(Block, Digest);
+
+                    Writer.Serialize(Digest, sizeof(Digest));
+                }
+
+                const TArray<TSharedPtr<FJsonValue>>* Deltas = nullptr;
+
+                auto DeltaNum = Entry->TryGetArrayField(TEXT("Deltas"), Deltas) ? Deltas->Num() : 0;
+
+                Writer << DeltaNum;
+
+                for (auto i = 0; i < DeltaNum; ++i)
+                {
+                    const auto& Delta = (*Deltas)[i]->AsObject();
+
+                    auto From = Delta->GetStringField(TEXT("From"));
+
+                    auto DeltaUrl = Delta->GetStringField(TEXT("Url"));
+
+                    auto DeltaSize = static_cast<int64>(Delta->GetNumberField(TEXT("Size")));
+
+                    Writer << From << DeltaUrl << DeltaSize;
+                }
+
+                auto Tags = GetStringArray(Entry, TEXT("Tags"));
+
+                Writer << Tags;
+
+                FString OnDemand;
+
+                Entry->TryGetStringField(TEXT("OnDemand"), OnDemand);
+
+                Writer << OnDemand;
+
+                auto WarmUp = GetStringArray(Entry, TEXT("WarmUp"));
+
+                Writer << WarmUp;
+            }
+        }
+
+        return Content;
+    }
+
+    static bool PublishClientVersion(const FString& OutputDir, const FString& Version, const FString& ClientVersion,
+                                     const FString& Platform, TArray<FPublishedPak>& Paks,
+                                     const int32 MaxDeltaSources, FPublishStats& Stats)
+    {
+        const auto& PointerDir = FPaths::Combine(OutputDir, ClientVersion, Platform);
+
+        const auto& PointerPath = FPaths::Combine(PointerDir, TEXT("pointer.json"));
+
+        TSharedPtr<FJsonObject> Manifest;
+
+        FString PreviousManifest;
+
+        const auto Pointer = LoadJson(PointerPath);
+
+        if (Pointer.IsValid() && Pointer->TryGetStringField(TEXT("Manifest"), PreviousManifest))
+        {
+            Manifest = LoadJson(FPaths::Combine(OutputDir, PreviousManifest));
+
+            if (!Manifest.IsValid())
+            {
+                UE_LOG(LogHotUpdateEditor, Error, TEXT("Failed to load previous manifest %s"), *PreviousManifest);
+
+                return false;
+            }
+        }
+
+        if (!Manifest.IsValid())
+        {
+            Manifest = MakeShared<FJsonObject>();
+        }
+
+        const auto& PreviousPaks = CollectPreviousPaks(Manifest);
+
+        TArray<TSharedPtr<FJsonValue>> Entries;
+
+        for (auto& Pak : Paks)
+        {
+            Pak.Deltas.Reset();
+
+            if (const auto Previous = PreviousPaks.Find(Pak.File))
+            {
+                auto SourceNum = 0;
+
+                for (const auto& PreviousPak : *Previous)
+                {
+                    if (SourceNum >= MaxDeltaSources)
+                    {
+                        break;
+                    }
+
+                    if (PreviousPak.BlockSize != Pak.BlockSize ||
+                        PreviousPak.Hash.Equals(Pak.Hash, ESearchCase::IgnoreCase))
+                    {
+                        continue;
+                    }
+
+                    SourceNum++;
+
+                    WriteDelta(OutputDir, Pak, PreviousPak, Stats);
+                }
+            }
+
+            Entries.Add(MakeShared<FJsonValueObject>(ToJson(Pak)));
+        }
+
+        Manifest->SetArrayField(Version, Entries);
+
+        const auto& ManifestStr = ToJsonString(Manifest.ToSharedRef());
+
+        const FTCHARToUTF8 ManifestUTF8(*ManifestStr);
+
+        FMD5 Md5;
+
+        Md5.Update(reinterpret_cast<const uint8*>(ManifestUTF8.Get()), ManifestUTF8.Length());
+
+        const auto& ManifestHash = ToHex(Md5).ToLower();
+
+        const auto& JsonUrl = FString::Printf(TEXT("manifests/%s.json"), *ManifestHash);
+
+        const auto& BinaryUrl = FString::Printf(TEXT("manifests/%s.bin"), *ManifestHash);
+
+        if (!SaveAtomically(ManifestStr, FPaths::Combine(OutputDir, JsonUrl)) ||
+            !SaveArrayAtomically(ToBinaryManifest(*Manifest), FPaths::Combine(OutputDir, BinaryUrl)) ||
+            !SaveAtomically(ManifestStr, FPaths::Combine(PointerDir, TEXT("version.json"))))
+        {
+            UE_LOG(LogHotUpdateEditor, Error, TEXT("Failed to write manifest %s"), *JsonUrl);
+
+            return false;
+        }
+
+        const auto NewPointer = MakeShared<FJsonObject>();
+
+        NewPointer->SetStringField(TEXT("Version"), Version);
+
+        NewPointer->SetStringField(TEXT("Manifest"), JsonUrl);
+
+        NewPointer->SetStringField(TEXT("BinaryManifest"), BinaryUrl);
+
+        NewPointer->SetStringField(TEXT("Hash"), ManifestHash);
+
+        NewPointer->SetNumberField(TEXT("Size"), ManifestUTF8.Length());
+
+        NewPointer->SetStringField(TEXT("Time"), FDateTime::UtcNow().ToIso8601());
+
+        // Written last, clients only ever see a pointer to a manifest whose files are all in place
+        if (!SaveAtomically(ToJsonString(NewPointer), PointerPath))
+        {
+            UE_LOG(LogHotUpdateEditor, Error, TEXT("Failed to write pointer %s"), *PointerPath);
+
+            return false;
+        }
+
+        UE_LOG(LogHotUpdateEditor, Display, TEXT("%s/%s -> %s"), *ClientVersion, *Platform, *JsonUrl);
+
+        return true;
+    }
+}
+
+UHotUpdatePublishCommandlet::UHotUpdatePublishCommandlet()
+{
+    IsClient = false;
+
+    IsServer = false;
+
+    IsEditor = true;
+
+    LogToConsole = true;
+}
+
+int32 UHotUpdatePublishCommandlet::Main(const FString& Params)
+{
+    FString PaksDir;
+
+    FString OutputDir;
+
+    FString Version;
+
+    FString ClientVersionList;
+
+    FString Platform;
+
+    auto BlockSize = HotUpdatePublish::DefaultBlockSize;
+
+    auto MaxDeltaSources = 3;
+
+    if (!FParse::Value(*Params, TEXT("Paks="), PaksDir) || !FParse::Value(*Params, TEXT("Output="), OutputDir) ||
+        !FParse::Value(*Params, TEXT("Version="), Version) ||
+        !FParse::Value(*Params, TEXT("ClientVersions="), ClientVersionList) ||
+        !FParse::Value(*Params, TEXT("Platform="), Platform))
+    {
+        UE_LOG(LogHotUpdateEditor, Error, TEXT("Usage: -run=HotUpdatePublish -Paks=<Dir> -Output=<Dir> ")
+               TEXT("-Version=<PatchVersion> -ClientVersions=<Version>+<Version> -Platform=<Platform> ")
+               TEXT("[-BlockSize=<Bytes>] [-MaxDeltaSources=<Num>] [-Tags=<File>] [-NoCache]"));
+
+        return 1;
+    }
+
+    FParse::Value(*Params, TEXT("BlockSize="), BlockSize);
+
+    FParse::Value(*Params, TEXT("MaxDeltaSources="), MaxDeltaSources);
+
+    BlockSize = FMath::Max(BlockSize, 4 * 1024);
+
+    TArray<FString> ClientVersions;
+
+    ClientVersionList.ParseIntoArray(ClientVersions, TEXT("+"));
+
+    TArray<FString> PakNames;
+
+    IFileManager::Get().FindFiles(PakNames, *FPaths::Combine(PaksDir, TEXT("*.pak")), true, false);
+
+    PakNames.Sort();
+
+    if (PakNames.Num() <= 0 || ClientVersions.Num() <= 0)
+    {
+        UE_LOG(LogHotUpdateEditor, Error, TEXT("No paks in %s or no client versions"), *PaksDir);
+
+        return 1;
+    }
+
+    HotUpdatePublish::FPublishStats Stats;
+
+    TArray<FString> PakPaths;
+
+    for (const auto& PakName : PakNames)
+    {
+        PakPaths.Add(FPaths::Combine(PaksDir, PakName));
+    }
+
+    FPakHasher Hasher(BlockSize);
+
+    Hasher.LoadCache(FParse::Param(*Params, TEXT("NoCache")) ? FString() : FPakHasher::GetDefaultCachePath());
+
+    TArray<FManifestEntry> Entries;
+
+    const auto bIsHashed = Hasher.HashFiles(PakPaths, Entries);
+
+    Hasher.SaveCache();
+
+    if (!bIsHashed)
+    {
+        return 1;
+    }
+
+    FPakTagRules TagRules;
+
+    FString TagsPath;
+
+    if (FParse::Value(*Params, TEXT("Tags="), TagsPath) && !TagRules.Load(TagsPath))
+    {
+        return 1;
+    }
+
+    TArray<HotUpdatePublish::FPublishedPak> Paks;
+
+    for (auto i = 0; i < Entries.Num(); ++i)
+    {
+        HotUpdatePublish::FPublishedPak Pak;
+
+        static_cast<FManifestEntry&>(Pak) = Entries[i];
+
+        TagRules.Apply(Pak);
+
+        Pak.SourcePath = PakPaths[i];
+
+        Pak.Url = HotUpdatePublish::GetShardedPath(TEXT("paks"), Pak.Hash, TEXT(".pak"));
+
+        const auto& PakPath = FPaths::Combine(OutputDir, Pak.Url);
+
+        const auto bIsNew = !IFileManager::Get().FileExists(*PakPath);
+
+        if (!HotUpdatePublish::CopyImmutable(Pak.SourcePath, PakPath))
+        {
+            UE_LOG(LogHotUpdateEditor, Error, TEXT("Failed to copy %s to %s"), *Pak.SourcePath, *PakPath);
+
+            return 1;
+        }
+
+        if (bIsNew)
+        {
+            Stats.NewPaks++;
+
+            Stats.NewBytes += Pak.Size;
+        }
+
+        const auto& BlocksPath = FPaths::Combine(
+            OutputDir, HotUpdatePublish::GetShardedPath(TEXT("blocks"), Pak.Hash, TEXT(".json")));
+
+        if (!IFileManager::Get().FileExists(*BlocksPath) &&
+            !HotUpdatePublish::SaveAtomically(HotUpdatePublish::ToJsonString(HotUpdatePublish::ToJson(Pak)),
+                                              BlocksPath))
+        {
+            UE_LOG(LogHotUpdateEditor, Error, TEXT("Failed to write %s"), *BlocksPath);
+
+            return 1;
+        }
+
+        UE_LOG(LogHotUpdateEditor, Display, TEXT("%s %s %lld bytes%s"), *Pak.File, *Pak.Hash, Pak.Size,
+               bIsNew ? TEXT("") : TEXT(", already published"));
+
+        Paks.Add(MoveTemp(Pak));
+    }
+
+    for (const auto& ClientVersion : ClientVersions)
+    {
+        if (!HotUpdatePublish::PublishClientVersion(OutputDir, Version, ClientVersion, Platform, Paks,
+                                                    MaxDeltaSources, Stats))
+        {
+            return 1;
+        }
+    }
+
+    UE_LOG(LogHotUpdateEditor, Display, TEXT("Published %d paks, %d new (%lld bytes), %d deltas (%lld bytes)"),
+           Paks.Num(), Stats.NewPaks, Stats.NewBytes, Stats.Deltas, Stats.DeltaBytes);
+
+    return 0;
+}
@@ -0,0 +1,287 @@
+#include "PakHasher.h"
+#include "HotUpdateEditor.h"
+#include "PakVerifier.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace PakHasher
+{
+    /** Reads are rounded down to whole blocks, large enough that the disk and not the syscalls sets the pace */
+    static const int64 ReadSize = 8 * 1024 * 1024;
+
+    static FString ToHex(FMD5& Md5)
+    {
+        uint8 Digest[16];
+
+        Md5.Final(Digest);
+
+        return BytesToHex(Digest, sizeof(Digest));
+    }
+}
+
+FPakHasher::FPakHasher(const int32 InBlockSize) : BlockSize(FMath::Max(InBlockSize, 0))
+{
+}
+
+void FPakHasher::LoadCache(const FString& InCachePath)
+{
+    CachePath = InCachePath;
+
+    Records.Empty();
+
+    FString JsonStr;
+
+    TSharedPtr<FJsonObject> JsonObject;
+
+    if (CachePath.IsEmpty() || !FFileHelper::LoadFileToString(JsonStr, *CachePath))
+    {
+        return;
+    }
+
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonStr), JsonObject) || !JsonObject.IsValid())
+    {
+        UE_LOG(LogHotUpdateEditor, Warning, TEXT("Failed to read hash cache: %s"), *CachePath);
+
+        return;
+    }
+
+    for (const auto& Pak : JsonObject->Values)
+    {
+        const auto& PakObject = Pak.Value->AsObject();
+
+        if (!PakObject.IsValid())
+        {
+            continue;
+        }
+
+        FPakHashRecord Record;
+
+        Record.Size = FCString::Atoi64(*PakObject->GetStringField(TEXT("Size")));
+
+        Record.TimeStamp = FCString::Atoi64(*PakObject->GetStringField(TEXT("TimeStamp")));
+
+        Record.Entry.File = FPaths::GetCleanFilename(Pak.Key);
+
+        Record.Entry.Hash = PakObject->GetStringField(TEXT("Hash"));
+
+        Record.Entry.Size = Record.Size;
+
+        Record.Entry.IndexHash = PakObject->GetStringField(TEXT("IndexHash"));
+
+        Record.Entry.BlockSize = static_cast<int32>(PakObject->GetNumberField(TEXT("BlockSize")));
+
+        PakObject->TryGetStringArrayField(TEXT("Blocks"), Record.Entry.Blocks);
+
+        Records.Add(Pak.Key, MoveTemp(Record));
+    }
+}
+
+void FPakHasher::SaveCache() const
+{
+    if (CachePath.IsEmpty())
+    {
+        return;
+    }
+
+    FString JsonStr;
+
+    auto JsonWriter = TJsonWriterFactory<>::Create(&JsonStr);
+
+    JsonWriter->WriteObjectStart();
+
+    for (const auto& Record : Records)
+    {
+        JsonWriter->WriteObjectStart(Record.Key);
+
+        JsonWriter->WriteValue(TEXT("Size"), FString::Printf(TEXT("%lld"), Record.Value.Size));
+
+        JsonWriter->WriteValue(TEXT("TimeStamp"), FString::Printf(TEXT("%lld"), Record.Value.TimeStamp));
+
+        JsonWriter->WriteValue(TEXT("Hash"), Record.Value.Entry.Hash);
+
+        JsonWriter->WriteValue(TEXT("IndexHash"), Record.Value.Entry.IndexHash);
+
+        JsonWriter->WriteValue(TEXT("BlockSize"), Record.Value.Entry.BlockSize);
+
+        JsonWriter->WriteArrayStart(TEXT("Blocks"));
+
+        for (const auto& Block : Record.Value.Entry.Blocks)
+        {
+            JsonWriter->WriteValue(Block);
+        }
+
+        JsonWriter->WriteArrayEnd();
+
+        JsonWriter->WriteObjectEnd();
+    }
+
+    JsonWriter->WriteObjectEnd();
+
+    JsonWriter->Close();
+
+    if (!FFileHelper::SaveStringToFile(JsonStr, *CachePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+    {
+        UE_LOG(LogHotUpdateEditor, Warning, TEXT("Failed to write hash cache: %s"), *CachePath);
+    }
+}
+
+bool FPakHasher::HashFiles(const TArray<FString>& Paths, TArray<FManifestEntry>& OutEntries)
+{
+    const auto Num = Paths.Num();
+
+    TArray<FString> FullPaths;
+
+    TArray<FPakHashRecord> Results;
+
+    TArray<uint8> States;
+
+    FullPaths.SetNum(Num);
+
+    Results.SetNum(Num);
+
+    // 0 failed, 1 hashed, 2 taken from the cache
+    States.SetNumZeroed(Num);
+
+    for (auto i = 0; i < Num; ++i)
+    {
+        FullPaths[i] = FPaths::ConvertRelativePathToFull(Paths[i]);
+    }
+
+    // The cache is only read here and written back once every worker is done
+    ParallelFor(Num, [&](const int32 Index)
+    {
+        const auto& Path = FullPaths[Index];
+
+        auto& Result = Results[Index];
+
+        Result.Size = IFileManager::Get().FileSize(*Path);
+
+        Result.TimeStamp = IFileManager::Get().GetTimeStamp(*Path).GetTicks();
+
+        const auto Record = Records.Find(Path);
+
+        if (Record != nullptr && Record->Size == Result.Size && Record->TimeStamp == Result.TimeStamp &&
+            Record->Entry.BlockSize == BlockSize)
+        {
+            Result.Entry = Record->Entry;
+
+            States[Index] = 2;
+
+            return;
+        }
+
+        if (HashFile(Path, BlockSize, Result.Entry))
+        {
+            States[Index] = 1;
+        }
+    });
+
+    OutEntries.Reset(Num);
+
+    auto bIsSuccess = true;
+
+    for (auto i = 0; i < Num; ++i)
+    {
+        if (States[i] == 0)
+        {
+            UE_LOG(LogHotUpdateEditor, Error, TEXT("Failed to hash %s"), *FullPaths[i]);
+
+            Records.Remove(FullPaths[i]);
+
+            bIsSuccess = false;
+
+            continue;
+        }
+
+        if (States[i] == 1)
+        {
+            HashedBytes += Results[i].Size;
+        }
+        else
+        {
+            CacheHits++;
+        }
+
+        Results[i].Entry.File = FPaths::GetCleanFilename(FullPaths[i]);
+
+        OutEntries.Add(Results[i].Entry);
+
+        Records.Add(FullPaths[i], MoveTemp(Results[i]));
+    }
+
+    return bIsSuccess;
+}
+
+bool FPakHasher::HashFile(const FString& Path, const int32 BlockSize, FManifestEntry& OutEntry)
+{
+    const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Path));
+
+    if (!Reader.IsValid())
+    {
+        return false;
+    }
+
+    OutEntry.File = FPaths::GetCleanFilename(Path);
+
+    OutEntry.Size = Reader->TotalSize();
+
+    OutEntry.BlockSize = BlockSize;
+
+    OutEntry.Blocks.Reset();
+
+    OutEntry.IndexHash.Reset();
+
+    const auto ChunkSize = BlockSize > 0
+                               ? FMath::Max<int64>(PakHasher::ReadSize / BlockSize, 1) * BlockSize
+                               : PakHasher::ReadSize;
+
+    TArray<uint8> Buffer;
+
+    Buffer.SetNumUninitialized(ChunkSize);
+
+    FMD5 FileMd5;
+
+    for (int64 Offset = 0; Offset < OutEntry.Size; Offset += ChunkSize)
+    {
+        const auto Size = FMath::Min<int64>(ChunkSize, OutEntry.Size - Offset);
+
+        Reader->Serialize(Buffer.GetData(), Size);
+
+        if (Reader->IsError())
+        {
+            return false;
+        }
+
+        FileMd5.Update(Buffer.GetData(), Size);
+
+        for (int64 BlockOffset = 0; BlockSize > 0 && BlockOffset < Size; BlockOffset += BlockSize)
+        {
+            FMD5 BlockMd5;
+
+            BlockMd5.Update(Buffer.GetData() + BlockOffset, FMath::Min<int64>(BlockSize, Size - BlockOffset));
+
+            OutEntry.Blocks.Add(PakHasher::ToHex(BlockMd5));
+        }
+    }
+
+    // Lower case like the hashes in hand written manifests, the client compares them case insensitively
+    OutEntry.Hash = PakHasher::ToHex(FileMd5).ToLower();
+
+    int64 IndexOffset = 0;
+
+    if (FPakVerifier::ReadIndexOffset(*Reader, IndexOffset))
+    {
+        OutEntry.IndexHash = FPakVerifier::HashRange(*Reader, IndexOffset, OutEntry.Size - IndexOffset);
+    }
+
+    return true;
+}
+
+FString FPakHasher::GetDefaultCachePath()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HotUpdate"), TEXT("HashCache.json"));
+}
@@ -0,0 +1,65 @@
+#include "PakTagRules.h"
+#include "HotUpdateEditor.h"
+#include "Misc/FileHelper.h"
+
+bool FPakTagRules::Load(const FString& Path)
+{
+    TArray<FString> Lines;
+
+    if (!FFileHelper::LoadFileToStringArray(Lines, *Path))
+    {
+        UE_LOG(LogHotUpdateEditor, Error, TEXT("Failed to read tag rules %s"), *Path);
+
+        return false;
+    }
+
+    for (const auto& Line : Lines)
+    {
+        TArray<FString> Tokens;
+
+        Line.TrimStartAndEnd().ParseIntoArrayWS(Tokens);
+
+        if (Tokens.Num() < 2 || Tokens[0].StartsWith(TEXT("#")))
+        {
+            continue;
+        }
+
+        const auto Wildcard = Tokens[0].TrimQuotes();
+
+        Tokens.RemoveAt(0);
+
+        Rules.Emplace(Wildcard, MoveTemp(Tokens));
+    }
+
+    return true;
+}
+
+void FPakTagRules::Apply(FManifestEntry& Entry) const
+{
+    for (const auto& Rule : Rules)
+    {
+        if (!Entry.File.MatchesWildcard(Rule.Key))
+        {
+            continue;
+        }
+
+        for (const auto& Tag : Rule.Value)
+        {
+            if (Tag.StartsWith(TEXT("ondemand=")))
+            {
+                Entry.OnDemand = Tag.RightChop(9);
+
+                continue;
+            }
+
+            if (Tag.StartsWith(TEXT("warmup=")))
+            {
+                Entry.WarmUp.AddUnique(Tag.RightChop(7));
+
+                continue;
+            }
+
+            Entry.Tags.AddUnique(Tag);
+        }
+    }
+}
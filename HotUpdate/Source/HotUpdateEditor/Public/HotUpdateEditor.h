@@ -0,0 +1,13 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogHotUpdateEditor, Log, All);
+
+/** Build pipeline side of HotUpdate, hosts the publish commandlet */
+class FHotUpdateEditorModule : public IModuleInterface
+{
+};
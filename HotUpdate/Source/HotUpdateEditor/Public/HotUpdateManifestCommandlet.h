@@ -0,0 +1,24 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "HotUpdateManifestCommandlet.generated.h"
+
+/**
+ * Adds the paks of a directory to version.json as one patch version, keeping the versions already in the file.
+ * Entries are written in mount order, paks named in the order file first and the rest by name. Without -BlockSize
+ * only File, HASH, Size and IndexHash are written. -Tags names a FPakTagRules file.
+ *
+ * UE4Editor-Cmd <Project> -run=HotUpdateManifest -Paks=<Dir> -Output=<Dir>/version.json -Version=<PatchVersion>
+ *     [-BlockSize=<Bytes>] [-Order=<File>] [-Tags=<File>] [-NoCache]
+ */
+UCLASS()
+class UHotUpdateManifestCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UHotUpdateManifestCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
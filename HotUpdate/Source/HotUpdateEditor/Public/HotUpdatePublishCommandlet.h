@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "HotUpdatePublishCommandlet.generated.h"
+
+/**
+ * Writes a directory of cooked paks into a content addressed publish tree. Everything but the pointer is immutable
+ * and can be cached at the edge forever:
+ *
+ *   paks/<ab>/<Hash>.pak                       the pak, named by its MD5
+ *   blocks/<ab>/<Hash>.json                    block hash table for the verify tiers and block repair
+ *   deltas/<FromHash>/<ToHash>.delta           changed blocks against an earlier pak of the same name
+ *   manifests/<Hash>.json, manifests/<Hash>.bin   manifest of one client version, named by the MD5 of its json
+ *   <ClientVersion>/<Platform>/pointer.json    names the current manifest, the only file that is rewritten
+ *
+ * A copy of the manifest is also written to <ClientVersion>/<Platform>/version.json for servers that take the POST.
+ *
+ * UE4Editor-Cmd <Project> -run=HotUpdatePublish -Paks=<Dir> -Output=<Dir> -Version=<PatchVersion>
+ *     -ClientVersions=<Version>+<Version> -Platform=<Platform> [-BlockSize=<Bytes>] [-MaxDeltaSources=<Num>]
+ *     [-Tags=<File>] [-NoCache]
+ */
+UCLASS()
+class UHotUpdatePublishCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UHotUpdatePublishCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
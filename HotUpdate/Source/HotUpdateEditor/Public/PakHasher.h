@@ -0,0 +1,56 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "ManifestParser.h"
+
+struct FPakHashRecord
+{
+    int64 Size = 0;
+
+    int64 TimeStamp = 0;
+
+    FManifestEntry Entry;
+};
+
+/**
+ * Hashes paks for manifests, one file per worker with large sequential reads. Each pass gives the file MD5, the
+ * uppercase MD5 of every BlockSize bytes when BlockSize is not 0 and the index hash of the verify tiers. Results are
+ * kept in a cache keyed by full path, size and modify time so unchanged paks are not read again.
+ */
+class FPakHasher
+{
+public:
+    explicit FPakHasher(int32 InBlockSize);
+
+    /** Empty path keeps the cache in memory only */
+    void LoadCache(const FString& InCachePath);
+
+    void SaveCache() const;
+
+    /** OutEntries matches Paths by index, File is the clean file name */
+    bool HashFiles(const TArray<FString>& Paths, TArray<FManifestEntry>& OutEntries);
+
+    static bool HashFile(const FString& Path, int32 BlockSize, FManifestEntry& OutEntry);
+
+    static FString GetDefaultCachePath();
+
+    int32 GetCacheHits() const
+    {
+        return CacheHits;
+    }
+
+    int64 GetHashedBytes() const
+    {
+        return HashedBytes;
+    }
+
+private:
+    int32 BlockSize = 0;
+
+    FString CachePath;
+
+    TMap<FString, FPakHashRecord> Records;
+
+    int32 CacheHits = 0;
+
+    int64 HashedBytes = 0;
+};
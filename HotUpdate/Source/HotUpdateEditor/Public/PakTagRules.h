@@ -0,0 +1,26 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "ManifestParser.h"
+
+/**
+ * Manifest tags by pak name, read from a text file with one rule per line: a wildcard followed by its tags, such as
+ *
+ *   *_Voice_en_*.pak   lang:en
+ *   *_4K_*.pak         quality:high optional
+ *   *_Cosmetics_*.pak  ondemand=/Game/Cosmetics/
+ *   *_Maps_*.pak       warmup=/Game/Maps/Arena warmup=/Game/Maps/Arena_Audio
+ *
+ * A pak takes the tags of every rule it matches, ondemand=<ContentPath> marks it as installed on first use of that
+ * content instead of with the update, warmup=<PackageName> lists the packages loaded after the update patched it in
+ * rule order. Lines starting with # are comments.
+ */
+class FPakTagRules
+{
+public:
+    bool Load(const FString& Path);
+
+    void Apply(FManifestEntry& Entry) const;
+
+private:
+    TArray<TPair<FString, TArray<FString>>> Rules;
+};
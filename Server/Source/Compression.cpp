@@ -0,0 +1,34 @@
+#include "Compression.h"
+#include <zlib.h>
+
+namespace Compression
+{
+    bool Gzip(const std::string& Source, std::string& OutCompressed)
+    {
+        z_stream Stream{};
+
+        // 15 window bits plus 16 asks zlib for the gzip header and trailer
+        if (deflateInit2(&Stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return false;
+        }
+
+        OutCompressed.resize(deflateBound(&Stream, static_cast<uLong>(Source.size())));
+
+        Stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(Source.data()));
+
+        Stream.avail_in = static_cast<uInt>(Source.size());
+
+        Stream.next_out = reinterpret_cast<Bytef*>(&OutCompressed[0]);
+
+        Stream.avail_out = static_cast<uInt>(OutCompressed.size());
+
+        const auto Result = deflate(&Stream, Z_FINISH);
+
+        OutCompressed.resize(Stream.total_out);
+
+        deflateEnd(&Stream);
+
+        return Result == Z_STREAM_END;
+    }
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <string>
+
+namespace Compression
+{
+    /** Gzip framing so Content-Encoding: gzip can be used as is, fails only when zlib does */
+    bool Gzip(const std::string& Source, std::string& OutCompressed);
+}
@@ -0,0 +1,428 @@
+#include "HttpHeaders.h"
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace HttpHeaders
+{
+    /** More ranges than this in one request are answered with the whole file */
+    static constexpr size_t MaxRanges = 32;
+
+    static bool ParseInteger(const std::string& Value, int64_t& OutValue)
+    {
+        if (Value.empty() || Value.size() > 18)
+        {
+            return false;
+        }
+
+        OutValue = 0;
+
+        for (const auto Char : Value)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(Char)))
+            {
+                return false;
+            }
+
+            OutValue = OutValue * 10 + (Char - '0');
+        }
+
+        return true;
+    }
+
+    static std::vector<std::string> Split(const std::string& Value, const char Separator, const bool bTrim = true)
+    {
+        std::vector<std::string> Parts;
+
+        size_t Start = 0;
+
+        while (true)
+        {
+            const auto End = Value.find(Separator, Start);
+
+            const auto& Part = Value.substr(Start, End == std::string::npos ? std::string::npos : End - Start);
+
+            Parts.push_back(bTrim ? Trim(Part) : Part);
+
+            if (End == std::string::npos)
+            {
+                return Parts;
+            }
+
+            Start = End + 1;
+        }
+    }
+
+    static int HexValue(const char Char)
+    {
+        if (Char >= '0' && Char <= '9')
+        {
+            return Char - '0';
+        }
+
+        if (Char >= 'a' && Char <= 'f')
+        {
+            return Char - 'a' + 10;
+        }
+
+        if (Char >= 'A' && Char <= 'F')
+        {
+            return Char - 'A' + 10;
+        }
+
+        return -1;
+    }
+
+    ERangeResult ParseRange(const std::string& Value, const int64_t FileSize, std::vector<FByteRange>& OutRanges)
+    {
+        OutRanges.clear();
+
+        const auto Trimmed = Trim(Value);
+
+        if (Trimmed.size() < 6 || !EqualsIgnoreCase(Trimmed.substr(0, 6), "bytes="))
+        {
+            return ERangeResult::None;
+        }
+
+        const auto& Specs = Split(Trimmed.substr(6), ',');
+
+        if (Specs.size() > MaxRanges)
+        {
+            return ERangeResult::None;
+        }
+
+        size_t SpecNum = 0;
+
+        for (const auto& Spec : Specs)
+        {
+            if (Spec.empty())
+            {
+                continue;
+            }
+
+            ++SpecNum;
+
+            const auto Dash = Spec.find('-');
+
+            if (Dash == std::string::npos)
+            {
+                return ERangeResult::None;
+            }
+
+            const auto& First = Spec.substr(0, Dash);
+
+            const auto& Last = Spec.substr(Dash + 1);
+
+            int64_t Start = 0;
+
+            int64_t End = 0;
+
+            if (First.empty())
+            {
+                // Suffix range, the last N bytes
+                if (!ParseInteger(Last, End))
+                {
+                    return ERangeResult::None;
+                }
+
+                if (End > 0 && FileSize > 0)
+                {
+                    OutRanges.push_back({std::max<int64_t>(FileSize - End, 0), std::min(End, FileSize)});
+                }
+
+                continue;
+            }
+
+            if (!ParseInteger(First, Start))
+            {
+                return ERangeResult::None;
+            }
+
+            if (Last.empty())
+            {
+                End = FileSize - 1;
+            }
+            else if (!ParseInteger(Last, End) || End < Start)
+            {
+                return ERangeResult::None;
+            }
+
+            if (Start < FileSize)
+            {
+                End = std::min(End, FileSize - 1);
+
+                OutRanges.push_back({Start, End - Start + 1});
+            }
+        }
+
+        if (OutRanges.empty())
+        {
+            return SpecNum == 0 ? ERangeResult::None : ERangeResult::Unsatisfiable;
+        }
+
+        // Overlapping ranges would let a client multiply the bytes sent for one request
+        std::sort(OutRanges.begin(), OutRanges.end(), [](const FByteRange& Left, const FByteRange& Right)
+        {
+            return Left.Offset < Right.Offset;
+        });
+
+        std::vector<FByteRange> Merged;
+
+        for (const auto& Range : OutRanges)
+        {
+            if (!Merged.empty() && Range.Offset <= Merged.back().Offset + Merged.back().Size)
+            {
+                Merged.back().Size = std::max(Merged.back().Offset + Merged.back().Size,
+                                              Range.Offset + Range.Size) - Merged.back().Offset;
+            }
+            else
+            {
+                Merged.push_back(Range);
+            }
+        }
+
+        OutRanges.swap(Merged);
+
+        return ERangeResult::Satisfiable;
+    }
+
+    bool MatchIfRange(const std::string& Value, const std::string& ETag, const std::string& LastModified)
+    {
+        const auto& Trimmed = Trim(Value);
+
+        if (Trimmed.empty() || Trimmed.compare(0, 2, "W/") == 0)
+        {
+            return false;
+        }
+
+        if (Trimmed[0] == '"')
+        {
+            return Trimmed == ETag;
+        }
+
+        return Trimmed == LastModified;
+    }
+
+    bool MatchIfNoneMatch(const std::string& Value, const std::string& ETag)
+    {
+        for (auto Tag : Split(Value, ','))
+        {
+            if (Tag == "*")
+            {
+                return true;
+            }
+
+            if (Tag.compare(0, 2, "W/") == 0)
+            {
+                Tag = Tag.substr(2);
+            }
+
+            if (Tag == ETag)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool AcceptsGzip(const std::string& Value)
+    {
+        auto bAcceptsAny = false;
+
+        for (const auto& Coding : Split(Value, ','))
+        {
+            const auto& Parameters = Split(Coding, ';');
+
+            auto Quality = 1.0;
+
+            for (size_t i = 1; i < Parameters.size(); ++i)
+            {
+                if (Parameters[i].size() > 2 && (Parameters[i][0] == 'q' || Parameters[i][0] == 'Q') &&
+                    Parameters[i][1] == '=')
+                {
+                    Quality = std::atof(Parameters[i].c_str() + 2);
+                }
+            }
+
+            if (EqualsIgnoreCase(Parameters[0], "gzip") || EqualsIgnoreCase(Parameters[0], "x-gzip"))
+            {
+                return Quality > 0.0;
+            }
+
+            if (Parameters[0] == "*")
+            {
+                bAcceptsAny = Quality > 0.0;
+            }
+        }
+
+        return bAcceptsAny;
+    }
+
+    std::string MakeETag(const struct stat& Stat)
+    {
+        char Buffer[64];
+
+        const auto ModifyTime = static_cast<int64_t>(Stat.st_mtim.tv_sec) * 1000000000 + Stat.st_mtim.tv_nsec;
+
+        std::snprintf(Buffer, sizeof(Buffer), "\"%" PRIx64 "-%" PRIx64 "\"", static_cast<uint64_t>(Stat.st_size),
+                      static_cast<uint64_t>(ModifyTime));
+
+        return Buffer;
+    }
+
+    std::string FormatHttpDate(const time_t Time)
+    {
+        struct tm Tm{};
+
+        gmtime_r(&Time, &Tm);
+
+        char Buffer[64];
+
+        std::strftime(Buffer, sizeof(Buffer), "%a, %d %b %Y %H:%M:%S GMT", &Tm);
+
+        return Buffer;
+    }
+
+    const char* GetMimeType(const std::string& Path)
+    {
+        const auto Dot = Path.rfind('.');
+
+        const auto& Extension = Dot == std::string::npos ? std::string() : Path.substr(Dot + 1);
+
+        if (EqualsIgnoreCase(Extension, "json"))
+        {
+            return "application/json; charset=utf-8";
+        }
+
+        if (EqualsIgnoreCase(Extension, "txt") || EqualsIgnoreCase(Extension, "log"))
+        {
+            return "text/plain; charset=utf-8";
+        }
+
+        if (EqualsIgnoreCase(Extension, "html") || EqualsIgnoreCase(Extension, "htm"))
+        {
+            return "text/html; charset=utf-8";
+        }
+
+        return "application/octet-stream";
+    }
+
+    const char* GetReasonPhrase(const int32_t Status)
+    {
+        switch (Status)
+        {
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 411: return "Length Required";
+        case 413: return "Payload Too Large";
+        case 416: return "Range Not Satisfiable";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 505: return "HTTP Version Not Supported";
+        default: return "Unknown";
+        }
+    }
+
+    bool DecodeTargetPath(const std::string& Target, std::string& OutPath)
+    {
+        auto Path = Target.substr(0, Target.find_first_of("?#"));
+
+        // Absolute form, http://host/path
+        if (Path.compare(0, 7, "http://") == 0 || Path.compare(0, 8, "https://") == 0)
+        {
+            const auto Slash = Path.find('/', Path.find("//") + 2);
+
+            Path = Slash == std::string::npos ? "/" : Path.substr(Slash);
+        }
+
+        if (Path.empty() || Path[0] != '/')
+        {
+            return false;
+        }
+
+        std::string Decoded;
+
+        Decoded.reserve(Path.size());
+
+        for (size_t i = 0; i < Path.size(); ++i)
+        {
+            if (Path[i] != '%')
+            {
+                Decoded.push_back(Path[i]);
+
+                continue;
+            }
+
+            if (i + 2 >= Path.size() || HexValue(Path[i + 1]) < 0 || HexValue(Path[i + 2]) < 0)
+            {
+                return false;
+            }
+
+            const auto Char = static_cast<char>(HexValue(Path[i + 1]) * 16 + HexValue(Path[i + 2]));
+
+            if (Char == '\0')
+            {
+                return false;
+            }
+
+            Decoded.push_back(Char);
+
+            i += 2;
+        }
+
+        OutPath.clear();
+
+        for (const auto& Segment : Split(Decoded, '/', false))
+        {
+            if (Segment.empty() || Segment == ".")
+            {
+                continue;
+            }
+
+            if (Segment == ".." || Segment.find('\\') != std::string::npos)
+            {
+                return false;
+            }
+
+            if (!OutPath.empty())
+            {
+                OutPath.push_back('/');
+            }
+
+            OutPath += Segment;
+        }
+
+        return true;
+    }
+
+    bool EqualsIgnoreCase(const std::string& Left, const char* Right)
+    {
+        const auto Length = std::strlen(Right);
+
+        return Left.size() == Length && strncasecmp(Left.c_str(), Right, Length) == 0;
+    }
+
+    std::string Trim(const std::string& Value)
+    {
+        const auto Start = Value.find_first_not_of(" \t");
+
+        if (Start == std::string::npos)
+        {
+            return std::string();
+        }
+
+        return Value.substr(Start, Value.find_last_not_of(" \t") - Start + 1);
+    }
+}
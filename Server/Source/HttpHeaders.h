@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+struct FByteRange
+{
+    int64_t Offset = 0;
+
+    int64_t Size = 0;
+};
+
+enum class ERangeResult
+{
+    /** No usable Range header, the whole file is sent */
+    None,
+    Satisfiable,
+    Unsatisfiable
+};
+
+namespace HttpHeaders
+{
+    /** Parses "bytes=a-b,c-,-n" against FileSize, overlapping ranges are merged in ascending order */
+    ERangeResult ParseRange(const std::string& Value, int64_t FileSize, std::vector<FByteRange>& OutRanges);
+
+    /** If-Range holds either a strong etag or the exact Last-Modified date of the representation */
+    bool MatchIfRange(const std::string& Value, const std::string& ETag, const std::string& LastModified);
+
+    /** If-None-Match uses the weak comparison, "*" matches any current representation */
+    bool MatchIfNoneMatch(const std::string& Value, const std::string& ETag);
+
+    /** True when the client takes gzip, "gzip;q=0" and "identity" only do not count */
+    bool AcceptsGzip(const std::string& Value);
+
+    std::string MakeETag(const struct stat& Stat);
+
+    std::string FormatHttpDate(time_t Time);
+
+    const char* GetMimeType(const std::string& Path);
+
+    const char* GetReasonPhrase(int32_t Status);
+
+    /** Decodes the path part of a request target into a relative path, fails on "..", NUL or a bad escape */
+    bool DecodeTargetPath(const std::string& Target, std::string& OutPath);
+
+    bool EqualsIgnoreCase(const std::string& Left, const char* Right);
+
+    std::string Trim(const std::string& Value);
+}
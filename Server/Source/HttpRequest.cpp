@@ -0,0 +1,180 @@
+#include "HttpRequest.h"
+#include "HttpHeaders.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+const std::string* FHttpRequest::FindHeader(const char* Name) const
+{
+    for (const auto& Header : Headers)
+    {
+        if (Header.first == Name)
+        {
+            return &Header.second;
+        }
+    }
+
+    return nullptr;
+}
+
+namespace HttpRequest
+{
+    static bool ParseRequestLine(const std::string& Line, FHttpRequest& OutRequest)
+    {
+        const auto FirstSpace = Line.find(' ');
+
+        const auto LastSpace = Line.rfind(' ');
+
+        if (FirstSpace == std::string::npos || FirstSpace == LastSpace)
+        {
+            return false;
+        }
+
+        OutRequest.Method = Line.substr(0, FirstSpace);
+
+        OutRequest.Target = Line.substr(FirstSpace + 1, LastSpace - FirstSpace - 1);
+
+        const auto& Version = Line.substr(LastSpace + 1);
+
+        if (OutRequest.Method.empty() || OutRequest.Target.empty() || Version.size() != 8 ||
+            Version.compare(0, 7, "HTTP/1.") != 0 || !std::isdigit(static_cast<unsigned char>(Version[7])))
+        {
+            return false;
+        }
+
+        OutRequest.MinorVersion = Version[7] - '0';
+
+        return true;
+    }
+
+    EHttpParseResult Parse(const std::string& Buffer, FHttpRequest& OutRequest, size_t& OutConsumed,
+                           int32_t& OutStatus)
+    {
+        // Tolerate the empty lines some clients leave between pipelined requests
+        const auto Start = Buffer.find_first_not_of("\r\n");
+
+        if (Start == std::string::npos)
+        {
+            return EHttpParseResult::Pending;
+        }
+
+        const auto HeaderEnd = Buffer.find("\r\n\r\n", Start);
+
+        if (HeaderEnd == std::string::npos)
+        {
+            if (Buffer.size() - Start > MaxHeaderSize)
+            {
+                OutStatus = 431;
+
+                return EHttpParseResult::Error;
+            }
+
+            return EHttpParseResult::Pending;
+        }
+
+        OutRequest = FHttpRequest();
+
+        auto LineStart = Start;
+
+        auto LineEnd = Buffer.find("\r\n", LineStart);
+
+        if (!ParseRequestLine(Buffer.substr(LineStart, LineEnd - LineStart), OutRequest))
+        {
+            OutStatus = 400;
+
+            return EHttpParseResult::Error;
+        }
+
+        if (OutRequest.MinorVersion > 1)
+        {
+            OutStatus = 505;
+
+            return EHttpParseResult::Error;
+        }
+
+        OutRequest.bKeepAlive = OutRequest.MinorVersion >= 1;
+
+        int64_t ContentLength = 0;
+
+        while (LineEnd < HeaderEnd)
+        {
+            LineStart = LineEnd + 2;
+
+            LineEnd = Buffer.find("\r\n", LineStart);
+
+            const auto& Line = Buffer.substr(LineStart, LineEnd - LineStart);
+
+            const auto Colon = Line.find(':');
+
+            if (Colon == std::string::npos || Colon == 0)
+            {
+                OutStatus = 400;
+
+                return EHttpParseResult::Error;
+            }
+
+            auto Name = Line.substr(0, Colon);
+
+            std::transform(Name.begin(), Name.end(), Name.begin(), [](const unsigned char Char)
+            {
+                return static_cast<char>(std::tolower(Char));
+            });
+
+            const auto& Value = HttpHeaders::Trim(Line.substr(Colon + 1));
+
+            if (Name == "content-length")
+            {
+                char* End = nullptr;
+
+                ContentLength = std::strtoll(Value.c_str(), &End, 10);
+
+                if (Value.empty() || *End != '\0' || ContentLength < 0)
+                {
+                    OutStatus = 400;
+
+                    return EHttpParseResult::Error;
+                }
+            }
+            else if (Name == "transfer-encoding" && !HttpHeaders::EqualsIgnoreCase(Value, "identity"))
+            {
+                OutStatus = 411;
+
+                return EHttpParseResult::Error;
+            }
+            else if (Name == "connection")
+            {
+                if (HttpHeaders::EqualsIgnoreCase(Value, "close"))
+                {
+                    OutRequest.bKeepAlive = false;
+                }
+                else if (HttpHeaders::EqualsIgnoreCase(Value, "keep-alive"))
+                {
+                    OutRequest.bKeepAlive = true;
+                }
+            }
+
+            OutRequest.Headers.emplace_back(std::move(Name), Value);
+        }
+
+        if (ContentLength > static_cast<int64_t>(MaxBodySize))
+        {
+            OutStatus = 413;
+
+            return EHttpParseResult::Error;
+        }
+
+        const auto BodyStart = HeaderEnd + 4;
+
+        if (Buffer.size() < BodyStart + static_cast<size_t>(ContentLength))
+        {
+            return EHttpParseResult::Pending;
+        }
+
+        OutRequest.Body = Buffer.substr(BodyStart, static_cast<size_t>(ContentLength));
+
+        OutConsumed = BodyStart + static_cast<size_t>(ContentLength);
+
+        return EHttpParseResult::Finished;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class EHttpParseResult
+{
+    Pending,
+    Finished,
+    Error
+};
+
+struct FHttpRequest
+{
+    std::string Method;
+
+    std::string Target;
+
+    int32_t MinorVersion = 1;
+
+    /** Names are lower case */
+    std::vector<std::pair<std::string, std::string>> Headers;
+
+    std::string Body;
+
+    bool bKeepAlive = true;
+
+    const std::string* FindHeader(const char* Name) const;
+};
+
+namespace HttpRequest
+{
+    constexpr size_t MaxHeaderSize = 16 * 1024;
+
+    constexpr size_t MaxBodySize = 64 * 1024;
+
+    /**
+     * Parses the request at the front of Buffer. On Finished OutConsumed is its size, on Error OutStatus is the
+     * status to answer with before the connection is closed.
+     */
+    EHttpParseResult Parse(const std::string& Buffer, FHttpRequest& OutRequest, size_t& OutConsumed,
+                           int32_t& OutStatus);
+}
@@ -0,0 +1,64 @@
+#include "HttpServer.h"
+#include "HttpWorker.h"
+#include <algorithm>
+#include <thread>
+
+FHttpServer::FHttpServer(const FServerConfig& InConfig) : Config(InConfig),
+                                                          ManifestCache(InConfig.Root, InConfig.MinCompressSize),
+                                                          RateLimiter(InConfig.RateLimit)
+{
+    if (Config.Threads <= 0)
+    {
+        Config.Threads = static_cast<int32_t>(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+}
+
+FHttpServer::~FHttpServer()
+{
+    Stop();
+
+    Join();
+
+    Workers.clear();
+}
+
+bool FHttpServer::Listen()
+{
+    for (auto i = 0; i < Config.Threads; ++i)
+    {
+        auto Worker = std::make_unique<FHttpWorker>(*this);
+
+        // The first loop resolves port 0, the others join it on the same port
+        if (!Worker->Listen(Config.Host, Config.Port))
+        {
+            Workers.clear();
+
+            return false;
+        }
+
+        Workers.push_back(std::move(Worker));
+    }
+
+    return true;
+}
+
+void FHttpServer::Start()
+{
+    for (const auto& Worker : Workers)
+    {
+        Worker->Start();
+    }
+}
+
+void FHttpServer::Stop()
+{
+    bIsStopping.store(true, std::memory_order_relaxed);
+}
+
+void FHttpServer::Join()
+{
+    for (const auto& Worker : Workers)
+    {
+        Worker->Join();
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "ServerConfig.h"
+#include "ManifestCache.h"
+#include "RateLimiter.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class FHttpWorker;
+
+struct FServerStats
+{
+    std::atomic<uint64_t> Requests{0};
+
+    std::atomic<uint64_t> SentBytes{0};
+
+    std::atomic<int64_t> Connections{0};
+};
+
+/** Owns the shared caches and one event loop per thread, each loop accepts on its own SO_REUSEPORT socket */
+class FHttpServer
+{
+public:
+    explicit FHttpServer(const FServerConfig& InConfig);
+
+    ~FHttpServer();
+
+    /** Binds every loop, after this GetPort is the real port even when 0 was asked for */
+    bool Listen();
+
+    void Start();
+
+    /** Safe from any thread, the loops notice within their poll timeout */
+    void Stop();
+
+    /** Blocks until every loop returned after Stop */
+    void Join();
+
+    bool IsStopping() const
+    {
+        return bIsStopping.load(std::memory_order_relaxed);
+    }
+
+    int32_t GetPort() const
+    {
+        return Config.Port;
+    }
+
+    const FServerConfig& GetConfig() const
+    {
+        return Config;
+    }
+
+    FManifestCache& GetManifestCache()
+    {
+        return ManifestCache;
+    }
+
+    FRateLimiter& GetRateLimiter()
+    {
+        return RateLimiter;
+    }
+
+    FServerStats& GetStats()
+    {
+        return Stats;
+    }
+
+private:
+    FServerConfig Config;
+
+    FManifestCache ManifestCache;
+
+    FRateLimiter RateLimiter;
+
+    FServerStats Stats;
+
+    std::vector<std::unique_ptr<FHttpWorker>> Workers;
+
+    std::atomic<bool> bIsStopping{false};
+};
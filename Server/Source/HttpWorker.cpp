@@ -0,0 +1,982 @@
+#include "HttpWorker.h"
+#include "HttpHeaders.h"
+#include "HttpServer.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace HttpWorker
+{
+    constexpr int MaxEvents = 256;
+
+    /** Longest epoll wait, also how late a stop request is noticed */
+    constexpr int MaxWaitMs = 250;
+
+    constexpr size_t ReadSize = 64 * 1024;
+
+    /** Pipelined requests beyond this are not read until the earlier ones are answered */
+    constexpr size_t MaxInputSize = 1024 * 1024;
+
+    static const auto EmptyManifest = std::make_shared<const std::string>("\"\"");
+
+    static std::string GetClientAddress(const sockaddr_storage& Address)
+    {
+        char Buffer[INET6_ADDRSTRLEN] = {};
+
+        if (Address.ss_family == AF_INET)
+        {
+            inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in&>(Address).sin_addr, Buffer, sizeof(Buffer));
+        }
+        else if (Address.ss_family == AF_INET6)
+        {
+            inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6&>(Address).sin6_addr, Buffer, sizeof(Buffer));
+        }
+
+        return Buffer;
+    }
+
+    static std::string GetFileName(const std::string& RelativePath)
+    {
+        const auto Slash = RelativePath.rfind('/');
+
+        return Slash == std::string::npos ? RelativePath : RelativePath.substr(Slash + 1);
+    }
+
+    static std::string MakeBoundary()
+    {
+        char Buffer[48];
+
+        std::snprintf(Buffer, sizeof(Buffer), "HotUpdateBoundary%016" PRIx64,
+                      static_cast<uint64_t>(GetMonotonicSeconds() * 1000000.0) ^ static_cast<uint64_t>(getpid()));
+
+        return Buffer;
+    }
+
+    static const std::string& GetBoundary()
+    {
+        static const auto Boundary = MakeBoundary();
+
+        return Boundary;
+    }
+}
+
+FHttpWorker::FHttpWorker(FHttpServer& InServer) : Server(InServer)
+{
+}
+
+FHttpWorker::~FHttpWorker()
+{
+    Join();
+
+    for (auto& Pair : Connections)
+    {
+        if (Pair.second->File >= 0)
+        {
+            close(Pair.second->File);
+        }
+
+        close(Pair.first);
+    }
+
+    if (ListenSocket >= 0)
+    {
+        close(ListenSocket);
+    }
+
+    if (Epoll >= 0)
+    {
+        close(Epoll);
+    }
+}
+
+bool FHttpWorker::Listen(const std::string& Host, int32_t& InOutPort)
+{
+    addrinfo Hints{};
+
+    Hints.ai_family = AF_UNSPEC;
+
+    Hints.ai_socktype = SOCK_STREAM;
+
+    Hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+
+    addrinfo* Addresses = nullptr;
+
+    const auto& Port = std::to_string(InOutPort);
+
+    const auto Result = getaddrinfo(Host.empty() ? nullptr : Host.c_str(), Port.c_str(), &Hints, &Addresses);
+
+    if (Result != 0)
+    {
+        std::fprintf(stderr, "Resolve %s failed: %s\n", Host.c_str(), gai_strerror(Result));
+
+        return false;
+    }
+
+    for (auto Address = Addresses; Address != nullptr && ListenSocket < 0; Address = Address->ai_next)
+    {
+        ListenSocket = socket(Address->ai_family, Address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                              Address->ai_protocol);
+
+        if (ListenSocket < 0)
+        {
+            continue;
+        }
+
+        const auto Enable = 1;
+
+        setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEADDR, &Enable, sizeof(Enable));
+
+        setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEPORT, &Enable, sizeof(Enable));
+
+        if (bind(ListenSocket, Address->ai_addr, Address->ai_addrlen) != 0 || listen(ListenSocket, SOMAXCONN) != 0)
+        {
+            close(ListenSocket);
+
+            ListenSocket = -1;
+        }
+    }
+
+    freeaddrinfo(Addresses);
+
+    if (ListenSocket < 0)
+    {
+        std::fprintf(stderr, "Listen on %s:%d failed: %s\n", Host.c_str(), InOutPort, std::strerror(errno));
+
+        return false;
+    }
+
+    sockaddr_storage Bound{};
+
+    socklen_t BoundSize = sizeof(Bound);
+
+    if (getsockname(ListenSocket, reinterpret_cast<sockaddr*>(&Bound), &BoundSize) == 0)
+    {
+        InOutPort = ntohs(Bound.ss_family == AF_INET6
+                              ? reinterpret_cast<const sockaddr_in6&>(Bound).sin6_port
+                              : reinterpret_cast<const sockaddr_in&>(Bound).sin_port);
+    }
+
+    Epoll = epoll_create1(EPOLL_CLOEXEC);
+
+    if (Epoll < 0)
+    {
+        return false;
+    }
+
+    epoll_event Event{};
+
+    Event.events = EPOLLIN;
+
+    Event.data.fd = ListenSocket;
+
+    return epoll_ctl(Epoll, EPOLL_CTL_ADD, ListenSocket, &Event) == 0;
+}
+
+void FHttpWorker::Start()
+{
+    Thread = std::thread(&FHttpWorker::Run, this);
+}
+
+void FHttpWorker::Join()
+{
+    if (Thread.joinable())
+    {
+        Thread.join();
+    }
+}
+
+void FHttpWorker::Run()
+{
+    epoll_event Events[HttpWorker::MaxEvents];
+
+    auto LastSweepTime = GetMonotonicSeconds();
+
+    while (!Server.IsStopping())
+    {
+        auto WaitMs = HttpWorker::MaxWaitMs;
+
+        if (!Throttled.empty())
+        {
+            const auto Delay = (Throttled.begin()->first - GetMonotonicSeconds()) * 1000.0;
+
+            WaitMs = std::min(WaitMs, std::max(static_cast<int>(std::ceil(Delay)), 0));
+        }
+
+        const auto EventNum = epoll_wait(Epoll, Events, HttpWorker::MaxEvents, WaitMs);
+
+        if (EventNum < 0 && errno != EINTR)
+        {
+            std::fprintf(stderr, "epoll_wait failed: %s\n", std::strerror(errno));
+
+            break;
+        }
+
+        for (auto i = 0; i < EventNum; ++i)
+        {
+            const auto Socket = Events[i].data.fd;
+
+            if (Socket == ListenSocket)
+            {
+                Accept();
+
+                continue;
+            }
+
+            if (Events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                OnReadable(Socket);
+            }
+
+            if (Events[i].events & EPOLLOUT)
+            {
+                OnWritable(Socket);
+            }
+        }
+
+        const auto Now = GetMonotonicSeconds();
+
+        OnWake(Now);
+
+        if (Now - LastSweepTime >= 1.0)
+        {
+            CloseIdleConnections(Now);
+
+            LastSweepTime = Now;
+        }
+    }
+}
+
+void FHttpWorker::Accept()
+{
+    while (true)
+    {
+        sockaddr_storage Address{};
+
+        socklen_t AddressSize = sizeof(Address);
+
+        const auto Socket = accept4(ListenSocket, reinterpret_cast<sockaddr*>(&Address), &AddressSize,
+                                    SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (Socket < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+
+            // EAGAIN once drained, EMFILE and the like are retried on the next wake up
+            return;
+        }
+
+        const auto Enable = 1;
+
+        setsockopt(Socket, IPPROTO_TCP, TCP_NODELAY, &Enable, sizeof(Enable));
+
+        auto Connection = std::make_unique<FConnection>();
+
+        Connection->Socket = Socket;
+
+        Connection->Client = HttpWorker::GetClientAddress(Address);
+
+        Connection->Bucket = Server.GetRateLimiter().Acquire(Connection->Client);
+
+        Connection->LastActiveTime = GetMonotonicSeconds();
+
+        epoll_event Event{};
+
+        Event.events = EPOLLIN | EPOLLRDHUP;
+
+        Event.data.fd = Socket;
+
+        Connection->Events = Event.events;
+
+        if (epoll_ctl(Epoll, EPOLL_CTL_ADD, Socket, &Event) != 0)
+        {
+            close(Socket);
+
+            continue;
+        }
+
+        Connections.emplace(Socket, std::move(Connection));
+
+        Server.GetStats().Connections.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FHttpWorker::OnReadable(const int Socket)
+{
+    const auto Iterator = Connections.find(Socket);
+
+    if (Iterator == Connections.end())
+    {
+        return;
+    }
+
+    auto& Connection = *Iterator->second;
+
+    char Buffer[HttpWorker::ReadSize];
+
+    while (Connection.Input.size() < HttpWorker::MaxInputSize)
+    {
+        const auto Received = recv(Socket, Buffer, sizeof(Buffer), 0);
+
+        if (Received > 0)
+        {
+            Connection.Input.append(Buffer, static_cast<size_t>(Received));
+
+            continue;
+        }
+
+        if (Received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (Received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+
+        if (Received < 0)
+        {
+            Close(Connection);
+
+            return;
+        }
+
+        Connection.bIsPeerClosed = true;
+
+        break;
+    }
+
+    Connection.LastActiveTime = GetMonotonicSeconds();
+
+    ProcessInput(Connection);
+
+    const auto Remaining = Connections.find(Socket);
+
+    // Nothing left to answer on a half closed connection
+    if (Remaining != Connections.end() && Remaining->second->bIsPeerClosed && Remaining->second->Output.empty())
+    {
+        Close(*Remaining->second);
+    }
+}
+
+void FHttpWorker::OnWritable(const int Socket)
+{
+    const auto Iterator = Connections.find(Socket);
+
+    if (Iterator == Connections.end())
+    {
+        return;
+    }
+
+    auto& Connection = *Iterator->second;
+
+    if (Flush(Connection) && Connection.Output.empty())
+    {
+        ProcessInput(Connection);
+    }
+}
+
+void FHttpWorker::OnWake(const double Now)
+{
+    while (!Throttled.empty() && Throttled.begin()->first <= Now)
+    {
+        const auto Socket = Throttled.begin()->second;
+
+        Throttled.erase(Throttled.begin());
+
+        const auto Iterator = Connections.find(Socket);
+
+        if (Iterator == Connections.end())
+        {
+            continue;
+        }
+
+        auto& Connection = *Iterator->second;
+
+        Connection.WakeTime = 0.0;
+
+        if (Flush(Connection) && Connection.Output.empty())
+        {
+            ProcessInput(Connection);
+        }
+    }
+}
+
+void FHttpWorker::CloseIdleConnections(const double Now)
+{
+    const auto IdleTimeout = Server.GetConfig().IdleTimeout;
+
+    std::vector<int> IdleSockets;
+
+    for (const auto& Pair : Connections)
+    {
+        // A throttled download is not idle, the client is only being held back
+        if (Pair.second->WakeTime <= 0.0 && Now - Pair.second->LastActiveTime > IdleTimeout)
+        {
+            IdleSockets.push_back(Pair.first);
+        }
+    }
+
+    for (const auto Socket : IdleSockets)
+    {
+        Close(*Connections[Socket]);
+    }
+}
+
+void FHttpWorker::ProcessInput(FConnection& Connection)
+{
+    // One response at a time, pipelined requests stay in the buffer until the previous answer is out
+    while (Connection.Output.empty() && !Connection.Input.empty())
+    {
+        FHttpRequest Request;
+
+        size_t Consumed = 0;
+
+        auto Status = 0;
+
+        const auto Result = HttpRequest::Parse(Connection.Input, Request, Consumed, Status);
+
+        if (Result == EHttpParseResult::Pending)
+        {
+            return;
+        }
+
+        if (Result == EHttpParseResult::Error)
+        {
+            Connection.Input.clear();
+
+            Connection.bKeepAlive = false;
+
+            CurrentRequest = nullptr;
+
+            SendError(Connection, Status);
+
+            Flush(Connection);
+
+            return;
+        }
+
+        Connection.Input.erase(0, Consumed);
+
+        CurrentRequest = &Request;
+
+        HandleRequest(Connection, Request);
+
+        CurrentRequest = nullptr;
+
+        if (!Flush(Connection))
+        {
+            return;
+        }
+    }
+
+    UpdateEvents(Connection);
+}
+
+bool FHttpWorker::Flush(FConnection& Connection)
+{
+    auto& Stats = Server.GetStats();
+
+    while (!Connection.Output.empty())
+    {
+        auto& Segment = Connection.Output.front();
+
+        ssize_t Sent = 0;
+
+        int64_t Granted = 0;
+
+        if (Segment.IsFile())
+        {
+            Granted = std::min(Segment.Size, Server.GetConfig().SendChunkSize);
+
+            if (Connection.Bucket != nullptr)
+            {
+                const auto Now = GetMonotonicSeconds();
+
+                Granted = Connection.Bucket->Take(Granted, Now);
+
+                if (Granted <= 0)
+                {
+                    Connection.bWantWrite = false;
+
+                    UpdateEvents(Connection);
+
+                    Throttle(Connection, Now + Connection.Bucket->GetWaitTime(Now));
+
+                    return true;
+                }
+            }
+
+            off_t Offset = Segment.Offset;
+
+            Sent = sendfile(Connection.Socket, Connection.File, &Offset, static_cast<size_t>(Granted));
+        }
+        else
+        {
+            // Let the headers leave in the same packet as the start of the body
+            const auto Flags = MSG_NOSIGNAL | (Connection.Output.size() > 1 ? MSG_MORE : 0);
+
+            Sent = send(Connection.Socket, Segment.Data->data() + Segment.Offset, static_cast<size_t>(Segment.Size),
+                        Flags);
+        }
+
+        if (Connection.Bucket != nullptr && Granted > std::max<ssize_t>(Sent, 0))
+        {
+            Connection.Bucket->Return(Granted - std::max<ssize_t>(Sent, 0));
+        }
+
+        if (Sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                Connection.bWantWrite = true;
+
+                UpdateEvents(Connection);
+
+                return true;
+            }
+
+            Close(Connection);
+
+            return false;
+        }
+
+        if (Sent == 0 && Segment.Size > 0)
+        {
+            // The file shrank under us, the promised Content-Length can no longer be kept
+            Close(Connection);
+
+            return false;
+        }
+
+        Segment.Offset += Sent;
+
+        Segment.Size -= Sent;
+
+        Stats.SentBytes.fetch_add(static_cast<uint64_t>(Sent), std::memory_order_relaxed);
+
+        Connection.LastActiveTime = GetMonotonicSeconds();
+
+        if (Segment.Size <= 0)
+        {
+            Connection.Output.pop_front();
+        }
+    }
+
+    if (Connection.File >= 0)
+    {
+        close(Connection.File);
+
+        Connection.File = -1;
+    }
+
+    Connection.bWantWrite = false;
+
+    UpdateEvents(Connection);
+
+    if (!Connection.bKeepAlive || (Connection.bIsPeerClosed && Connection.Input.empty()))
+    {
+        Close(Connection);
+
+        return false;
+    }
+
+    return true;
+}
+
+void FHttpWorker::Close(FConnection& Connection)
+{
+    const auto Socket = Connection.Socket;
+
+    if (Connection.WakeTime > 0.0)
+    {
+        Throttled.erase({Connection.WakeTime, Socket});
+    }
+
+    if (Connection.File >= 0)
+    {
+        close(Connection.File);
+    }
+
+    epoll_ctl(Epoll, EPOLL_CTL_DEL, Socket, nullptr);
+
+    close(Socket);
+
+    Connections.erase(Socket);
+
+    Server.GetStats().Connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void FHttpWorker::UpdateEvents(FConnection& Connection)
+{
+    uint32_t Events = Connection.bWantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0;
+
+    // Level triggered, a full buffer or a shut down peer would otherwise wake the loop over and over
+    if (!Connection.bIsPeerClosed && Connection.Input.size() < HttpWorker::MaxInputSize)
+    {
+        Events |= EPOLLIN | EPOLLRDHUP;
+    }
+
+    if (Connection.Events == Events)
+    {
+        return;
+    }
+
+    epoll_event Event{};
+
+    Event.events = Events;
+
+    Event.data.fd = Connection.Socket;
+
+    epoll_ctl(Epoll, EPOLL_CTL_MOD, Connection.Socket, &Event);
+
+    Connection.Events = Events;
+}
+
+void FHttpWorker::Throttle(FConnection& Connection, const double WakeTime)
+{
+    Connection.WakeTime = WakeTime;
+
+    Throttled.emplace(WakeTime, Connection.Socket);
+}
+
+void FHttpWorker::HandleRequest(FConnection& Connection, const FHttpRequest& Request)
+{
+    Server.GetStats().Requests.fetch_add(1, std::memory_order_relaxed);
+
+    Connection.bKeepAlive = Request.bKeepAlive && !Connection.bIsPeerClosed;
+
+    const auto& ManifestName = Server.GetConfig().ManifestName;
+
+    // The client posts {"version", "platform"} to the server url, the same contract as WWW/index.php
+    if (Request.Method == "POST")
+    {
+        std::string Version;
+
+        std::string Platform;
+
+        if (!FManifestCache::ParseRequest(Request.Body, Version, Platform))
+        {
+            HandleManifest(Connection, Request, std::string(), true);
+
+            return;
+        }
+
+        HandleManifest(Connection, Request, Version + "/" + Platform + "/" + ManifestName, true);
+
+        return;
+    }
+
+    if (Request.Method != "GET" && Request.Method != "HEAD")
+    {
+        SendError(Connection, 405, "Allow: GET, HEAD, POST\r\n");
+
+        return;
+    }
+
+    std::string RelativePath;
+
+    if (!HttpHeaders::DecodeTargetPath(Request.Target, RelativePath))
+    {
+        SendError(Connection, 400);
+
+        return;
+    }
+
+    if (HttpWorker::GetFileName(RelativePath) == ManifestName)
+    {
+        HandleManifest(Connection, Request, RelativePath, false);
+
+        return;
+    }
+
+    HandleFile(Connection, Request, RelativePath);
+}
+
+void FHttpWorker::HandleManifest(FConnection& Connection, const FHttpRequest& Request,
+                                 const std::string& RelativePath, const bool bIsMissingEmpty)
+{
+    const auto& Manifest = RelativePath.empty() ? nullptr : Server.GetManifestCache().Find(RelativePath);
+
+    std::string Headers = "Content-Type: application/json; charset=utf-8\r\nCache-Control: no-cache\r\n";
+
+    if (Manifest == nullptr)
+    {
+        if (!bIsMissingEmpty)
+        {
+            SendError(Connection, 404);
+
+            return;
+        }
+
+        // index.php answers an unknown version with an empty json string
+        SendResponse(Connection, 200, static_cast<int64_t>(HttpWorker::EmptyManifest->size()), Headers);
+
+        if (Request.Method != "HEAD")
+        {
+            Connection.Output.push_back({HttpWorker::EmptyManifest, 0,
+                static_cast<int64_t>(HttpWorker::EmptyManifest->size())});
+        }
+
+        return;
+    }
+
+    const auto AcceptEncoding = Request.FindHeader("accept-encoding");
+
+    const auto bIsGzip = Manifest->GzipBody != nullptr && AcceptEncoding != nullptr &&
+        HttpHeaders::AcceptsGzip(*AcceptEncoding);
+
+    const auto& Body = bIsGzip ? Manifest->GzipBody : Manifest->Body;
+
+    // Each encoding is its own representation and needs its own validator
+    const auto& ETag = bIsGzip ? Manifest->ETag.substr(0, Manifest->ETag.size() - 1) + "-gzip\"" : Manifest->ETag;
+
+    Headers += "Vary: Accept-Encoding\r\nETag: " + ETag + "\r\nLast-Modified: " + Manifest->LastModified + "\r\n";
+
+    if (bIsGzip)
+    {
+        Headers += "Content-Encoding: gzip\r\n";
+    }
+
+    const auto IfNoneMatch = Request.FindHeader("if-none-match");
+
+    if (Request.Method != "POST" && IfNoneMatch != nullptr && HttpHeaders::MatchIfNoneMatch(*IfNoneMatch, ETag))
+    {
+        SendResponse(Connection, 304, -1, Headers);
+
+        return;
+    }
+
+    SendResponse(Connection, 200, static_cast<int64_t>(Body->size()), Headers);
+
+    if (Request.Method != "HEAD")
+    {
+        Connection.Output.push_back({Body, 0, static_cast<int64_t>(Body->size())});
+    }
+}
+
+void FHttpWorker::HandleFile(FConnection& Connection, const FHttpRequest& Request, const std::string& RelativePath)
+{
+    const auto& Path = Server.GetConfig().Root + "/" + RelativePath;
+
+    const auto File = open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    struct stat Stat{};
+
+    if (File < 0 || fstat(File, &Stat) != 0 || !S_ISREG(Stat.st_mode))
+    {
+        if (File >= 0)
+        {
+            close(File);
+        }
+
+        SendError(Connection, File < 0 && errno == EACCES ? 403 : 404);
+
+        return;
+    }
+
+    const auto FileSize = static_cast<int64_t>(Stat.st_size);
+
+    const auto& ETag = HttpHeaders::MakeETag(Stat);
+
+    const auto& LastModified = HttpHeaders::FormatHttpDate(Stat.st_mtim.tv_sec);
+
+    const char* MimeType = HttpHeaders::GetMimeType(RelativePath);
+
+    auto Headers = std::string("Accept-Ranges: bytes\r\nETag: ") + ETag + "\r\nLast-Modified: " + LastModified +
+        "\r\n";
+
+    const auto IfNoneMatch = Request.FindHeader("if-none-match");
+
+    const auto IfModifiedSince = Request.FindHeader("if-modified-since");
+
+    if (IfNoneMatch != nullptr
+            ? HttpHeaders::MatchIfNoneMatch(*IfNoneMatch, ETag)
+            : IfModifiedSince != nullptr && *IfModifiedSince == LastModified)
+    {
+        close(File);
+
+        SendResponse(Connection, 304, -1, Headers);
+
+        return;
+    }
+
+    std::vector<FByteRange> Ranges;
+
+    auto RangeResult = ERangeResult::None;
+
+    const auto Range = Request.FindHeader("range");
+
+    const auto IfRange = Request.FindHeader("if-range");
+
+    // A stale If-Range means the client's partial copy is of another file, it gets the whole new one
+    if (Range != nullptr && (IfRange == nullptr || HttpHeaders::MatchIfRange(*IfRange, ETag, LastModified)))
+    {
+        RangeResult = HttpHeaders::ParseRange(*Range, FileSize, Ranges);
+    }
+
+    if (RangeResult == ERangeResult::Unsatisfiable)
+    {
+        close(File);
+
+        SendError(Connection, 416, ("Content-Range: bytes */" + std::to_string(FileSize) + "\r\n").c_str());
+
+        return;
+    }
+
+    const auto bIsHead = Request.Method == "HEAD";
+
+    if (!bIsHead)
+    {
+        Connection.File = File;
+    }
+    else
+    {
+        close(File);
+    }
+
+    if (RangeResult == ERangeResult::None)
+    {
+        SendResponse(Connection, 200, FileSize, Headers + "Content-Type: " + MimeType + "\r\n");
+
+        if (!bIsHead && FileSize > 0)
+        {
+            Connection.Output.push_back({nullptr, 0, FileSize});
+        }
+
+        return;
+    }
+
+    if (Ranges.size() == 1)
+    {
+        const auto& Single = Ranges.front();
+
+        SendResponse(Connection, 206, Single.Size,
+                     Headers + "Content-Type: " + MimeType + "\r\nContent-Range: bytes " +
+                     std::to_string(Single.Offset) + "-" + std::to_string(Single.Offset + Single.Size - 1) + "/" +
+                     std::to_string(FileSize) + "\r\n");
+
+        if (!bIsHead)
+        {
+            Connection.Output.push_back({nullptr, Single.Offset, Single.Size});
+        }
+
+        return;
+    }
+
+    // multipart/byteranges, the part headers go out from memory and the part bodies with sendfile
+    const auto& Boundary = HttpWorker::GetBoundary();
+
+    std::vector<FBodySegment> Segments;
+
+    int64_t ContentLength = 0;
+
+    for (const auto& Part : Ranges)
+    {
+        const auto PartHeader = std::make_shared<const std::string>(
+            "\r\n--" + Boundary + "\r\nContent-Type: " + MimeType + "\r\nContent-Range: bytes " +
+            std::to_string(Part.Offset) + "-" + std::to_string(Part.Offset + Part.Size - 1) + "/" +
+            std::to_string(FileSize) + "\r\n\r\n");
+
+        Segments.push_back({PartHeader, 0, static_cast<int64_t>(PartHeader->size())});
+
+        Segments.push_back({nullptr, Part.Offset, Part.Size});
+
+        ContentLength += static_cast<int64_t>(PartHeader->size()) + Part.Size;
+    }
+
+    const auto Trailer = std::make_shared<const std::string>("\r\n--" + Boundary + "--\r\n");
+
+    Segments.push_back({Trailer, 0, static_cast<int64_t>(Trailer->size())});
+
+    ContentLength += static_cast<int64_t>(Trailer->size());
+
+    SendResponse(Connection, 206, ContentLength,
+                 Headers + "Content-Type: multipart/byteranges; boundary=" + Boundary + "\r\n");
+
+    if (!bIsHead)
+    {
+        Connection.Output.insert(Connection.Output.end(), Segments.begin(), Segments.end());
+    }
+}
+
+void FHttpWorker::SendError(FConnection& Connection, const int32_t Status, const char* ExtraHeaders)
+{
+    const auto Body = std::make_shared<const std::string>(std::to_string(Status) + " " +
+        HttpHeaders::GetReasonPhrase(Status) + "\n");
+
+    SendResponse(Connection, Status, static_cast<int64_t>(Body->size()),
+                 std::string("Content-Type: text/plain; charset=utf-8\r\n") + ExtraHeaders);
+
+    if (CurrentRequest == nullptr || CurrentRequest->Method != "HEAD")
+    {
+        Connection.Output.push_back({Body, 0, static_cast<int64_t>(Body->size())});
+    }
+}
+
+void FHttpWorker::SendResponse(FConnection& Connection, const int32_t Status, const int64_t ContentLength,
+                               const std::string& Headers)
+{
+    auto Response = std::make_shared<std::string>();
+
+    Response->reserve(256 + Headers.size());
+
+    *Response += "HTTP/1.1 " + std::to_string(Status) + " " + HttpHeaders::GetReasonPhrase(Status) +
+        "\r\nServer: HotUpdateServer\r\nDate: " + GetDate() + "\r\n";
+
+    if (ContentLength >= 0)
+    {
+        *Response += "Content-Length: " + std::to_string(ContentLength) + "\r\n";
+    }
+
+    *Response += Connection.bKeepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+
+    *Response += Headers;
+
+    *Response += "\r\n";
+
+    Connection.Output.push_back({Response, 0, static_cast<int64_t>(Response->size())});
+
+    if (Server.GetConfig().bVerbose)
+    {
+        std::fprintf(stderr, "%s \"%s %s\" %d %" PRId64 "\n", Connection.Client.c_str(),
+                     CurrentRequest != nullptr ? CurrentRequest->Method.c_str() : "-",
+                     CurrentRequest != nullptr ? CurrentRequest->Target.c_str() : "-", Status, ContentLength);
+    }
+}
+
+const std::string& FHttpWorker::GetDate()
+{
+    const auto Now = time(nullptr);
+
+    if (Now != DateTime)
+    {
+        DateTime = Now;
+
+        Date = HttpHeaders::FormatHttpDate(Now);
+    }
+
+    return Date;
+}
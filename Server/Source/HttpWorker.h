@@ -0,0 +1,129 @@
+#pragma once
+#include "HttpRequest.h"
+#include "RateLimiter.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+class FHttpServer;
+
+/** Part of a response, either bytes in memory or a range of the open file sent with sendfile */
+struct FBodySegment
+{
+    std::shared_ptr<const std::string> Data;
+
+    int64_t Offset = 0;
+
+    int64_t Size = 0;
+
+    bool IsFile() const
+    {
+        return Data == nullptr;
+    }
+};
+
+struct FConnection
+{
+    int Socket = -1;
+
+    std::string Client;
+
+    std::string Input;
+
+    std::deque<FBodySegment> Output;
+
+    int File = -1;
+
+    bool bKeepAlive = true;
+
+    /** The peer shut down its side, answer what was already read and close */
+    bool bIsPeerClosed = false;
+
+    bool bWantWrite = false;
+
+    uint32_t Events = 0;
+
+    /** Throttled by the rate limiter until then, 0 when not */
+    double WakeTime = 0.0;
+
+    double LastActiveTime = 0.0;
+
+    std::shared_ptr<FTokenBucket> Bucket;
+};
+
+/** One epoll loop, connections never move between loops */
+class FHttpWorker
+{
+public:
+    explicit FHttpWorker(FHttpServer& InServer);
+
+    ~FHttpWorker();
+
+    bool Listen(const std::string& Host, int32_t& InOutPort);
+
+    void Start();
+
+    void Join();
+
+private:
+    void Run();
+
+    void Accept();
+
+    void OnReadable(int Socket);
+
+    void OnWritable(int Socket);
+
+    void OnWake(double Now);
+
+    void CloseIdleConnections(double Now);
+
+    void ProcessInput(FConnection& Connection);
+
+    /** Sends what it can, false when the connection was closed */
+    bool Flush(FConnection& Connection);
+
+    void Close(FConnection& Connection);
+
+    /** Reads while the input has room and the peer is open, writes while a send would block */
+    void UpdateEvents(FConnection& Connection);
+
+    void Throttle(FConnection& Connection, double WakeTime);
+
+    void HandleRequest(FConnection& Connection, const FHttpRequest& Request);
+
+    void HandleManifest(FConnection& Connection, const FHttpRequest& Request, const std::string& RelativePath,
+                        bool bIsMissingEmpty);
+
+    void HandleFile(FConnection& Connection, const FHttpRequest& Request, const std::string& RelativePath);
+
+    void SendError(FConnection& Connection, int32_t Status, const char* ExtraHeaders = "");
+
+    void SendResponse(FConnection& Connection, int32_t Status, int64_t ContentLength, const std::string& Headers);
+
+    const std::string& GetDate();
+
+    FHttpServer& Server;
+
+    int ListenSocket = -1;
+
+    int Epoll = -1;
+
+    std::thread Thread;
+
+    std::unordered_map<int, std::unique_ptr<FConnection>> Connections;
+
+    std::set<std::pair<double, int>> Throttled;
+
+    time_t DateTime = 0;
+
+    std::string Date;
+
+    /** Request being answered, null for a request that could not be parsed */
+    const FHttpRequest* CurrentRequest = nullptr;
+};
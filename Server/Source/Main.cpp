@@ -0,0 +1,236 @@
+#include "HttpServer.h"
+#include <signal.h>
+#include <unistd.h>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace Main
+{
+    static volatile sig_atomic_t bIsStopRequested = 0;
+
+    static void OnSignal(int)
+    {
+        bIsStopRequested = 1;
+    }
+
+    static void PrintUsage(const char* Program)
+    {
+        std::printf("Usage: %s [options]\n"
+                    "  --root <dir>          content root laid out like WWW, default WWW\n"
+                    "  --host <address>      address to bind, default 0.0.0.0\n"
+                    "  --port <port>         port to listen on, 0 picks a free one, default 8080\n"
+                    "  --threads <num>       event loops, default one per core\n"
+                    "  --rate <bytes>        per client bandwidth in bytes per second, K and M suffixes, 0 is unlimited\n"
+                    "  --manifest <name>     manifest file name, default version.json\n"
+                    "  --idle-timeout <s>    close keep-alive connections idle this long, default 30\n"
+                    "  --stats <s>           print throughput every s seconds\n"
+                    "  --verbose             access log on stderr\n", Program);
+    }
+
+    static bool ParseSize(const char* Value, int64_t& OutSize)
+    {
+        char* End = nullptr;
+
+        const auto Number = std::strtod(Value, &End);
+
+        if (End == Value || Number < 0.0)
+        {
+            return false;
+        }
+
+        auto Scale = 1.0;
+
+        switch (std::toupper(static_cast<unsigned char>(*End)))
+        {
+        case 'K': Scale = 1024.0;
+            ++End;
+            break;
+        case 'M': Scale = 1024.0 * 1024.0;
+            ++End;
+            break;
+        case 'G': Scale = 1024.0 * 1024.0 * 1024.0;
+            ++End;
+            break;
+        default:
+            break;
+        }
+
+        if (*End != '\0')
+        {
+            return false;
+        }
+
+        OutSize = static_cast<int64_t>(Number * Scale);
+
+        return true;
+    }
+
+    static bool ParseArguments(const int Argc, char** Argv, FServerConfig& OutConfig)
+    {
+        for (auto i = 1; i < Argc; ++i)
+        {
+            const std::string Name = Argv[i];
+
+            if (Name == "--verbose")
+            {
+                OutConfig.bVerbose = true;
+
+                continue;
+            }
+
+            if (Name == "--help" || Name == "-h")
+            {
+                return false;
+            }
+
+            if (i + 1 >= Argc)
+            {
+                std::fprintf(stderr, "Missing value for %s\n", Name.c_str());
+
+                return false;
+            }
+
+            const char* Value = Argv[++i];
+
+            auto bIsValid = true;
+
+            if (Name == "--root")
+            {
+                OutConfig.Root = Value;
+            }
+            else if (Name == "--host")
+            {
+                OutConfig.Host = Value;
+            }
+            else if (Name == "--port")
+            {
+                OutConfig.Port = std::atoi(Value);
+
+                bIsValid = OutConfig.Port >= 0 && OutConfig.Port <= 65535;
+            }
+            else if (Name == "--threads")
+            {
+                OutConfig.Threads = std::atoi(Value);
+            }
+            else if (Name == "--rate")
+            {
+                bIsValid = ParseSize(Value, OutConfig.RateLimit);
+            }
+            else if (Name == "--manifest")
+            {
+                OutConfig.ManifestName = Value;
+
+                bIsValid = !OutConfig.ManifestName.empty() && OutConfig.ManifestName.find('/') == std::string::npos;
+            }
+            else if (Name == "--idle-timeout")
+            {
+                OutConfig.IdleTimeout = std::atof(Value);
+
+                bIsValid = OutConfig.IdleTimeout > 0.0;
+            }
+            else if (Name == "--stats")
+            {
+                OutConfig.StatsInterval = std::atof(Value);
+            }
+            else
+            {
+                std::fprintf(stderr, "Unknown option %s\n", Name.c_str());
+
+                return false;
+            }
+
+            if (!bIsValid)
+            {
+                std::fprintf(stderr, "Invalid value %s for %s\n", Value, Name.c_str());
+
+                return false;
+            }
+        }
+
+        // Root never ends with a slash so request paths can be appended as /<path>
+        while (OutConfig.Root.size() > 1 && OutConfig.Root.back() == '/')
+        {
+            OutConfig.Root.pop_back();
+        }
+
+        return true;
+    }
+}
+
+int main(const int Argc, char** Argv)
+{
+    FServerConfig Config;
+
+    if (!Main::ParseArguments(Argc, Argv, Config))
+    {
+        Main::PrintUsage(Argv[0]);
+
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    signal(SIGINT, Main::OnSignal);
+
+    signal(SIGTERM, Main::OnSignal);
+
+    FHttpServer Server(Config);
+
+    if (!Server.Listen())
+    {
+        return 1;
+    }
+
+    // Scripts starting the server on port 0 read the real port from this line
+    std::printf("HotUpdateServer listening on %s:%d, root %s, %d threads\n", Config.Host.c_str(), Server.GetPort(),
+                Config.Root.c_str(), Server.GetConfig().Threads);
+
+    std::fflush(stdout);
+
+    Server.Start();
+
+    auto& Stats = Server.GetStats();
+
+    auto LastTime = GetMonotonicSeconds();
+
+    auto LastRequests = Stats.Requests.load();
+
+    auto LastSentBytes = Stats.SentBytes.load();
+
+    while (!Main::bIsStopRequested)
+    {
+        usleep(100 * 1000);
+
+        const auto Now = GetMonotonicSeconds();
+
+        if (Config.StatsInterval <= 0.0 || Now - LastTime < Config.StatsInterval)
+        {
+            continue;
+        }
+
+        const auto Requests = Stats.Requests.load();
+
+        const auto SentBytes = Stats.SentBytes.load();
+
+        std::printf("%.1f req/s, %.2f MB/s, %lld connections\n", (Requests - LastRequests) / (Now - LastTime),
+                    (SentBytes - LastSentBytes) / (Now - LastTime) / (1024.0 * 1024.0),
+                    static_cast<long long>(Stats.Connections.load()));
+
+        std::fflush(stdout);
+
+        LastTime = Now;
+
+        LastRequests = Requests;
+
+        LastSentBytes = SentBytes;
+    }
+
+    Server.Stop();
+
+    Server.Join();
+
+    return 0;
+}
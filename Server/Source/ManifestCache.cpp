@@ -0,0 +1,456 @@
+#include "ManifestCache.h"
+#include "Compression.h"
+#include "HttpHeaders.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <mutex>
+#include <utility>
+
+namespace ManifestCache
+{
+    /** Minimal reader for the flat request object, nested values are skipped */
+    class FJsonReader
+    {
+    public:
+        explicit FJsonReader(const std::string& InJson) : Json(InJson)
+        {
+        }
+
+        bool ReadObject(std::string& OutVersion, std::string& OutPlatform)
+        {
+            SkipSpace();
+
+            if (!Consume('{'))
+            {
+                return false;
+            }
+
+            SkipSpace();
+
+            if (Consume('}'))
+            {
+                return true;
+            }
+
+            while (true)
+            {
+                std::string Key;
+
+                SkipSpace();
+
+                if (!ReadString(Key))
+                {
+                    return false;
+                }
+
+                SkipSpace();
+
+                if (!Consume(':'))
+                {
+                    return false;
+                }
+
+                SkipSpace();
+
+                if (Position < Json.size() && Json[Position] == '"')
+                {
+                    std::string Value;
+
+                    if (!ReadString(Value))
+                    {
+                        return false;
+                    }
+
+                    if (Key == "version")
+                    {
+                        OutVersion = std::move(Value);
+                    }
+                    else if (Key == "platform")
+                    {
+                        OutPlatform = std::move(Value);
+                    }
+                }
+                else if (!SkipValue())
+                {
+                    return false;
+                }
+
+                SkipSpace();
+
+                if (Consume('}'))
+                {
+                    return true;
+                }
+
+                if (!Consume(','))
+                {
+                    return false;
+                }
+            }
+        }
+
+    private:
+        void SkipSpace()
+        {
+            while (Position < Json.size() && (Json[Position] == ' ' || Json[Position] == '\t' ||
+                Json[Position] == '\r' || Json[Position] == '\n'))
+            {
+                ++Position;
+            }
+        }
+
+        bool Consume(const char Char)
+        {
+            if (Position < Json.size() && Json[Position] == Char)
+            {
+                ++Position;
+
+                return true;
+            }
+
+            return false;
+        }
+
+        bool ReadString(std::string& OutValue)
+        {
+            if (!Consume('"'))
+            {
+                return false;
+            }
+
+            while (Position < Json.size())
+            {
+                const auto Char = Json[Position++];
+
+                if (Char == '"')
+                {
+                    return true;
+                }
+
+                if (Char != '\\')
+                {
+                    OutValue.push_back(Char);
+
+                    continue;
+                }
+
+                if (Position >= Json.size())
+                {
+                    return false;
+                }
+
+                switch (const auto Escaped = Json[Position++])
+                {
+                case 'b': OutValue.push_back('\b');
+                    break;
+                case 'f': OutValue.push_back('\f');
+                    break;
+                case 'n': OutValue.push_back('\n');
+                    break;
+                case 'r': OutValue.push_back('\r');
+                    break;
+                case 't': OutValue.push_back('\t');
+                    break;
+                case 'u':
+                    if (!ReadCodePoint(OutValue))
+                    {
+                        return false;
+                    }
+                    break;
+                default: OutValue.push_back(Escaped);
+                    break;
+                }
+            }
+
+            return false;
+        }
+
+        bool ReadHex(uint32_t& OutValue)
+        {
+            if (Position + 4 > Json.size())
+            {
+                return false;
+            }
+
+            OutValue = 0;
+
+            for (auto i = 0; i < 4; ++i)
+            {
+                const auto Char = Json[Position++];
+
+                OutValue <<= 4;
+
+                if (Char >= '0' && Char <= '9')
+                {
+                    OutValue |= Char - '0';
+                }
+                else if (Char >= 'a' && Char <= 'f')
+                {
+                    OutValue |= Char - 'a' + 10;
+                }
+                else if (Char >= 'A' && Char <= 'F')
+                {
+                    OutValue |= Char - 'A' + 10;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool ReadCodePoint(std::string& OutValue)
+        {
+            uint32_t CodePoint = 0;
+
+            if (!ReadHex(CodePoint))
+            {
+                return false;
+            }
+
+            if (CodePoint >= 0xD800 && CodePoint <= 0xDBFF)
+            {
+                uint32_t Low = 0;
+
+                if (!Consume('\\') || !Consume('u') || !ReadHex(Low) || Low < 0xDC00 || Low > 0xDFFF)
+                {
+                    return false;
+                }
+
+                CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+            }
+
+            if (CodePoint < 0x80)
+            {
+                OutValue.push_back(static_cast<char>(CodePoint));
+            }
+            else if (CodePoint < 0x800)
+            {
+                OutValue.push_back(static_cast<char>(0xC0 | CodePoint >> 6));
+
+                OutValue.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+            }
+            else if (CodePoint < 0x10000)
+            {
+                OutValue.push_back(static_cast<char>(0xE0 | CodePoint >> 12));
+
+                OutValue.push_back(static_cast<char>(0x80 | (CodePoint >> 6 & 0x3F)));
+
+                OutValue.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+            }
+            else
+            {
+                OutValue.push_back(static_cast<char>(0xF0 | CodePoint >> 18));
+
+                OutValue.push_back(static_cast<char>(0x80 | (CodePoint >> 12 & 0x3F)));
+
+                OutValue.push_back(static_cast<char>(0x80 | (CodePoint >> 6 & 0x3F)));
+
+                OutValue.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+            }
+
+            return true;
+        }
+
+        /** Numbers, literals, arrays and objects, only their extent matters */
+        bool SkipValue()
+        {
+            auto Depth = 0;
+
+            while (Position < Json.size())
+            {
+                const auto Char = Json[Position];
+
+                if (Char == '"')
+                {
+                    std::string Ignored;
+
+                    if (!ReadString(Ignored))
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                if (Depth == 0 && (Char == ',' || Char == '}'))
+                {
+                    return true;
+                }
+
+                if (Char == '{' || Char == '[')
+                {
+                    ++Depth;
+                }
+                else if (Char == '}' || Char == ']')
+                {
+                    if (--Depth < 0)
+                    {
+                        return false;
+                    }
+                }
+
+                ++Position;
+            }
+
+            return false;
+        }
+
+        const std::string& Json;
+
+        size_t Position = 0;
+    };
+
+    static bool IsPathSegment(const std::string& Value)
+    {
+        return !Value.empty() && Value != "." && Value != ".." && Value.find_first_of(std::string("/\\\0", 3)) ==
+            std::string::npos;
+    }
+}
+
+FManifestCache::FFileStamp FManifestCache::FFileStamp::FromStat(const struct stat& Stat)
+{
+    FFileStamp Stamp;
+
+    Stamp.Size = static_cast<int64_t>(Stat.st_size);
+
+    Stamp.ModifyTime = static_cast<int64_t>(Stat.st_mtim.tv_sec) * 1000000000 + Stat.st_mtim.tv_nsec;
+
+    Stamp.Inode = static_cast<uint64_t>(Stat.st_ino);
+
+    return Stamp;
+}
+
+FManifestCache::FManifestCache(std::string InRoot, const int64_t InMinCompressSize) : Root(std::move(InRoot)),
+    MinCompressSize(InMinCompressSize)
+{
+}
+
+std::shared_ptr<const FManifest> FManifestCache::Find(const std::string& RelativePath)
+{
+    const auto& Path = Root + "/" + RelativePath;
+
+    struct stat Stat{};
+
+    if (stat(Path.c_str(), &Stat) != 0 || !S_ISREG(Stat.st_mode))
+    {
+        std::unique_lock<std::shared_mutex> Lock(Mutex);
+
+        Entries.erase(RelativePath);
+
+        return nullptr;
+    }
+
+    const auto& Stamp = FFileStamp::FromStat(Stat);
+
+    {
+        std::shared_lock<std::shared_mutex> Lock(Mutex);
+
+        const auto Iterator = Entries.find(RelativePath);
+
+        if (Iterator != Entries.end() && Iterator->second.Stamp == Stamp)
+        {
+            return Iterator->second.Manifest;
+        }
+    }
+
+    // Loaded outside the lock, two loops racing on a fresh publish both read it and the later one wins
+    FEntry Entry;
+
+    if (!Load(Path, Entry))
+    {
+        return nullptr;
+    }
+
+    std::unique_lock<std::shared_mutex> Lock(Mutex);
+
+    Entries[RelativePath] = Entry;
+
+    return Entry.Manifest;
+}
+
+bool FManifestCache::ParseRequest(const std::string& Body, std::string& OutVersion, std::string& OutPlatform)
+{
+    OutVersion.clear();
+
+    OutPlatform.clear();
+
+    ManifestCache::FJsonReader Reader(Body);
+
+    return Reader.ReadObject(OutVersion, OutPlatform) && ManifestCache::IsPathSegment(OutVersion) &&
+        ManifestCache::IsPathSegment(OutPlatform);
+}
+
+bool FManifestCache::Load(const std::string& Path, FEntry& OutEntry) const
+{
+    const auto File = open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (File < 0)
+    {
+        return false;
+    }
+
+    struct stat Stat{};
+
+    if (fstat(File, &Stat) != 0 || !S_ISREG(Stat.st_mode))
+    {
+        close(File);
+
+        return false;
+    }
+
+    auto Body = std::make_shared<std::string>();
+
+    Body->resize(static_cast<size_t>(Stat.st_size));
+
+    size_t ReadSize = 0;
+
+    while (ReadSize < Body->size())
+    {
+        const auto Result = read(File, &(*Body)[ReadSize], Body->size() - ReadSize);
+
+        if (Result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (Result <= 0)
+        {
+            break;
+        }
+
+        ReadSize += static_cast<size_t>(Result);
+    }
+
+    close(File);
+
+    // A writer truncating the file under us, the next lookup sees the new stamp and tries again
+    Body->resize(ReadSize);
+
+    auto Manifest = std::make_shared<FManifest>();
+
+    if (static_cast<int64_t>(Body->size()) >= MinCompressSize)
+    {
+        auto GzipBody = std::make_shared<std::string>();
+
+        if (Compression::Gzip(*Body, *GzipBody) && GzipBody->size() < Body->size())
+        {
+            Manifest->GzipBody = GzipBody;
+        }
+    }
+
+    Manifest->Body = Body;
+
+    Manifest->ETag = HttpHeaders::MakeETag(Stat);
+
+    Manifest->LastModified = HttpHeaders::FormatHttpDate(Stat.st_mtim.tv_sec);
+
+    OutEntry.Stamp = FFileStamp::FromStat(Stat);
+
+    OutEntry.Manifest = Manifest;
+
+    return true;
+}
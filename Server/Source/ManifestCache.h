@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <sys/stat.h>
+
+struct FManifest
+{
+    std::shared_ptr<const std::string> Body;
+
+    /** Null when the manifest is too small or does not get smaller */
+    std::shared_ptr<const std::string> GzipBody;
+
+    std::string ETag;
+
+    std::string LastModified;
+};
+
+/**
+ * Keeps every manifest that was asked for in memory, plain and gzipped. Each lookup stats the file and reloads it
+ * once its size, mtime or inode changed, so a publish that rewrites or renames version.json is picked up right away.
+ */
+class FManifestCache
+{
+public:
+    FManifestCache(std::string InRoot, int64_t InMinCompressSize);
+
+    /** RelativePath is below the root, null when the file is missing */
+    std::shared_ptr<const FManifest> Find(const std::string& RelativePath);
+
+    /** Reads {"version", "platform"} from the body WWW/index.php takes, fails on anything that leaves the root */
+    static bool ParseRequest(const std::string& Body, std::string& OutVersion, std::string& OutPlatform);
+
+private:
+    struct FFileStamp
+    {
+        int64_t Size = -1;
+
+        int64_t ModifyTime = 0;
+
+        uint64_t Inode = 0;
+
+        bool operator==(const FFileStamp& Other) const
+        {
+            return Size == Other.Size && ModifyTime == Other.ModifyTime && Inode == Other.Inode;
+        }
+
+        static FFileStamp FromStat(const struct stat& Stat);
+    };
+
+    struct FEntry
+    {
+        FFileStamp Stamp;
+
+        std::shared_ptr<const FManifest> Manifest;
+    };
+
+    bool Load(const std::string& Path, FEntry& OutEntry) const;
+
+    std::string Root;
+
+    int64_t MinCompressSize = 0;
+
+    std::shared_mutex Mutex;
+
+    std::unordered_map<std::string, FEntry> Entries;
+};
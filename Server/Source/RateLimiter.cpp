@@ -0,0 +1,99 @@
+#include "RateLimiter.h"
+#include <algorithm>
+#include <chrono>
+
+double GetMonotonicSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FTokenBucket::FTokenBucket(const int64_t InRate) : Rate(static_cast<double>(InRate))
+{
+    // Sends of about 50 ms keep the shaping smooth without a syscall per packet
+    Quantum = std::min(std::max(Rate / 20.0, 1460.0), 256.0 * 1024.0);
+
+    Burst = std::max(Rate / 4.0, Quantum);
+
+    Tokens = Burst;
+
+    LastRefillTime = GetMonotonicSeconds();
+}
+
+int64_t FTokenBucket::Take(const int64_t Size, const double Now)
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+
+    Refill(Now);
+
+    const auto Wanted = static_cast<double>(Size);
+
+    if (Tokens < std::min(Wanted, Quantum))
+    {
+        return 0;
+    }
+
+    const auto Taken = static_cast<int64_t>(std::min(Wanted, Tokens));
+
+    Tokens -= static_cast<double>(Taken);
+
+    return Taken;
+}
+
+void FTokenBucket::Return(const int64_t Size)
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+
+    Tokens = std::min(Tokens + static_cast<double>(Size), Burst);
+}
+
+double FTokenBucket::GetWaitTime(const double Now)
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+
+    Refill(Now);
+
+    return Tokens >= Quantum ? 0.0 : (Quantum - Tokens) / Rate;
+}
+
+void FTokenBucket::Refill(const double Now)
+{
+    Tokens = std::min(Tokens + (Now - LastRefillTime) * Rate, Burst);
+
+    LastRefillTime = Now;
+}
+
+FRateLimiter::FRateLimiter(const int64_t InRate) : Rate(InRate)
+{
+}
+
+std::shared_ptr<FTokenBucket> FRateLimiter::Acquire(const std::string& Client)
+{
+    if (Rate <= 0)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> Lock(Mutex);
+
+    // Drop the buckets of clients that went away every now and then instead of on each disconnect
+    if (++AcquireNum % 1024 == 0)
+    {
+        for (auto Iterator = Buckets.begin(); Iterator != Buckets.end();)
+        {
+            Iterator = Iterator->second.expired() ? Buckets.erase(Iterator) : std::next(Iterator);
+        }
+    }
+
+    auto& Bucket = Buckets[Client];
+
+    auto Shared = Bucket.lock();
+
+    if (Shared == nullptr)
+    {
+        Shared = std::make_shared<FTokenBucket>(Rate);
+
+        Bucket = Shared;
+    }
+
+    return Shared;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+double GetMonotonicSeconds();
+
+/** Token bucket shared by every connection of one client address */
+class FTokenBucket
+{
+public:
+    explicit FTokenBucket(int64_t InRate);
+
+    /** Takes up to Size bytes, 0 when less than one send quantum is left and the caller should wait */
+    int64_t Take(int64_t Size, double Now);
+
+    /** Gives back what a short write did not use */
+    void Return(int64_t Size);
+
+    /** Seconds until Take hands out at least a quantum again */
+    double GetWaitTime(double Now);
+
+private:
+    void Refill(double Now);
+
+    std::mutex Mutex;
+
+    double Rate = 0.0;
+
+    double Burst = 0.0;
+
+    double Quantum = 0.0;
+
+    double Tokens = 0.0;
+
+    double LastRefillTime = 0.0;
+};
+
+class FRateLimiter
+{
+public:
+    explicit FRateLimiter(int64_t InRate);
+
+    /** Null when shaping is off, buckets live as long as one connection of the client holds them */
+    std::shared_ptr<FTokenBucket> Acquire(const std::string& Client);
+
+private:
+    std::mutex Mutex;
+
+    int64_t Rate = 0;
+
+    std::unordered_map<std::string, std::weak_ptr<FTokenBucket>> Buckets;
+
+    size_t AcquireNum = 0;
+};
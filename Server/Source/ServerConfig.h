@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct FServerConfig
+{
+    /** Same layout as WWW, <Root>/<Version>/<Platform>/<ManifestName> next to the paks */
+    std::string Root = "WWW";
+
+    std::string Host = "0.0.0.0";
+
+    /** 0 picks a free port, the chosen one is printed on start */
+    int32_t Port = 8080;
+
+    /** Event loops, each one accepts on its own SO_REUSEPORT socket */
+    int32_t Threads = 0;
+
+    /** Bytes per second for each client address over all of its connections, 0 is unlimited */
+    int64_t RateLimit = 0;
+
+    std::string ManifestName = "version.json";
+
+    /** Manifests smaller than this are always sent as they are */
+    int64_t MinCompressSize = 256;
+
+    /** Largest single sendfile call, keeps one fast client from starving the others on the same loop */
+    int64_t SendChunkSize = 1024 * 1024;
+
+    double IdleTimeout = 30.0;
+
+    /** Seconds between throughput lines, 0 disables them */
+    double StatsInterval = 0.0;
+
+    bool bVerbose = false;
+};